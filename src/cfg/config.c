@@ -160,6 +160,7 @@ cfg_init(void)
 	cfg.selection_is_primary = 1;
 	cfg.tab_switches_pane = 1;
 	cfg.use_system_calls = 0;
+	cfg.io_threads = 1;
 	cfg.tab_stop = 8;
 	cfg.ruler_format = strdup("%l/%S ");
 	cfg.status_line = strdup("");
@@ -168,6 +169,8 @@ cfg_init(void)
 	cfg.columns = INT_MIN;
 
 	cfg.dot_dirs = DD_NONROOT_PARENT;
+	cfg.dir_load_threads = 1;
+	cfg.dir_size_allocated = 0;
 
 	cfg.filter_inverted_by_default = 1;
 
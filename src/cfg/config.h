@@ -115,6 +115,8 @@ typedef struct config_t
 	int selection_is_primary; /* For yy, dd and DD: act on selection not file. */
 	int tab_switches_pane; /* Whether <tab> is switch pane or history forward. */
 	int use_system_calls; /* Prefer performing operations with system calls. */
+	/* Maximum number of threads that copy files of a directory. */
+	int io_threads;
 	int tab_stop;
 	char *ruler_format;
 	char *status_line;
@@ -122,6 +124,10 @@ typedef struct config_t
 	int columns; /* Terminal width in characters. */
 	/* Controls displaying of dot directories.  Combination of DotDirs flags. */
 	int dot_dirs;
+	/* Maximum number of threads that load meta-data of files in a directory. */
+	int dir_load_threads;
+	/* Whether ga/gA count allocated blocks instead of apparent sizes of files. */
+	int dir_size_allocated;
 	char decorations[FT_COUNT][2]; /* File type specific refixes and suffixes. */
 	int filter_inverted_by_default; /* Default inversion value for :filter. */
 	char *apropos_prg; /* apropos tool calling pattern. */
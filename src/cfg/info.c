@@ -45,6 +45,7 @@
 #include "../bookmarks.h"
 #include "../commands.h"
 #include "../dir_stack.h"
+#include "../dircache.h"
 #include "../filelist.h"
 #include "../filetype.h"
 #include "../fileview.h"
@@ -448,6 +449,8 @@ write_info_file(void)
 	(void)snprintf(info_file, sizeof(info_file), "%s/vifminfo", cfg.config_dir);
 	(void)snprintf(tmp_file, sizeof(tmp_file), "%s_%u", info_file, get_pid());
 
+	dcache_save();
+
 	if(os_access(info_file, R_OK) != 0 || copy_file(info_file, tmp_file) == 0)
 	{
 		update_info_file(tmp_file);
@@ -915,6 +918,9 @@ write_options(FILE *const fp)
 			cfg.filter_inverted_by_default ? "f" : "",
 			cfg.selection_is_primary ? "s" : "",
 			cfg.tab_switches_pane ? "t" : "");
+	fprintf(fp, "=dirloadthreads=%d\n", cfg.dir_load_threads);
+	fprintf(fp, "=dirsizemode=%s\n",
+			cfg.dir_size_allocated ? "allocated" : "apparent");
 	fprintf(fp, "=%sfastrun\n", cfg.fast_run ? "" : "no");
 	if(strcmp(cfg.border_filler, " ") != 0)
 	{
@@ -930,6 +936,7 @@ write_options(FILE *const fp)
 	fprintf(fp, "=%siec\n", cfg.use_iec_prefixes ? "" : "no");
 	fprintf(fp, "=%signorecase\n", cfg.ignore_case ? "" : "no");
 	fprintf(fp, "=%sincsearch\n", cfg.inc_search ? "" : "no");
+	fprintf(fp, "=iothreads=%d\n", cfg.io_threads);
 	fprintf(fp, "=%slaststatus\n", cfg.display_statusline ? "" : "no");
 	fprintf(fp, "=lines=%d\n", cfg.lines);
 	fprintf(fp, "=locateprg=%s\n", escape_spaces(cfg.locate_prg));
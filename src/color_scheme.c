@@ -40,6 +40,7 @@
 #include "utils/fs.h"
 #include "utils/macros.h"
 #include "utils/matcher.h"
+#include "utils/matchers.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/tree.h"
@@ -370,6 +371,7 @@ static void restore_primary_color_scheme(const col_scheme_t *cs);
 static void reset_to_default_color_scheme(col_scheme_t *cs);
 static void free_color_scheme_highlights(col_scheme_t *cs);
 static file_hi_t * clone_color_scheme_highlights(const col_scheme_t *from);
+static matchers_t * index_highlights(const file_hi_t file_hi[], int count);
 static void reset_color_scheme_colors(col_scheme_t *cs);
 static int source_cs(const char name[]);
 static void get_cs_path(const char name[], char buf[], size_t buf_size);
@@ -679,6 +681,7 @@ assign_color_scheme(col_scheme_t *to, const col_scheme_t *from)
 	free_color_scheme_highlights(to);
 	*to = *from;
 	to->file_hi = clone_color_scheme_highlights(from);
+	to->file_hi_index = index_highlights(to->file_hi, to->file_hi_count);
 }
 
 /* Resets color scheme to default builtin values. */
@@ -706,9 +709,11 @@ free_color_scheme_highlights(col_scheme_t *cs)
 	}
 
 	free(cs->file_hi);
+	matchers_free(cs->file_hi_index);
 
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
+	cs->file_hi_index = NULL;
 }
 
 /* Clones filename specific highlight array of the *from color scheme and
@@ -730,6 +735,30 @@ clone_color_scheme_highlights(const col_scheme_t *from)
 	return file_hi;
 }
 
+/* Builds index of count matchers of file_hi array.  Returns the index or NULL
+ * on error. */
+static matchers_t *
+index_highlights(const file_hi_t file_hi[], int count)
+{
+	int i;
+	matchers_t *const ms = matchers_alloc();
+	if(ms == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		if(matchers_add(ms, file_hi[i].matcher) != 0)
+		{
+			matchers_free(ms);
+			return NULL;
+		}
+	}
+
+	return ms;
+}
+
 int
 check_directory_for_color_scheme(int left, const char dir[])
 {
@@ -946,6 +975,16 @@ add_file_hi(struct matcher_t *matcher, const col_attr_t *hi)
 
 	++cs->file_hi_count;
 
+	if(cs->file_hi_index == NULL)
+	{
+		cs->file_hi_index = index_highlights(cs->file_hi, cs->file_hi_count);
+	}
+	else if(matchers_add(cs->file_hi_index, matcher) != 0)
+	{
+		matchers_free(cs->file_hi_index);
+		cs->file_hi_index = NULL;
+	}
+
 	return 0;
 }
 
@@ -961,6 +1000,17 @@ get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
+	if(cs->file_hi_index != NULL)
+	{
+		i = matchers_find(cs->file_hi_index, fname, 0);
+		if(i < 0)
+		{
+			return NULL;
+		}
+		*hi_hint = i;
+		return &cs->file_hi[i].hi;
+	}
+
 	for(i = 0; i < cs->file_hi_count; ++i)
 	{
 		const file_hi_t *const file_hi = &cs->file_hi[i];
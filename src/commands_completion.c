@@ -924,7 +924,8 @@ external_command_exists(const char cmd[])
 
 	if(get_cmd_path(cmd, sizeof(path), path) == 0)
 	{
-		return executable_exists(path);
+		/* Search in PATH has already checked that the command is executable. */
+		return !contains_slash(cmd) || executable_exists(path);
 	}
 	return 0;
 }
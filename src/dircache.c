@@ -0,0 +1,668 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dircache.h"
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+#include <sys/stat.h> /* stat */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fprintf() remove() snprintf() sscanf() */
+#include <stdlib.h> /* calloc() free() qsort() */
+#include <string.h> /* strchr() strcmp() strdup() strlen() strrchr() */
+
+#include "cfg/config.h"
+#include "compat/fs_limits.h"
+#include "compat/os.h"
+#include "compat/reallocarray.h"
+#include "utils/file_streams.h"
+#include "utils/fs.h"
+#include "utils/log.h"
+#include "utils/macros.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "utils/tree.h"
+#include "utils/utils.h"
+#include "status.h"
+
+/* Name of file with persistent part of the cache inside configuration
+ * directory. */
+#define DIRSIZES_FILE "dirsizes"
+
+/* Maximum number of directories stored in the file, the ones that weren't
+ * updated for the longest time are dropped. */
+#define MAX_STORED 10000
+
+/* State of subtree of a persistent entry. */
+typedef enum
+{
+	SUBTREE_UNKNOWN, /* Subtree wasn't compared against file system yet. */
+	SUBTREE_VALID,   /* None of directories of the subtree has changed. */
+	SUBTREE_STALE,   /* Size of the directory is outdated or can't be checked. */
+}
+SubtreeState;
+
+/* Persistent information about a directory. */
+typedef struct
+{
+	char *path;           /* Path to the directory, NULL for free slots. */
+	int allocated;        /* Whether size is in allocated blocks. */
+	du_id_t id;           /* Identity of the directory at calculation time. */
+	uint64_t size;        /* Size of the whole subtree. */
+	size_t nsubdirs;      /* Number of subdirectories at calculation time. */
+	unsigned long stamp;  /* When the entry was updated, for pruning. */
+	int checked;          /* Whether entry was compared against the directory. */
+	int stale;            /* Whether the directory itself has changed. */
+	SubtreeState subtree; /* Whether size of the directory can be used. */
+	size_t nvalid;        /* Number of valid subdirectories, used by checks. */
+}
+entry_t;
+
+static void use_mode(int allocated);
+static int get_config_path(char buf[], size_t buf_len, const char suffix[]);
+static int stamp_cmp(const void *a, const void *b);
+static int depth_cmp(const void *a, const void *b);
+static void check_subtree(const char root[], int allocated);
+static void check_dirs(char *paths[], size_t count, int allocated);
+static size_t list_subtree(const char root[], int allocated, entry_t ***list);
+static void invalidate_parents(const char path[], int allocated);
+static entry_t * find_parent(const char path[], int allocated);
+static int to_parent(char path[]);
+static void load(void);
+static void put(const char path[], int allocated, const du_id_t *id,
+		uint64_t size, size_t nsubdirs, int fresh);
+static int grow(void);
+static entry_t * find(const char path[], int allocated);
+static size_t hash_path(const char path[], int allocated);
+
+/* Protects all state of the unit and in-memory cache in curr_stats. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Hash table of persistent entries. */
+static entry_t *entries;
+/* Capacity of the entries table, power of two. */
+static size_t capacity;
+/* Number of used slots of the entries table. */
+static size_t nused;
+/* Last value assigned to stamp field of an entry. */
+static unsigned long last_stamp;
+/* Whether persistent part was read from the file. */
+static int loaded;
+/* Whether persistent part differs from contents of the file. */
+static int changed;
+/* Value of 'dirsizemode' for which in-memory cache is filled. */
+static int mem_allocated;
+
+int
+dcache_get_size(const char path[], int allocated, uint64_t *size)
+{
+	entry_t *entry;
+	int found;
+
+	if(dcache_get_calculated(path, allocated, size) == 0)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&lock);
+	load();
+	entry = find(path, allocated);
+	if(entry != NULL && entry->subtree == SUBTREE_UNKNOWN)
+	{
+		pthread_mutex_unlock(&lock);
+		/* Only existence of an entry is checked before this point, so that sorting
+		 * and redrawing don't stat() directories of unknown size. */
+		check_subtree(path, allocated);
+		pthread_mutex_lock(&lock);
+		/* The table could have been changed while the lock was released. */
+		entry = find(path, allocated);
+	}
+
+	found = (entry != NULL && entry->subtree == SUBTREE_VALID);
+	if(found)
+	{
+		*size = entry->size;
+	}
+	pthread_mutex_unlock(&lock);
+	return !found;
+}
+
+int
+dcache_get_calculated(const char path[], int allocated, uint64_t *size)
+{
+	int failed;
+
+	pthread_mutex_lock(&lock);
+	use_mode(allocated);
+	failed = (tree_get_data(curr_stats.dirsize_cache, path, size) != 0);
+	pthread_mutex_unlock(&lock);
+
+	return failed;
+}
+
+void
+dcache_put(const char root[], const du_dir_t dirs[], size_t count,
+		int allocated)
+{
+	size_t i;
+
+	pthread_mutex_lock(&lock);
+
+	load();
+	use_mode(allocated);
+
+	for(i = 0U; i < count; ++i)
+	{
+		tree_set_data(curr_stats.dirsize_cache, dirs[i].path, dirs[i].size);
+		if(dirs[i].has_id)
+		{
+			put(dirs[i].path, allocated, &dirs[i].id, dirs[i].size,
+					dirs[i].nsubdirs, 1);
+		}
+	}
+
+	/* Sizes of parents of the root no longer match sizes of their subtrees. */
+	invalidate_parents(root, allocated);
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+dcache_save(void)
+{
+	char file[PATH_MAX];
+	char tmp_file[PATH_MAX];
+	char suffix[32];
+	const entry_t **list;
+	size_t i, count;
+	FILE *fp;
+
+	pthread_mutex_lock(&lock);
+
+	if(!changed)
+	{
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	snprintf(suffix, sizeof(suffix), "_%u", get_pid());
+	if(get_config_path(file, sizeof(file), "") != 0 ||
+			get_config_path(tmp_file, sizeof(tmp_file), suffix) != 0)
+	{
+		LOG_ERROR_MSG("Path to file of directory sizes is too long");
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	list = reallocarray(NULL, MAX(nused, 1U), sizeof(*list));
+	if(list == NULL)
+	{
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	/* Paths with new line characters can't be stored in the file. */
+	count = 0U;
+	for(i = 0U; i < capacity; ++i)
+	{
+		const entry_t *const entry = &entries[i];
+		if(entry->path != NULL && !entry->stale &&
+				entry->subtree != SUBTREE_STALE && strchr(entry->path, '\n') == NULL)
+		{
+			list[count++] = entry;
+		}
+	}
+	qsort(list, count, sizeof(*list), &stamp_cmp);
+
+	fp = os_fopen(tmp_file, "w");
+	if(fp == NULL)
+	{
+		LOG_ERROR_MSG("Can't create temporary file for directory sizes");
+		free(list);
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	/* Entries are written from the oldest one, which is the order in which
+	 * they are stamped on loading. */
+	for(i = (count > MAX_STORED) ? count - MAX_STORED : 0U; i < count; ++i)
+	{
+		fprintf(fp, "%llu %llu %lld %d %lu %llu %s\n",
+				(unsigned long long)list[i]->id.dev,
+				(unsigned long long)list[i]->id.ino, (long long)list[i]->id.mtime,
+				list[i]->allocated, (unsigned long)list[i]->nsubdirs,
+				(unsigned long long)list[i]->size, list[i]->path);
+	}
+	fclose(fp);
+	free(list);
+
+	if(rename_file(tmp_file, file) != 0)
+	{
+		LOG_ERROR_MSG("Can't replace file of directory sizes");
+		(void)remove(tmp_file);
+	}
+	else
+	{
+		changed = 0;
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+dcache_reset(void)
+{
+	size_t i;
+
+	pthread_mutex_lock(&lock);
+	for(i = 0U; i < capacity; ++i)
+	{
+		free(entries[i].path);
+	}
+	free(entries);
+	entries = NULL;
+	capacity = 0U;
+	nused = 0U;
+	loaded = 0;
+	changed = 0;
+	pthread_mutex_unlock(&lock);
+}
+
+int
+dcache_clear(void)
+{
+	int failed;
+
+	pthread_mutex_lock(&lock);
+	tree_free(curr_stats.dirsize_cache);
+	curr_stats.dirsize_cache = tree_create(0, 0);
+	failed = (curr_stats.dirsize_cache == NULL_TREE);
+	pthread_mutex_unlock(&lock);
+
+	return failed;
+}
+
+/* Drops in-memory part of the cache if it was filled for different value of
+ * 'dirsizemode'.  Must be called with the lock held. */
+static void
+use_mode(int allocated)
+{
+	if(mem_allocated != allocated)
+	{
+		tree_free(curr_stats.dirsize_cache);
+		curr_stats.dirsize_cache = tree_create(0, 0);
+		mem_allocated = allocated;
+	}
+}
+
+/* Formats path to the file of persistent part of the cache with the suffix
+ * appended.  Returns zero on success, otherwise non-zero is returned. */
+static int
+get_config_path(char buf[], size_t buf_len, const char suffix[])
+{
+	const int len = snprintf(buf, buf_len, "%s/%s%s", cfg.config_dir,
+			DIRSIZES_FILE, suffix);
+	return (len < 0 || (size_t)len >= buf_len);
+}
+
+/* qsort() comparer that orders pointers to entries by their stamps.  Returns
+ * standard -1, 0, 1 for comparisons. */
+static int
+stamp_cmp(const void *a, const void *b)
+{
+	const entry_t *const x = *(const entry_t *const *)a;
+	const entry_t *const y = *(const entry_t *const *)b;
+	return (x->stamp > y->stamp) - (x->stamp < y->stamp);
+}
+
+/* qsort() comparer that puts pointers to entries of subdirectories before
+ * pointers to entries of their parents.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+depth_cmp(const void *a, const void *b)
+{
+	const size_t x = strlen((*(const entry_t *const *)a)->path);
+	const size_t y = strlen((*(const entry_t *const *)b)->path);
+	return (x < y) - (x > y);
+}
+
+/* Compares persistent entries of the root and its subdirectories against file
+ * system and decides which of them are still valid.  Size of a directory is
+ * valid if neither the directory nor any of its subdirectories has changed and
+ * all of them are stored, which is verified by their number. */
+static void
+check_subtree(const char root[], int allocated)
+{
+	entry_t **list;
+	char **paths;
+	size_t i, count, npaths;
+
+	pthread_mutex_lock(&lock);
+
+	count = list_subtree(root, allocated, &list);
+	paths = reallocarray(NULL, MAX(count, 1U), sizeof(*paths));
+	npaths = 0U;
+	for(i = 0U; i < count && paths != NULL; ++i)
+	{
+		if(!list[i]->checked && (paths[npaths] = strdup(list[i]->path)) != NULL)
+		{
+			++npaths;
+		}
+	}
+	free(list);
+
+	pthread_mutex_unlock(&lock);
+
+	check_dirs(paths, npaths, allocated);
+	free_string_array(paths, npaths);
+
+	pthread_mutex_lock(&lock);
+
+	/* The table could have been changed while the lock was released. */
+	count = list_subtree(root, allocated, &list);
+	qsort(list, count, sizeof(*list), &depth_cmp);
+	for(i = 0U; i < count; ++i)
+	{
+		list[i]->nvalid = 0U;
+	}
+
+	for(i = 0U; i < count; ++i)
+	{
+		entry_t *const entry = list[i];
+		entry_t *parent;
+
+		if(entry->subtree == SUBTREE_UNKNOWN && entry->checked)
+		{
+			const int valid = (!entry->stale && entry->nvalid == entry->nsubdirs);
+			entry->subtree = valid ? SUBTREE_VALID : SUBTREE_STALE;
+			changed |= !valid;
+		}
+
+		if(entry->subtree == SUBTREE_VALID && strcmp(entry->path, root) != 0 &&
+				(parent = find_parent(entry->path, allocated)) != NULL)
+		{
+			++parent->nvalid;
+		}
+	}
+	free(list);
+
+	pthread_mutex_unlock(&lock);
+}
+
+/* Compares persistent entries of directories against the directories. */
+static void
+check_dirs(char *paths[], size_t count, int allocated)
+{
+	size_t i;
+	for(i = 0U; i < count; ++i)
+	{
+		struct stat st;
+		entry_t *entry;
+		const int stat_failed = (os_stat(paths[i], &st) != 0);
+
+		pthread_mutex_lock(&lock);
+		entry = find(paths[i], allocated);
+		if(entry != NULL && !entry->checked)
+		{
+			entry->checked = 1;
+			if(stat_failed || st.st_dev != entry->id.dev ||
+					st.st_ino != entry->id.ino || st.st_mtime != entry->id.mtime)
+			{
+				entry->stale = 1;
+				changed = 1;
+			}
+		}
+		pthread_mutex_unlock(&lock);
+	}
+}
+
+/* Collects entries of the root and of its subdirectories.  Must be called with
+ * the lock held.  Returns number of elements in *list, which should be freed
+ * by the caller. */
+static size_t
+list_subtree(const char root[], int allocated, entry_t ***list)
+{
+	size_t i;
+	size_t count = 0U;
+
+	*list = reallocarray(NULL, MAX(nused, 1U), sizeof(**list));
+	if(*list == NULL)
+	{
+		return 0U;
+	}
+
+	for(i = 0U; i < capacity; ++i)
+	{
+		entry_t *const entry = &entries[i];
+		if(entry->path != NULL && entry->allocated == allocated &&
+				path_starts_with(entry->path, root))
+		{
+			(*list)[count++] = entry;
+		}
+	}
+	return count;
+}
+
+/* Marks entries of all parents of the directory as outdated.  Must be called
+ * with the lock held. */
+static void
+invalidate_parents(const char path[], int allocated)
+{
+	char parent[PATH_MAX];
+
+	copy_str(parent, sizeof(parent), path);
+	while(to_parent(parent) == 0)
+	{
+		entry_t *const entry = find(parent, allocated);
+		if(entry != NULL && entry->subtree != SUBTREE_STALE)
+		{
+			entry->subtree = SUBTREE_STALE;
+			changed = 1;
+		}
+	}
+}
+
+/* Looks up entry of parent directory of the path.  Must be called with the
+ * lock held.  Returns the entry or NULL if there is none. */
+static entry_t *
+find_parent(const char path[], int allocated)
+{
+	char parent[PATH_MAX];
+
+	copy_str(parent, sizeof(parent), path);
+	return (to_parent(parent) == 0) ? find(parent, allocated) : NULL;
+}
+
+/* Replaces path with path to its parent directory.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+to_parent(char path[])
+{
+	char *const slash = strrchr(path, '/');
+	if(slash == NULL || slash[1] == '\0')
+	{
+		return 1;
+	}
+
+	slash[(slash == path) ? 1 : 0] = '\0';
+	return 0;
+}
+
+/* Reads persistent part of the cache from its file if it wasn't read yet.
+ * Must be called with the lock held. */
+static void
+load(void)
+{
+	char file[PATH_MAX];
+	char *line = NULL;
+	FILE *fp;
+
+	if(loaded)
+	{
+		return;
+	}
+	loaded = 1;
+
+	if(get_config_path(file, sizeof(file), "") != 0)
+	{
+		return;
+	}
+
+	fp = os_fopen(file, "r");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	while((line = read_line(fp, line)) != NULL)
+	{
+		unsigned long long dev, ino, size;
+		unsigned long nsubdirs;
+		long long mtime;
+		int allocated;
+		int path_pos;
+
+		if(sscanf(line, "%llu %llu %lld %d %lu %llu %n", &dev, &ino, &mtime,
+					&allocated, &nsubdirs, &size, &path_pos) == 6 &&
+				line[path_pos] != '\0')
+		{
+			const du_id_t id = { (dev_t)dev, (ino_t)ino, (time_t)mtime };
+			put(line + path_pos, allocated != 0, &id, size, nsubdirs, 0);
+		}
+	}
+
+	fclose(fp);
+	changed = 0;
+}
+
+/* Adds or updates persistent entry.  fresh specifies whether size was just
+ * calculated and thus is known to match the directory.  Must be called with the
+ * lock held. */
+static void
+put(const char path[], int allocated, const du_id_t *id, uint64_t size,
+		size_t nsubdirs, int fresh)
+{
+	entry_t *entry = find(path, allocated);
+	if(entry == NULL)
+	{
+		size_t i;
+		char *const path_copy = strdup(path);
+		if(path_copy == NULL)
+		{
+			return;
+		}
+
+		if((nused + 1U)*4U > capacity*3U && grow() != 0)
+		{
+			free(path_copy);
+			return;
+		}
+
+		i = hash_path(path, allocated) & (capacity - 1U);
+		while(entries[i].path != NULL)
+		{
+			i = (i + 1U) & (capacity - 1U);
+		}
+		entry = &entries[i];
+		entry->path = path_copy;
+		entry->allocated = allocated;
+		++nused;
+	}
+
+	entry->id = *id;
+	entry->size = size;
+	entry->nsubdirs = nsubdirs;
+	entry->stamp = ++last_stamp;
+	entry->checked = fresh;
+	entry->stale = 0;
+	entry->subtree = fresh ? SUBTREE_VALID : SUBTREE_UNKNOWN;
+	changed = 1;
+}
+
+/* Doubles capacity of the entries table.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+grow(void)
+{
+	size_t i;
+	const size_t new_capacity = (capacity == 0U) ? 64U : capacity*2U;
+	entry_t *const new_entries = calloc(new_capacity, sizeof(*new_entries));
+	if(new_entries == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < capacity; ++i)
+	{
+		if(entries[i].path != NULL)
+		{
+			size_t j = hash_path(entries[i].path, entries[i].allocated)
+			         & (new_capacity - 1U);
+			while(new_entries[j].path != NULL)
+			{
+				j = (j + 1U) & (new_capacity - 1U);
+			}
+			new_entries[j] = entries[i];
+		}
+	}
+
+	free(entries);
+	entries = new_entries;
+	capacity = new_capacity;
+	return 0;
+}
+
+/* Looks up entry by path to directory and by 'dirsizemode'.  Returns the entry
+ * or NULL if there is none. */
+static entry_t *
+find(const char path[], int allocated)
+{
+	size_t i;
+
+	if(nused == 0U)
+	{
+		return NULL;
+	}
+
+	i = hash_path(path, allocated) & (capacity - 1U);
+	while(entries[i].path != NULL)
+	{
+		if(entries[i].allocated == allocated && strcmp(entries[i].path, path) == 0)
+		{
+			return &entries[i];
+		}
+		i = (i + 1U) & (capacity - 1U);
+	}
+	return NULL;
+}
+
+/* Computes hash of path and size mode.  Returns the hash. */
+static size_t
+hash_path(const char path[], int allocated)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t)allocated;
+	while(*path != '\0')
+	{
+		hash = (hash ^ (unsigned char)*path++)*0x100000001b3ULL;
+	}
+	return (size_t)(hash ^ (hash >> 29));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,68 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__DIRCACHE_H__
+#define VIFM__DIRCACHE_H__
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+#include "utils/du.h"
+
+/* dircache - sizes of directories calculated by ga/gA
+ *
+ * Sizes of all calculated directories are kept in memory by path.  They are
+ * also stored on disk (in dirsizes file of configuration directory) by path
+ * and value of 'dirsizemode' along with device, inode number, modification
+ * time and number of subdirectories of directories.  Stored size of a
+ * directory is displayed only if none of directories of its subtree has
+ * changed, which is checked once per session on first use.  Modification time
+ * of a directory doesn't change when files inside of it grow, so stored sizes
+ * are never used to skip calculation.  All functions are thread-safe. */
+
+/* Retrieves known size of a directory for the 'dirsizemode' either calculated
+ * in this session or stored in persistent part of the cache.  Returns zero on
+ * success and sets *size, otherwise non-zero is returned. */
+int dcache_get_size(const char path[], int allocated, uint64_t *size);
+
+/* Retrieves size of a directory for the 'dirsizemode' calculated in this
+ * session.  Returns zero on success and sets *size, otherwise non-zero is
+ * returned. */
+int dcache_get_calculated(const char path[], int allocated, uint64_t *size);
+
+/* Remembers sizes of count directories calculated for the 'dirsizemode'.  The
+ * root is the directory for which calculation was started, stored sizes of its
+ * parents become outdated. */
+void dcache_put(const char root[], const du_dir_t dirs[], size_t count,
+		int allocated);
+
+/* Writes persistent part of the cache to its file if it was changed. */
+void dcache_save(void);
+
+/* Forgets persistent part of the cache, so that it's read from file on next
+ * use. */
+void dcache_reset(void);
+
+/* Forgets sizes calculated in this session.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int dcache_clear(void);
+
+#endif /* VIFM__DIRCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
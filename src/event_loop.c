@@ -33,6 +33,7 @@
 #include "compat/curses.h"
 #include "engine/keys.h"
 #include "engine/mode.h"
+#include "menus/menus.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/modes.h"
 #include "ui/statusbar.h"
@@ -45,6 +46,7 @@
 #include "filelist.h"
 #include "fileview.h"
 #include "ipc.h"
+#include "quickview.h"
 #include "status.h"
 
 static int ensure_term_is_ready(void);
@@ -326,6 +328,10 @@ process_scheduled_updates(void)
 
 	ui_stat_job_bar_check_for_updates();
 
+	qv_check_for_updates();
+
+	menus_check_for_updates();
+
 	if(vle_mode_get_primary() != MENU_MODE)
 	{
 		need_redraw += (process_scheduled_updates_of_view(curr_view) != 0);
@@ -27,8 +27,11 @@
 #endif
 
 #include <curses.h>
+#include <pthread.h> /* pthread_* */
 
-#include <sys/stat.h> /* stat */
+#include <sys/stat.h> /* fstatat() stat */
+#include <fcntl.h> /* AT_FDCWD AT_SYMLINK_NOFOLLOW O_CLOEXEC O_DIRECTORY O_RDONLY
+                      open() */
 #include <unistd.h> /* close() fork() pipe() */
 
 #include <assert.h> /* assert() */
@@ -48,6 +51,7 @@
 #include "engine/mode.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/modes.h"
+#include "ui/cancellation.h"
 #include "ui/statusbar.h"
 #include "ui/statusline.h"
 #include "ui/ui.h"
@@ -58,12 +62,13 @@
 #include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
+#include "utils/str_pool.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
-#include "utils/tree.h"
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
+#include "dircache.h"
 #include "fileview.h"
 #include "filtering.h"
 #include "fuse.h"
@@ -74,6 +79,13 @@
 #include "status.h"
 #include "types.h"
 
+/* Number of entries claimed by a meta-data loading thread at a time. */
+#define LOAD_CHUNK_SIZE 256
+
+/* Maximum number of new files which are inserted into sorted list one by one on
+ * incremental reload.  If there are more of them, the whole list is sorted. */
+#define PATCH_INSERT_LIMIT 16
+
 /* Custom argument for is_in_list() function. */
 typedef struct
 {
@@ -82,6 +94,54 @@ typedef struct
 }
 list_t;
 
+/* Custom argument for enum_dir_content() callbacks that fill file list. */
+typedef struct
+{
+	FileView *view;  /* View whose file list is being filled. */
+	int interactive; /* Whether to report progress and accept cancellation. */
+}
+enum_state_t;
+
+#ifndef _WIN32
+
+/* State shared among threads that load meta-data of file list entries. */
+typedef struct
+{
+	dir_entry_t *entries; /* Entries to be filled. */
+	int *errors;          /* Per-entry errno values of failed stat calls. */
+	int count;            /* Number of entries. */
+	int next;             /* Index of the first entry not claimed by a worker. */
+	int dir_fd;           /* Descriptor of directory that contains the files. */
+	int cancellable;      /* Whether loading can be cancelled. */
+	pthread_mutex_t lock; /* Protects next field. */
+}
+load_state_t;
+
+/* Custom argument for file_changed() callback. */
+typedef struct
+{
+	FileView *view; /* View which is checked for changes. */
+	int updated;    /* Whether any of entries was updated. */
+}
+changes_state_t;
+
+/* State of incremental reload of a file list. */
+typedef struct
+{
+	FileView *view; /* View whose list is being updated. */
+	trie_t names;   /* Maps names of files to their entries. */
+	char *kept;     /* Marks entries that are still up to date. */
+	char **added;   /* Names of new or replaced files. */
+	int nadded;     /* Number of elements in the added array. */
+	int *refresh;   /* Indexes of kept entries that need to be re-read. */
+	int nrefresh;   /* Number of elements in the refresh array. */
+	int resort;     /* Whether order of kept entries might be broken. */
+	int restat;     /* Whether all kept entries need to be re-read. */
+}
+patch_state_t;
+
+#endif
+
 /* Type of predicate functions to reason about entries.  Should return non-zero
  * if particular property holds and zero otherwise. */
 typedef int (*predicate_func)(const dir_entry_t *entry);
@@ -102,6 +162,8 @@ static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const struct dirent *d);
+static void fill_dir_entry_by_stat(dir_entry_t *entry, const struct stat *s);
+static void fill_link_target_mode(dir_entry_t *entry);
 static int data_is_dir_entry(const struct dirent *d);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
@@ -116,9 +178,33 @@ static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 static void update_entries_data(FileView *view);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
-static int update_dir_list(FileView *view, int reload);
+static int update_dir_list(FileView *view, int reload, int interactive);
+#ifndef _WIN32
+static int can_patch_dir_list(FileView *view, int *resort);
+static int patch_dir_list(FileView *view, int resort, int notified);
+static int patch_entry(const char name[], const void *data, void *param);
+static void refresh_entries(patch_state_t *state);
+static void update_entry(patch_state_t *state, dir_entry_t *entry,
+		const dir_entry_t *fresh);
+static void insert_entry(FileView *view, const dir_entry_t *entry, int *pos);
+static void update_parent_dir(FileView *view, int *pos);
+#endif
+static int enum_dir_entries(FileView *view, int interactive);
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
+#ifndef _WIN32
+static int add_unfilled_entry_to_view(const char name[], const void *data,
+		void *param);
+static void fill_entries_in_parallel(FileView *view, int cancellable);
+static void fill_entries_serially(FileView *view);
+static int load_entries(const char dir[], dir_entry_t entries[], int count,
+		int cancellable, int errors[]);
+static void * load_entries_worker(void *arg);
+static int claim_load_chunk(load_state_t *state);
+#endif
+static int make_dir_entry(enum_state_t *state, const char name[],
+		const void *data, dir_entry_t **entry);
+static int file_is_listed(FileView *view, const char name[], const void *data);
 static void sort_dir_list(int msg, FileView *view);
 static void merge_lists(FileView *view, dir_entry_t *entries, int len);
 static void merge_entries(dir_entry_t *new, const dir_entry_t *prev);
@@ -126,6 +212,13 @@ static int correct_pos(FileView *view, int pos, int dist, int closes);
 static int rescue_from_empty_filelist(FileView *view);
 static void init_dir_entry(FileView *view, dir_entry_t *entry,
 		const char name[]);
+#ifndef _WIN32
+static void file_changed(const char name[], void *arg);
+#endif
+static void start_names_pool(FileView *view);
+static void set_entry_name(FileView *view, dir_entry_t *entry,
+		const char name[]);
+static void release_entry_name(dir_entry_t *entry);
 static void free_dir_entries(FileView *view, dir_entry_t **entries, int *count);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
 static int file_can_be_displayed(const char directory[], const char filename[]);
@@ -262,6 +355,38 @@ get_current_entry(FileView *view)
 	return &view->dir_entry[view->list_pos];
 }
 
+void
+flist_fill_entry(dir_entry_t *entry)
+{
+#ifndef _WIN32
+	char full_path[PATH_MAX];
+	struct stat s;
+
+	if(!entry->unfilled)
+	{
+		return;
+	}
+	entry->unfilled = 0;
+
+	/* The entry keeps type taken from directory entry if this fails. */
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	if(os_lstat(full_path, &s) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", full_path);
+		return;
+	}
+
+	fill_dir_entry_by_stat(entry, &s);
+	entry->hi_num = -1;
+
+	if(entry->type == FT_LINK && get_symlink_type(full_path) != SLT_SLOW &&
+			os_stat(full_path, &s) == 0)
+	{
+		entry->mode = s.st_mode;
+	}
+#endif
+}
+
 char *
 get_current_file_name(FileView *view)
 {
@@ -1179,6 +1304,7 @@ flist_custom_start(FileView *view, const char title[])
 	free_dir_entries(view, &view->custom.entries, &view->custom.entry_count);
 	(void)replace_string(&view->custom.title, title);
 
+	start_names_pool(view);
 	view->custom.paths_cache = trie_create();
 }
 
@@ -1244,39 +1370,56 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->type = get_type_from_mode(s.st_mode);
-	if(entry->type == FT_UNK)
-	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
-	}
+	entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+	fill_dir_entry_by_stat(entry, &s);
 	if(entry->type == FT_UNK)
 	{
 		LOG_ERROR_MSG("Can't determine type of \"%s\"", path);
 		return 1;
 	}
 
-	entry->size = (uintmax_t)s.st_size;
-	entry->mode = s.st_mode;
-	entry->uid = s.st_uid;
-	entry->gid = s.st_gid;
-	entry->mtime = s.st_mtime;
-	entry->atime = s.st_atime;
-	entry->ctime = s.st_ctime;
-
 	if(entry->type == FT_LINK)
 	{
-		/* Query mode of symbolic link target. */
+		fill_link_target_mode(entry);
+	}
 
-		struct stat s;
+	return 0;
+}
 
-		const SymLinkType symlink_type = get_symlink_type(entry->name);
-		if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
-		{
-			entry->mode = s.st_mode;
-		}
+/* Fills fields of the entry from stat information.  Type of the entry is
+ * changed only if it can be derived from the mode, so previous value serves as
+ * a fallback. */
+static void
+fill_dir_entry_by_stat(dir_entry_t *entry, const struct stat *s)
+{
+	const FileType type = get_type_from_mode(s->st_mode);
+	if(type != FT_UNK)
+	{
+		entry->type = type;
 	}
 
-	return 0;
+	entry->size = (uintmax_t)s->st_size;
+	entry->mode = s->st_mode;
+	entry->uid = s->st_uid;
+	entry->gid = s->st_gid;
+	entry->mtime = s->st_mtime;
+	entry->atime = s->st_atime;
+	entry->ctime = s->st_ctime;
+	entry->inode = s->st_ino;
+}
+
+/* Queries mode of symbolic link target and puts it into the entry.  Leaves mode
+ * of the link itself if target is on a slow file system or is inaccessible. */
+static void
+fill_link_target_mode(dir_entry_t *entry)
+{
+	struct stat s;
+
+	const SymLinkType symlink_type = get_symlink_type(entry->name);
+	if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
+	{
+		entry->mode = s.st_mode;
+	}
 }
 
 /* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
@@ -1576,6 +1719,15 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(FileView *view, int reload)
 {
+	int interactive = 0;
+	int incremental = 0;
+	int resort = 0;
+	int failed;
+	/* Only reloads requested by file monitor can rely on its notifications. */
+	const int notified = reload && view->notified_reload != 0 &&
+		view->notified_reload == view->postponed_reload;
+
+	view->notified_reload = 0;
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
@@ -1595,6 +1747,11 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 0;
 	}
 
+#ifndef _WIN32
+	/* Pending notifications must be processed before the monitor is updated. */
+	incremental = reload && can_patch_dir_list(view, &resort);
+#endif
+
 	if(update_dir_mtime(view) != 0 && !is_unc_root(view->curr_dir))
 	{
 		LOG_SERROR_MSG(errno, "Can't get directory mtime \"%s\"", view->curr_dir);
@@ -1606,6 +1763,7 @@ populate_dir_list_internal(FileView *view, int reload)
 		if(!vle_mode_is(CMDLINE_MODE))
 		{
 			ui_sb_quick_msgf("%s", "Reading directory...");
+			interactive = 1;
 		}
 	}
 
@@ -1621,7 +1779,18 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 1;
 	}
 
-	if(update_dir_list(view, reload) != 0)
+#ifndef _WIN32
+	if(incremental)
+	{
+		failed = patch_dir_list(view, resort, notified);
+	}
+	else
+#endif
+	{
+		failed = update_dir_list(view, reload, interactive);
+	}
+
+	if(failed)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
@@ -1633,6 +1802,12 @@ populate_dir_list_internal(FileView *view, int reload)
 		clean_status_bar();
 	}
 
+	if(interactive && ui_cancellation_requested())
+	{
+		status_bar_message("Reading directory was cancelled, list is incomplete");
+		curr_stats.save_msg = 1;
+	}
+
 	view->column_count = calculate_columns_count(view);
 
 	/* If reloading the same directory don't jump to history position.  Stay at
@@ -1756,11 +1931,13 @@ free_view_entries(FileView *view)
 	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Updates file list with files from current directory.  Interactive loading
+ * displays progress and can be cancelled, which leaves list incomplete.
+ * Returns zero on success, otherwise non-zero is returned. */
 static int
-update_dir_list(FileView *view, int reload)
+update_dir_list(FileView *view, int reload, int interactive)
 {
+	int failed;
 	dir_entry_t *prev_dir_entries = NULL;
 	int prev_list_rows = 0;
 
@@ -1776,6 +1953,10 @@ update_dir_list(FileView *view, int reload)
 		free_view_entries(view);
 	}
 
+	/* Names of previous entries stay valid until they are freed, after which
+	 * their memory is returned in big blocks. */
+	start_names_pool(view);
+
 	view->matches = 0;
 	view->selected_files = 0;
 
@@ -1788,7 +1969,21 @@ update_dir_list(FileView *view, int reload)
 	}
 #endif
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if(interactive)
+	{
+		show_progress("", 0);
+		ui_cancellation_reset();
+		ui_cancellation_enable();
+	}
+
+	failed = enum_dir_entries(view, interactive);
+
+	if(interactive)
+	{
+		ui_cancellation_disable();
+	}
+
+	if(failed)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
@@ -1814,125 +2009,822 @@ update_dir_list(FileView *view, int reload)
 	return 0;
 }
 
-/* enum_dir_content() callback that appends files to file list.  Returns zero on
- * success or non-zero to indicate failure and stop enumeration. */
+#ifndef _WIN32
+
+/* Checks whether list of the view can be updated by applying changes to it
+ * instead of loading it anew, which requires the list to be tracked by file
+ * monitor of the view.  Processes pending notifications, so it should be called
+ * before the monitor is updated.  Sets *resort if entries were updated.
+ * Returns non-zero if so, otherwise zero is returned. */
 static int
-add_file_entry_to_view(const char name[], const void *data, void *param)
+can_patch_dir_list(FileView *view, int *resort)
 {
-	FileView *const view = param;
-	dir_entry_t *entry;
+	changes_state_t state = { .view = view, .updated = 0 };
+	int i;
 
-	/* Always ignore the "." and ".." directories. */
-	if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+	if(view->list_rows == 0 || !filemon_tracks_files(&view->mon, view->curr_dir))
 	{
 		return 0;
 	}
 
-	if(view->hide_dot && name[0] == '.')
+	for(i = 0; i < view->list_rows; ++i)
 	{
-		++view->filtered;
-		return 0;
+		if(view->dir_entry[i].origin != &view->curr_dir[0])
+		{
+			return 0;
+		}
 	}
 
-	if(!file_is_visible(view, name, data_is_dir_entry(data)))
+	if(filemon_check(&view->mon, view->curr_dir, &file_changed, &state) < 0)
 	{
-		++view->filtered;
 		return 0;
 	}
 
-	entry = alloc_dir_entry(&view->dir_entry, view->list_rows);
-	if(entry == NULL)
+	*resort = state.updated;
+
+	/* Some of notifications might have been lost. */
+	return filemon_tracks_files(&view->mon, view->curr_dir);
+}
+
+/* Updates file list of the view by comparing it with current directory.  resort
+ * flag specifies whether order of entries should be restored.  notified flag
+ * specifies that the update is caused by file monitor, in which case only new
+ * and replaced files are queried, otherwise all files are.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+patch_dir_list(FileView *view, int resort, int notified)
+{
+	patch_state_t state = {
+		.view = view, .resort = resort, .restat = !notified
+	};
+	char cur_name[NAME_MAX];
+	int i, j;
+	int pos;
+	int failed;
+
+	state.names = trie_create();
+	state.kept = calloc(view->list_rows, 1);
+	state.refresh = reallocarray(NULL, MAX(view->list_rows, 1),
+			sizeof(*state.refresh));
+	if(state.names == NULL_TRIE || state.kept == NULL || state.refresh == NULL)
 	{
-		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		trie_free(state.names);
+		free(state.kept);
+		free(state.refresh);
+		return update_dir_list(view, 1, 0);
+	}
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+		if(!is_parent_dir(entry->name))
+		{
+			(void)trie_set(state.names, entry->name, entry);
+		}
+	}
+
+	failed = enum_dir_content(view->curr_dir, &patch_entry, &state);
+	trie_free(state.names);
+	if(failed)
+	{
+		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
+		free(state.kept);
+		free(state.refresh);
+		free_string_array(state.added, state.nadded);
 		return 1;
 	}
 
-	init_dir_entry(view, entry, name);
+	refresh_entries(&state);
+	free(state.refresh);
 
-	if(fill_dir_entry(entry, entry->name, data) == 0)
+	/* Drop entries of removed and replaced files, cursor moves to the next file
+	 * unless current file is back. */
+	cur_name[0] = '\0';
+	pos = -1;
+	j = 0;
+	for(i = 0; i < view->list_rows; ++i)
 	{
-		++view->list_rows;
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		if(i == view->list_pos)
+		{
+			pos = j;
+		}
+
+		if(!state.kept[i] && !is_parent_dir(entry->name))
+		{
+			if(i == view->list_pos)
+			{
+				copy_str(cur_name, sizeof(cur_name), entry->name);
+			}
+			free_dir_entry(view, entry);
+			continue;
+		}
+
+		if(i != j)
+		{
+			view->dir_entry[j] = *entry;
+		}
+		++j;
 	}
-	else
+	view->list_rows = j;
+	free(state.kept);
+
+	if(pos < 0)
 	{
-		free_dir_entry(view, entry);
+		pos = j;
 	}
 
-	return 0;
-}
+	if(state.nadded > PATCH_INSERT_LIMIT)
+	{
+		state.resort = 1;
+	}
 
-void
-resort_dir_list(int msg, FileView *view)
-{
-	char full_path[PATH_MAX];
-	const int top_delta = view->list_pos - view->top_line;
-	if(view->list_pos < view->list_rows)
+	for(i = 0; i < state.nadded; ++i)
 	{
-		get_current_full_path(view, sizeof(full_path), full_path);
+		dir_entry_t entry;
+		dir_entry_t *slot;
+		int entry_pos;
+
+		init_dir_entry(view, &entry, state.added[i]);
+		slot = alloc_dir_entry(&view->dir_entry, view->list_rows);
+		if(slot == NULL || fill_dir_entry_by_path(&entry, entry.name) != 0)
+		{
+			free_dir_entry(view, &entry);
+			continue;
+		}
+
+		if(state.resort)
+		{
+			*slot = entry;
+			entry_pos = view->list_rows++;
+		}
+		else
+		{
+			insert_entry(view, &entry, &entry_pos);
+			if(entry_pos <= pos)
+			{
+				++pos;
+			}
+		}
+
+		if(stroscmp(entry.name, cur_name) == 0)
+		{
+			pos = entry_pos;
+		}
 	}
+	free_string_array(state.added, state.nadded);
 
-	sort_dir_list(msg, view);
+	update_parent_dir(view, &pos);
 
-	if(view->list_pos < view->list_rows)
+	view->list_pos = MAX(0, MIN(pos, view->list_rows - 1));
+	if(state.resort)
 	{
-		flist_goto_by_path(view, full_path);
-		view->top_line = view->list_pos - top_delta;
+		resort_dir_list(0, view);
+	}
+
+	/* Same reset of state as for entries that are reloaded from scratch. */
+	view->matches = 0;
+	view->selected_files = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+		entry->search_match = 0;
+		entry->marked = 0;
+		view->selected_files += (entry->selected != 0);
 	}
+
+	return 0;
 }
 
-/* Resorts view without reloading it.  msg parameter controls whether to show
- * "Sorting..." statusbar message. */
-static void
-sort_dir_list(int msg, FileView *view)
+/* enum_dir_content() callback that marks entries of unchanged files as kept and
+ * remembers names of other files.  Returns zero on success or non-zero to
+ * indicate failure and stop enumeration. */
+static int
+patch_entry(const char name[], const void *data, void *param)
 {
-	if(msg && view->list_rows > 2048 && !vle_mode_is(CMDLINE_MODE))
+	patch_state_t *const state = param;
+	const struct dirent *const d = data;
+	void *value;
+	int nadded;
+
+	if(!file_is_listed(state->view, name, data))
 	{
-		ui_sb_quick_msgf("%s", "Sorting directory...");
+		return 0;
 	}
 
-	sort_view(view);
+	if(trie_get(state->names, name, &value) == 0)
+	{
+		dir_entry_t *const entry = value;
+		if(entry->inode == d->d_ino)
+		{
+			/* Changes of directories and symbolic links aren't reported by monitor
+			 * of their parent directory. */
+			const int index = entry - state->view->dir_entry;
+			state->kept[index] = 1;
+			if(state->restat || entry->type == FT_DIR || entry->type == FT_LINK)
+			{
+				state->refresh[state->nrefresh++] = index;
+			}
+			return 0;
+		}
+	}
 
-	if(msg && !vle_mode_is(CMDLINE_MODE))
+	nadded = add_to_string_array(&state->added, state->nadded, 1, name);
+	if(nadded == state->nadded)
 	{
-		clean_status_bar();
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 1;
 	}
+	state->nadded = nadded;
+	return 0;
 }
 
-/* Merges elements from previous list into the new one. */
+/* Re-reads meta-data of entries listed for refreshing and drops entries of
+ * files that can't be queried.  Meta-data is loaded by several threads if
+ * 'dirloadthreads' allows it. */
 static void
-merge_lists(FileView *view, dir_entry_t *entries, int len)
+refresh_entries(patch_state_t *state)
 {
+	FileView *const view = state->view;
+	dir_entry_t *fresh;
+	int *errors;
 	int i;
-	int closes_dist;
-	const int prev_pos = view->list_pos;
-	trie_t prev_names = trie_create();
 
-	for(i = 0; i < len; ++i)
+	if(state->nrefresh == 0)
 	{
-		const int code = trie_set(prev_names, entries[i].name, &entries[i]);
-		assert(code == 0 && "Duplicated file names in the list?");
-		(void)code;
-
-		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+		return;
 	}
 
-	closes_dist = INT_MIN;
-	for(i = 0; i < view->list_rows; ++i)
+	fresh = reallocarray(NULL, state->nrefresh, sizeof(*fresh));
+	errors = calloc(state->nrefresh, sizeof(*errors));
+	if(fresh == NULL || errors == NULL)
 	{
-		int dist;
-		void *data;
-		dir_entry_t *const entry = &view->dir_entry[i];
-		if(trie_get(prev_names, entry->name, &data) != 0)
+		free(fresh);
+		free(errors);
+
+		for(i = 0; i < state->nrefresh; ++i)
 		{
-			continue;
+			const int index = state->refresh[i];
+			dir_entry_t entry = view->dir_entry[index];
+			if(fill_dir_entry_by_path(&entry, entry.name) != 0)
+			{
+				state->kept[index] = 0;
+				continue;
+			}
+			update_entry(state, &view->dir_entry[index], &entry);
 		}
+		return;
+	}
 
-		/* Transfer information from previous entry to the new one. */
-		merge_entries(entry, data);
+	/* Copies share names with the entries, only meta-data is updated. */
+	for(i = 0; i < state->nrefresh; ++i)
+	{
+		fresh[i] = view->dir_entry[state->refresh[i]];
+	}
 
-		/* Update number of selected files (should have been zeroed beforehand). */
-		view->selected_files += (entry->selected != 0);
+	(void)load_entries(view->curr_dir, fresh, state->nrefresh, 0, errors);
+
+	for(i = 0; i < state->nrefresh; ++i)
+	{
+		const int index = state->refresh[i];
+
+		if(errors[i] != 0)
+		{
+			LOG_SERROR_MSG(errors[i], "Can't lstat() \"%s\"", fresh[i].name);
+			state->kept[index] = 0;
+			continue;
+		}
+
+		if(fresh[i].type == FT_LINK)
+		{
+			fill_link_target_mode(&fresh[i]);
+		}
+		update_entry(state, &view->dir_entry[index], &fresh[i]);
+	}
+
+	free(errors);
+	free(fresh);
+}
+
+/* Replaces meta-data of the entry with a re-read one and checks whether the
+ * change might break order of entries. */
+static void
+update_entry(patch_state_t *state, dir_entry_t *entry, const dir_entry_t *fresh)
+{
+	const dir_entry_t prev = *entry;
+	*entry = *fresh;
+
+	if(is_directory_entry(entry))
+	{
+		/* Size of directory might have been replaced with a calculated one, use
+		 * the same value to compare against. */
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		(void)dcache_get_size(full_path, cfg.dir_size_allocated, &entry->size);
+	}
+
+	if(entry->type != prev.type)
+	{
+		entry->hi_num = -1;
+	}
+
+	if(entry->type != prev.type || entry->size != prev.size ||
+			entry->mtime != prev.mtime || entry->atime != prev.atime ||
+			entry->ctime != prev.ctime || entry->mode != prev.mode ||
+			entry->uid != prev.uid || entry->gid != prev.gid)
+	{
+		state->resort = 1;
+	}
+}
+
+/* Inserts the entry at its sorted position in the list of the view, which must
+ * have room for one more entry.  *pos is set to the position of the entry. */
+static void
+insert_entry(FileView *view, const dir_entry_t *entry, int *pos)
+{
+	dir_entry_t copy = *entry;
+	const int at = sort_find_pos(view, &copy);
+
+	memmove(&view->dir_entry[at + 1], &view->dir_entry[at],
+			sizeof(*view->dir_entry)*(view->list_rows - at));
+	view->dir_entry[at] = copy;
+	++view->list_rows;
+
+	*pos = at;
+}
+
+/* Adds or removes ".." entry according to configuration and number of other
+ * entries.  *pos is cursor position to be corrected. */
+static void
+update_parent_dir(FileView *view, int *pos)
+{
+	const int parent_pos = find_file_pos_in_list(view, "..");
+	const int has_parent = (parent_pos >= 0);
+	const int need_parent = cfg_parent_dir_is_visible(is_root_dir(view->curr_dir))
+	                     || view->list_rows == has_parent;
+
+	if(has_parent && !need_parent)
+	{
+		free_dir_entry(view, &view->dir_entry[parent_pos]);
+		memmove(&view->dir_entry[parent_pos], &view->dir_entry[parent_pos + 1],
+				sizeof(*view->dir_entry)*(view->list_rows - parent_pos - 1));
+		--view->list_rows;
+
+		if(parent_pos < *pos)
+		{
+			--*pos;
+		}
+	}
+	else if(!has_parent && need_parent)
+	{
+		const int count = view->list_rows;
+		add_parent_dir(view);
+		if(view->list_rows != count)
+		{
+			int entry_pos;
+			--view->list_rows;
+			insert_entry(view, &view->dir_entry[view->list_rows], &entry_pos);
+			if(entry_pos <= *pos)
+			{
+				++*pos;
+			}
+		}
+	}
+}
+
+#endif
+
+/* Appends files of current directory of the view to its file list.  Meta-data
+ * is loaded by several threads if 'dirloadthreads' allows it.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+enum_dir_entries(FileView *view, int interactive)
+{
+	enum_state_t state = { .view = view, .interactive = interactive };
+
+#ifndef _WIN32
+	if(cfg.dir_load_threads > 1)
+	{
+		if(enum_dir_content(view->curr_dir, &add_unfilled_entry_to_view,
+					&state) != 0)
+		{
+			return 1;
+		}
+
+		fill_entries_in_parallel(view, interactive);
+		return 0;
+	}
+#endif
+
+	return enum_dir_content(view->curr_dir, &add_file_entry_to_view, &state);
+}
+
+/* enum_dir_content() callback that appends files to file list.  Returns zero on
+ * success or non-zero to indicate failure and stop enumeration. */
+static int
+add_file_entry_to_view(const char name[], const void *data, void *param)
+{
+	enum_state_t *const state = param;
+	FileView *const view = state->view;
+	dir_entry_t *entry;
+
+	if(make_dir_entry(state, name, data, &entry) != 0)
+	{
+		return 1;
+	}
+
+	if(entry == NULL)
+	{
+		return 0;
+	}
+
+	if(fill_dir_entry(entry, entry->name, data) == 0)
+	{
+		++view->list_rows;
+	}
+	else
+	{
+		free_dir_entry(view, entry);
+	}
+
+	return 0;
+}
+
+#ifndef _WIN32
+
+/* enum_dir_content() callback that appends files to file list leaving their
+ * meta-data (except for type provided by the directory entry) unfilled.
+ * Returns zero on success or non-zero to indicate failure and stop
+ * enumeration. */
+static int
+add_unfilled_entry_to_view(const char name[], const void *data, void *param)
+{
+	enum_state_t *const state = param;
+	FileView *const view = state->view;
+	dir_entry_t *entry;
+
+	if(make_dir_entry(state, name, data, &entry) != 0)
+	{
+		return 1;
+	}
+
+	if(entry != NULL)
+	{
+		entry->type = type_from_dir_entry(data);
+		++view->list_rows;
+	}
+
+	return 0;
+}
+
+/* Loads meta-data of all entries of the view using up to 'dirloadthreads'
+ * threads and removes entries for which it can't be obtained.  Entries skipped
+ * because of cancellation are kept and their meta-data is loaded on first
+ * use. */
+static void
+fill_entries_in_parallel(FileView *view, int cancellable)
+{
+	int *errors;
+	int nloaded;
+	int i, j;
+
+	if(view->list_rows == 0)
+	{
+		return;
+	}
+
+	errors = calloc(view->list_rows, sizeof(*errors));
+	if(errors == NULL)
+	{
+		fill_entries_serially(view);
+		return;
+	}
+
+	nloaded = load_entries(view->curr_dir, view->dir_entry, view->list_rows,
+			cancellable, errors);
+
+	/* Resolution of symbolic links isn't thread-safe (e.g., it checks mount
+	 * points), so do it here along with dropping failed entries. */
+	j = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		/* Entries are claimed sequentially, so the rest of them was skipped on
+		 * cancellation. */
+		if(i >= nloaded)
+		{
+			entry->unfilled = 1;
+		}
+		else if(errors[i] != 0)
+		{
+			LOG_SERROR_MSG(errors[i], "Can't lstat() \"%s\"", entry->name);
+			free_dir_entry(view, entry);
+			continue;
+		}
+		else if(entry->type == FT_UNK)
+		{
+			LOG_ERROR_MSG("Can't determine type of \"%s\"", entry->name);
+			free_dir_entry(view, entry);
+			continue;
+		}
+		else if(entry->type == FT_LINK)
+		{
+			fill_link_target_mode(entry);
+		}
+
+		if(i != j)
+		{
+			view->dir_entry[j] = *entry;
+		}
+		++j;
+	}
+	view->list_rows = j;
+
+	free(errors);
+}
+
+/* Loads meta-data of all entries of the view one by one and removes entries for
+ * which it can't be obtained.  This is a fallback for the case when parallel
+ * loading can't be set up. */
+static void
+fill_entries_serially(FileView *view)
+{
+	int i, j;
+
+	j = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+		char full_path[PATH_MAX];
+
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		if(fill_dir_entry(entry, full_path, NULL) != 0)
+		{
+			free_dir_entry(view, entry);
+			continue;
+		}
+
+		if(i != j)
+		{
+			view->dir_entry[j] = *entry;
+		}
+		++j;
+	}
+	view->list_rows = j;
+}
+
+/* Queries meta-data of count entries of files of the directory using up to
+ * 'dirloadthreads' threads.  Values of errno for failed queries are stored in
+ * the errors array.  Symbolic links aren't resolved.  Returns number of leading
+ * entries that were processed, which is less than count only on
+ * cancellation. */
+static int
+load_entries(const char dir[], dir_entry_t entries[], int count,
+		int cancellable, int errors[])
+{
+	load_state_t state = {
+		.entries = entries,
+		.errors = errors,
+		.count = count,
+		.next = 0,
+		.cancellable = cancellable,
+	};
+	pthread_t *threads;
+	int nthreads, nstarted;
+	int i;
+
+	/* Stat'ing relative to the directory descriptor saves path resolution for
+	 * every file.  The process is in the directory anyway, so fallback to
+	 * current directory is fine. */
+	state.dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(state.dir_fd == -1)
+	{
+		state.dir_fd = AT_FDCWD;
+	}
+
+	pthread_mutex_init(&state.lock, NULL);
+
+	/* Calling thread is a worker as well. */
+	nthreads = MIN(cfg.dir_load_threads,
+			DIV_ROUND_UP(state.count, LOAD_CHUNK_SIZE)) - 1;
+	threads = reallocarray(NULL, MAX(nthreads, 1), sizeof(*threads));
+	nstarted = 0;
+	while(threads != NULL && nstarted < nthreads)
+	{
+		if(pthread_create(&threads[nstarted], NULL, &load_entries_worker,
+					&state) != 0)
+		{
+			break;
+		}
+		++nstarted;
+	}
+
+	(void)load_entries_worker(&state);
+
+	for(i = 0; i < nstarted; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+	free(threads);
+
+	pthread_mutex_destroy(&state.lock);
+	if(state.dir_fd != AT_FDCWD)
+	{
+		close(state.dir_fd);
+	}
+
+	return state.next;
+}
+
+/* Entry point of a thread that loads meta-data of entries.  Returns NULL. */
+static void *
+load_entries_worker(void *arg)
+{
+	load_state_t *const state = arg;
+
+	int first;
+	while((first = claim_load_chunk(state)) < state->count)
+	{
+		const int last = MIN(first + LOAD_CHUNK_SIZE, state->count);
+		int i;
+		for(i = first; i < last; ++i)
+		{
+			dir_entry_t *const entry = &state->entries[i];
+			struct stat s;
+
+			if(fstatat(state->dir_fd, entry->name, &s, AT_SYMLINK_NOFOLLOW) != 0)
+			{
+				state->errors[i] = errno;
+				continue;
+			}
+
+			fill_dir_entry_by_stat(entry, &s);
+		}
+	}
+
+	return NULL;
+}
+
+/* Reserves next chunk of entries for a worker.  Returns index of the first
+ * entry of the chunk, which is past the end if there is nothing left or loading
+ * was cancelled. */
+static int
+claim_load_chunk(load_state_t *state)
+{
+	int first;
+
+	if(state->cancellable && ui_cancellation_requested())
+	{
+		return state->count;
+	}
+
+	pthread_mutex_lock(&state->lock);
+	first = state->next;
+	state->next = MIN(first + LOAD_CHUNK_SIZE, state->count);
+	pthread_mutex_unlock(&state->lock);
+
+	return first;
+}
+
+#endif
+
+/* Allocates and initializes new entry of the file list unless the file should
+ * be skipped, in which case *entry is set to NULL.  Returns non-zero on memory
+ * allocation error or cancellation, otherwise zero is returned. */
+static int
+make_dir_entry(enum_state_t *state, const char name[], const void *data,
+		dir_entry_t **entry)
+{
+	FileView *const view = state->view;
+
+	*entry = NULL;
+
+	if(state->interactive)
+	{
+		if(ui_cancellation_requested())
+		{
+			return 1;
+		}
+		show_progress("Reading directory", 1000);
+	}
+
+	if(!file_is_listed(view, name, data))
+	{
+		return 0;
+	}
+
+	*entry = alloc_dir_entry(&view->dir_entry, view->list_rows);
+	if(*entry == NULL)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 1;
+	}
+
+	init_dir_entry(view, *entry, name);
+	return 0;
+}
+
+/* Checks whether file should be present in the list of the view.  Counts files
+ * that are filtered out.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+file_is_listed(FileView *view, const char name[], const void *data)
+{
+	/* Always ignore the "." and ".." directories. */
+	if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+	{
+		return 0;
+	}
+
+	if(view->hide_dot && name[0] == '.')
+	{
+		++view->filtered;
+		return 0;
+	}
+
+	if(!file_is_visible(view, name, data_is_dir_entry(data)))
+	{
+		++view->filtered;
+		return 0;
+	}
+
+	return 1;
+}
+
+void
+resort_dir_list(int msg, FileView *view)
+{
+	char full_path[PATH_MAX];
+	const int top_delta = view->list_pos - view->top_line;
+	if(view->list_pos < view->list_rows)
+	{
+		get_current_full_path(view, sizeof(full_path), full_path);
+	}
+
+	sort_dir_list(msg, view);
+
+	if(view->list_pos < view->list_rows)
+	{
+		flist_goto_by_path(view, full_path);
+		view->top_line = view->list_pos - top_delta;
+	}
+}
+
+/* Resorts view without reloading it.  msg parameter controls whether to show
+ * "Sorting..." statusbar message. */
+static void
+sort_dir_list(int msg, FileView *view)
+{
+	if(msg && view->list_rows > 2048 && !vle_mode_is(CMDLINE_MODE))
+	{
+		ui_sb_quick_msgf("%s", "Sorting directory...");
+	}
+
+	sort_view(view);
+
+	if(msg && !vle_mode_is(CMDLINE_MODE))
+	{
+		clean_status_bar();
+	}
+}
+
+/* Merges elements from previous list into the new one. */
+static void
+merge_lists(FileView *view, dir_entry_t *entries, int len)
+{
+	int i;
+	int closes_dist;
+	const int prev_pos = view->list_pos;
+	trie_t prev_names = trie_create();
+
+	for(i = 0; i < len; ++i)
+	{
+		const int code = trie_set(prev_names, entries[i].name, &entries[i]);
+		assert(code == 0 && "Duplicated file names in the list?");
+		(void)code;
+
+		/* We won't use the name later, so free some memory. */
+		release_entry_name(&entries[i]);
+	}
+
+	closes_dist = INT_MIN;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		int dist;
+		void *data;
+		dir_entry_t *const entry = &view->dir_entry[i];
+		if(trie_get(prev_names, entry->name, &data) != 0)
+		{
+			continue;
+		}
+
+		/* Transfer information from previous entry to the new one. */
+		merge_entries(entry, data);
+
+		/* Update number of selected files (should have been zeroed beforehand). */
+		view->selected_files += (entry->selected != 0);
 
 		/* Update cursor position in a smart way. */
 		dist = (dir_entry_t*)data - entries - prev_pos;
@@ -2048,7 +2940,7 @@ add_parent_dir(FileView *view)
 static void
 init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	set_entry_name(view, entry, name);
 	entry->origin = &view->curr_dir[0];
 
 	entry->size = 0ULL;
@@ -2056,6 +2948,7 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 	entry->uid = (uid_t)-1;
 	entry->gid = (gid_t)-1;
 	entry->mode = (mode_t)0;
+	entry->inode = (ino_t)0;
 #else
 	entry->attrs = 0;
 #endif
@@ -2072,6 +2965,7 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 	entry->was_selected = 0;
 	entry->search_match = 0;
 	entry->marked = 0;
+	entry->unfilled = 0;
 
 	entry->list_num = -1;
 }
@@ -2095,7 +2989,7 @@ replace_dir_entries(FileView *view, dir_entry_t **entries, int *count,
 	{
 		dir_entry_t *const entry = &new[i];
 
-		entry->name = strdup(entry->name);
+		set_entry_name(view, entry, entry->name);
 		entry->origin = strdup(entry->origin);
 
 		if(entry->name == NULL || entry->origin == NULL)
@@ -2127,11 +3021,69 @@ free_dir_entries(FileView *view, dir_entry_t **entries, int *count)
 	*count = 0;
 }
 
+/* Replaces names pool of the view with a new one.  Doesn't invalidate names
+ * allocated from the previous pool. */
+static void
+start_names_pool(FileView *view)
+{
+	str_pool_free(view->names_pool);
+	view->names_pool = str_pool_create();
+}
+
+/* Sets name of the entry to a copy of the name without freeing previous value.
+ * The copy is allocated from names pool of the view when possible. */
+static void
+set_entry_name(FileView *view, dir_entry_t *entry, const char name[])
+{
+	if(view->names_pool == NULL)
+	{
+		view->names_pool = str_pool_create();
+	}
+
+	entry->name = (view->names_pool == NULL)
+	            ? NULL
+	            : str_pool_dup(view->names_pool, name);
+	entry->pooled_name = (entry->name != NULL);
+	if(entry->name == NULL)
+	{
+		entry->name = strdup(name);
+	}
+}
+
+/* Frees name of the entry and sets it to NULL. */
+static void
+release_entry_name(dir_entry_t *entry)
+{
+	if(entry->pooled_name)
+	{
+		str_pool_release(entry->name);
+		entry->pooled_name = 0;
+	}
+	else
+	{
+		free(entry->name);
+	}
+	entry->name = NULL;
+}
+
+int
+rename_dir_entry(dir_entry_t *entry, const char name[])
+{
+	char *const copy = strdup(name);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	release_entry_name(entry);
+	entry->name = copy;
+	return 0;
+}
+
 void
 free_dir_entry(const FileView *view, dir_entry_t *entry)
 {
-	free(entry->name);
-	entry->name = NULL;
+	release_entry_name(entry);
 
 	if(entry->origin != &view->curr_dir[0])
 	{
@@ -2183,9 +3135,19 @@ check_if_filelist_have_changed(FileView *view)
 
 #ifndef _WIN32
 	{
-		filemon_t mon;
-		failed = filemon_from_file(view->curr_dir, &mon) != 0;
-		changed = !failed && !filemon_equal(&mon, &view->mon);
+		changes_state_t state = { .view = view, .updated = 0 };
+		const int r = filemon_check(&view->mon, view->curr_dir, &file_changed,
+				&state);
+		failed = r < 0;
+		changed = r > 0;
+
+		/* Sizes and times might affect order of files, but there is no need to
+		 * sort the list if it's going to be reloaded anyway. */
+		if(state.updated && !failed && !changed)
+		{
+			resort_dir_list(0, view);
+			ui_view_schedule_redraw(view);
+		}
 	}
 #else
 	{
@@ -2214,9 +3176,51 @@ check_if_filelist_have_changed(FileView *view)
 	if(changed)
 	{
 		ui_view_schedule_reload(view);
+		view->notified_reload = view->postponed_reload;
 	}
 }
 
+#ifndef _WIN32
+
+/* filemon_check() callback that updates information about a file which
+ * changed without affecting the list of files. */
+static void
+file_changed(const char name[], void *arg)
+{
+	changes_state_t *const state = arg;
+	FileView *const view = state->view;
+	char full_path[PATH_MAX];
+	dir_entry_t *entry;
+	FileType type;
+
+	const int pos = find_file_pos_in_list(view, name);
+	if(pos < 0)
+	{
+		/* The file is filtered out. */
+		return;
+	}
+
+	entry = &view->dir_entry[pos];
+	type = entry->type;
+
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	if(fill_dir_entry_by_path(entry, full_path) != 0)
+	{
+		/* The file is probably gone, which will be detected by checking the list
+		 * of files. */
+		return;
+	}
+
+	if(entry->type != type)
+	{
+		entry->hi_num = -1;
+	}
+
+	state->updated = 1;
+}
+
+#endif
+
 int
 cd_is_possible(const char *path)
 {
@@ -2508,7 +3512,8 @@ get_file_size_by_entry(const FileView *view, size_t pos)
 	{
 		char full_path[PATH_MAX];
 		get_full_path_of(entry, sizeof(full_path), full_path);
-		tree_get_data(curr_stats.dirsize_cache, full_path, &size);
+		(void)dcache_get_size(full_path, cfg.dir_size_allocated,
+				&size);
 	}
 
 	return (size == 0) ? entry->size : size;
@@ -200,6 +200,9 @@ char * get_current_file_name(FileView *view);
 /* Gets current entry of the view.  Returns the entry or NULL if view doesn't
  * contain any. */
 dir_entry_t * get_current_entry(FileView *view);
+/* Loads meta-data of the entry if it was skipped on loading the list because
+ * of cancellation. */
+void flist_fill_entry(dir_entry_t *entry);
 /* Checks whether content in the current directory of the view changed and
  * reloads the view if so. */
 void check_if_filelist_have_changed(FileView *view);
@@ -273,6 +276,10 @@ int add_dir_entry(dir_entry_t **list, size_t *list_size,
 		const dir_entry_t *entry);
 /* Frees single directory entry. */
 void free_dir_entry(const FileView *view, dir_entry_t *entry);
+
+/* Replaces name of the entry with a copy of the name.  Returns zero on success,
+ * otherwise non-zero is returned and the entry is left unchanged. */
+int rename_dir_entry(dir_entry_t *entry, const char name[]);
 /* Adds parent directory entry (..) to filelist. */
 void add_parent_dir(FileView *view);
 /* Loads list of paths (absolute or relative to the path) into custom view.
@@ -56,16 +56,17 @@
 #ifdef _WIN32
 #include "utils/env.h"
 #endif
+#include "utils/du.h"
 #include "utils/fs.h"
 #include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
-#include "utils/tree.h"
 #include "utils/test_helpers.h"
 #include "utils/utils.h"
 #include "background.h"
 #include "commands_completion.h"
+#include "dircache.h"
 #include "filelist.h"
 #include "fileview.h"
 #include "ops.h"
@@ -119,6 +120,9 @@ typedef struct
 	int dialog;
 
 	int width; /* Maximum reached width of the dialog. */
+
+	/* Number of updates while totals were being calculated. */
+	int counting_updates;
 }
 progress_data_t;
 
@@ -144,6 +148,14 @@ typedef struct
 }
 dir_size_args_t;
 
+/* Parameter of callbacks used by calculate_dir_size(). */
+typedef struct
+{
+	const char *root; /* Directory whose size is calculated. */
+	int allocated;    /* Value of 'dirsizemode'. */
+}
+dir_size_cb_arg_t;
+
 static void io_progress_changed(const io_progress_t *const state);
 static int calc_io_progress(const io_progress_t *const state, int *skip);
 static void io_progress_fg(const io_progress_t *const state, int progress);
@@ -235,7 +247,8 @@ static void update_dir_entry_size(const FileView *view, int index, int force);
 static void start_dir_size_calc(const char path[], int force);
 static void dir_size_bg(bg_op_t *bg_op, void *arg);
 static void dir_size(char path[], int force);
-static void set_dir_size(const char path[], uint64_t size);
+static int lookup_dir_size(const char path[], uint64_t *size, void *arg);
+static void publish_dir_sizes(const du_dir_t dirs[], size_t count, void *arg);
 static void redraw_after_path_change(FileView *view, const char path[]);
 
 /* Temporary storage for extension of file being renamed in name-only mode. */
@@ -300,7 +313,7 @@ io_progress_changed(const io_progress_t *const state)
 
 	/* Do nothing if progress change is small, but force update on stage
 	 * change or redraw request. */
-	if(progress == pdata->last_progress &&
+	if(progress >= 0 && progress == pdata->last_progress &&
 			state->stage == pdata->last_stage && !redraw)
 	{
 		return;
@@ -342,6 +355,15 @@ calc_io_progress(const io_progress_t *const state, int *skip)
 	{
 		return estim->total_items/IO_PRECISION;
 	}
+	else if(estim->counting)
+	{
+		/* Totals are still growing, so percentage would be misleading. */
+		if(++pdata->counting_updates%IO_PRECISION != 0)
+		{
+			*skip = 1;
+		}
+		return -1;
+	}
 	else if(estim->total_bytes == 0)
 	{
 		return 0;
@@ -513,7 +535,7 @@ io_progress_bg(const io_progress_t *const state, int progress)
 	progress_data_t *const pdata = estim->param;
 	bg_op_t *const bg_op = pdata->bg_op;
 
-	bg_op->progress = progress/IO_PRECISION;
+	bg_op->progress = (progress < 0) ? -1 : progress/IO_PRECISION;
 	bg_op_changed(bg_op);
 }
 
@@ -889,9 +911,8 @@ rename_file_cb(const char new_name[])
 	}
 
 	/* Rename file in internal structures for correct positioning of cursor after
-	 * reloading, as cursor will be positioned on the file with the same name.
-	 * TODO: maybe create a function in ui or filelist to do this. */
-	(void)replace_string(&entry->name, new);
+	 * reloading, as cursor will be positioned on the file with the same name. */
+	(void)rename_dir_entry(entry, new);
 
 	ui_view_schedule_reload(curr_view);
 }
@@ -1078,7 +1099,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 				 * positioning of cursor after reloading, as cursor will be positioned
 				 * on the file with the same name.  For custom views rename to prevent
 				 * files from disappearing. */
-				(void)replace_string(&entry->name, new_name);
+				(void)rename_dir_entry(entry, new_name);
 
 				if(flist_custom_active(view))
 				{
@@ -1086,7 +1107,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 							view->custom.entry_count, path);
 					if(entry != NULL)
 					{
-						(void)replace_string(&entry->name, new_name);
+						(void)rename_dir_entry(entry, new_name);
 					}
 				}
 			}
@@ -2971,7 +2992,7 @@ fixup_entry_after_rename(FileView *view, dir_entry_t *entry,
 		/* Rename file in internal structures for correct positioning of cursor
 		 * after reloading, as cursor will be positioned on the file with the same
 		 * name. */
-		(void)replace_string(&entry->name, new_fname);
+		(void)rename_dir_entry(entry, new_fname);
 	}
 }
 
@@ -3531,6 +3552,7 @@ alloc_progress_data(int bg, void *info)
 	pdata->last_stage = (IoPs)-1;
 	pdata->dialog = 0;
 	pdata->width = 0;
+	pdata->counting_updates = 0;
 
 	return pdata;
 }
@@ -4117,62 +4139,34 @@ dir_size(char path[], int force)
 uint64_t
 calculate_dir_size(const char path[], int force_update)
 {
-	DIR* dir;
-	struct dirent* dentry;
-	const char* slash = "";
-	uint64_t size;
-
-	dir = os_opendir(path);
-	if(dir == NULL)
-	{
-		return 0;
-	}
-
-	if(!ends_with_slash(path))
-	{
-		slash = "/";
-	}
-
-	size = 0;
-	while((dentry = os_readdir(dir)) != NULL)
-	{
-		char buf[PATH_MAX];
-
-		if(is_builtin_dir(dentry->d_name))
-		{
-			continue;
-		}
-
-		snprintf(buf, sizeof(buf), "%s%s%s", path, slash, dentry->d_name);
-		if(is_dir_entry(buf, dentry))
-		{
-			uint64_t dir_size = 0;
-			if(tree_get_data(curr_stats.dirsize_cache, buf, &dir_size) != 0
-					|| force_update)
-				dir_size = calculate_dir_size(buf, force_update);
-			size += dir_size;
-		}
-		else
-		{
-			size += get_file_size(buf);
-		}
-	}
+	dir_size_cb_arg_t arg = { .root = path, .allocated = cfg.dir_size_allocated };
+	/* Forced update recalculates everything. */
+	const du_params_t params = {
+		.nthreads = 0,
+		.allocated = arg.allocated,
+		.lookup = force_update ? NULL : &lookup_dir_size,
+		.publish = &publish_dir_sizes,
+		.arg = &arg,
+	};
 
-	os_closedir(dir);
+	return du_calculate(path, &params);
+}
 
-	set_dir_size(path, size);
-	return size;
+/* Looks up size of a directory calculated in this session.  Returns non-zero
+ * and sets *size if it's known, otherwise zero is returned. */
+static int
+lookup_dir_size(const char path[], uint64_t *size, void *arg)
+{
+	const dir_size_cb_arg_t *const cb_arg = arg;
+	return dcache_get_calculated(path, cb_arg->allocated, size) == 0;
 }
 
-/* Updates cached directory size in a thread-safe way. */
+/* Puts calculated directory sizes into the cache. */
 static void
-set_dir_size(const char path[], uint64_t size)
+publish_dir_sizes(const du_dir_t dirs[], size_t count, void *arg)
 {
-	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-
-	pthread_mutex_lock(&mutex);
-	tree_set_data(curr_stats.dirsize_cache, path, size);
-	pthread_mutex_unlock(&mutex);
+	const dir_size_cb_arg_t *const cb_arg = arg;
+	dcache_put(cb_arg->root, dirs, count, cb_arg->allocated);
 }
 
 /* Schedules view redraw in case path change might have affected it. */
@@ -29,6 +29,7 @@
 #include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "utils/matcher.h"
+#include "utils/matchers.h"
 #include "utils/str.h"
 #include "utils/utils.h"
 
@@ -70,6 +71,8 @@ static void free_assoc_record(assoc_record_t *record);
 static void free_assoc(assoc_t *assoc);
 static void safe_free(char **adr);
 static int is_assoc_record_empty(const assoc_record_t *record);
+static int find_matching(const assoc_list_t *assoc_list, const char file[],
+		int from);
 
 void
 ft_init(external_command_exists_t ece_func)
@@ -96,16 +99,11 @@ find_existing_cmd(const assoc_list_t *record_list, const char file[])
 {
 	int i;
 
-	for(i = 0; i < record_list->count; ++i)
+	for(i = 0; (i = find_matching(record_list, file, i)) >= 0; ++i)
 	{
 		assoc_record_t prog;
 		assoc_t *const assoc = &record_list->list[i];
 
-		if(!matcher_matches(assoc->matcher, file))
-		{
-			continue;
-		}
-
 		prog = find_existing_cmd_record(&assoc->records);
 		if(!is_assoc_record_empty(&prog))
 		{
@@ -279,13 +277,9 @@ clone_all_matching_records(const char file[], const assoc_list_t *record_list)
 	int i;
 	assoc_records_t result = {};
 
-	for(i = 0; i < record_list->count; ++i)
+	for(i = 0; (i = find_matching(record_list, file, i)) >= 0; ++i)
 	{
-		assoc_t *const assoc = &record_list->list[i];
-		if(matcher_matches(assoc->matcher, file))
-		{
-			ft_assoc_record_add_all(&result, &assoc->records);
-		}
+		ft_assoc_record_add_all(&result, &record_list->list[i].records);
 	}
 
 	return result;
@@ -334,6 +328,19 @@ add_assoc(assoc_list_t *assoc_list, assoc_t assoc)
 	assoc_list->list = p;
 	assoc_list->list[assoc_list->count] = assoc;
 	assoc_list->count++;
+
+	if(assoc_list->index == NULL && assoc_list->count == 1)
+	{
+		assoc_list->index = matchers_alloc();
+	}
+	if(assoc_list->index != NULL &&
+			matchers_add(assoc_list->index, assoc.matcher) != 0)
+	{
+		/* Index that misses an association is of no use, fall back to checking
+		 * associations one by one. */
+		matchers_free(assoc_list->index);
+		assoc_list->index = NULL;
+	}
 }
 
 void
@@ -383,6 +390,9 @@ reset_list_head(assoc_list_t *assoc_list)
 	free(assoc_list->list);
 	assoc_list->list = NULL;
 	assoc_list->count = 0;
+
+	matchers_free(assoc_list->index);
+	assoc_list->index = NULL;
 }
 
 static void
@@ -480,5 +490,28 @@ is_assoc_record_empty(const assoc_record_t *record)
 	return record->command == NULL && record->description == NULL;
 }
 
+/* Finds the first association of the list starting with the one at index from
+ * which pattern matches the file.  Returns index of the association or -1 if
+ * there is no match. */
+static int
+find_matching(const assoc_list_t *assoc_list, const char file[], int from)
+{
+	int i;
+
+	if(assoc_list->index != NULL)
+	{
+		return matchers_find(assoc_list->index, file, from);
+	}
+
+	for(i = from; i < assoc_list->count; ++i)
+	{
+		if(matcher_matches(assoc_list->list[i].matcher, file))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
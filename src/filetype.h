@@ -62,6 +62,8 @@ typedef struct
 {
 	assoc_t *list;
 	int count;
+	/* Index of matchers of the list for faster lookup or NULL. */
+	struct matchers_t *index;
 }
 assoc_list_t;
 
@@ -176,6 +176,7 @@ fview_view_reset(FileView *view)
 
 	view->postponed_redraw = 0;
 	view->postponed_reload = 0;
+	view->notified_reload = 0;
 }
 
 void
@@ -238,6 +239,13 @@ draw_dir_list_only(FileView *view)
 
 	ui_view_erase(view);
 
+	/* Meta-data of files is needed for highlighting and columns. */
+	for(x = top; x < view->list_rows && (size_t)(x - top) < view->window_cells;
+			++x)
+	{
+		flist_fill_entry(&view->dir_entry[x]);
+	}
+
 	cell = 0U;
 	coll_pad = (view->ls_view && cfg.filelist_col_padding) ? 1 : 0;
 	for(x = top; x < view->list_rows; ++x)
@@ -20,7 +20,9 @@
 #include "filtering.h"
 
 #include <assert.h> /* assert() */
-#include <string.h> /* strdup() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strcmp() strdup() */
 
 #include "cfg/config.h"
 #include "compat/reallocarray.h"
@@ -37,6 +39,13 @@ static int get_unfiltered_pos(const FileView *const view, int pos);
 static int load_unfiltered_list(FileView *const view);
 static void store_local_filter_position(FileView *const view, int pos);
 static void update_filtering_lists(FileView *view, int add, int clear);
+static void narrow_filtering_lists(FileView *view);
+static struct filter_level_t * get_filter_level(FileView *view);
+static int fill_filter_level(FileView *view, struct filter_level_t *level,
+		const struct filter_level_t *prev);
+static int entry_passes_local_filter(FileView *view,
+		const dir_entry_t *entry);
+static void free_filter_levels(FileView *view);
 static void ensure_filtered_list_not_empty(FileView *view,
 		dir_entry_t *parent_entry);
 static int extract_previously_selected_pos(FileView *const view);
@@ -45,6 +54,16 @@ static int find_nearest_neighour(const FileView *const view);
 static void local_filter_finish(FileView *view);
 static void append_slash(const char name[], char buf[], size_t buf_size);
 
+/* Result of filtering unfiltered list by one of values of local filter. */
+struct filter_level_t
+{
+	char *value;          /* Value of the filter. */
+	int cflags;           /* Compilation flags of the filter. */
+	int *matches;         /* Positions of matched entries in unfiltered list. */
+	size_t match_count;   /* Number of elements in the matches array. */
+	size_t checked_count; /* Number of leading unfiltered entries processed. */
+};
+
 void
 filters_view_reset(FileView *view)
 {
@@ -278,7 +297,7 @@ local_filter_set(FileView *view, const char filter[])
 	(void)filter_change(&view->local_filter.filter, filter,
 			!regexp_should_ignore_case(filter));
 
-	update_filtering_lists(view, 1, 0);
+	narrow_filtering_lists(view);
 }
 
 /* Gets position of an item in dir_entry list at position pos in the unfiltered
@@ -423,6 +442,175 @@ update_filtering_lists(FileView *view, int add, int clear)
 	}
 }
 
+/* Fills dir_entry list with entries of the unfiltered list that match local
+ * filter.  Reuses results of filtering by previous values of the filter when
+ * current value refines one of them or is equal to it. */
+static void
+narrow_filtering_lists(FileView *view)
+{
+	size_t i;
+	dir_entry_t *list;
+	size_t list_size = 0U;
+	dir_entry_t *parent_entry = NULL;
+	const struct filter_level_t *const level = get_filter_level(view);
+
+	if(level == NULL)
+	{
+		update_filtering_lists(view, 1, 0);
+		return;
+	}
+
+	list = reallocarray(view->dir_entry, level->match_count + 1,
+			sizeof(*view->dir_entry));
+	if(list == NULL)
+	{
+		update_filtering_lists(view, 1, 0);
+		return;
+	}
+	view->dir_entry = list;
+
+	for(i = 0U; i < level->match_count; ++i)
+	{
+		dir_entry_t *const entry =
+			&view->local_filter.unfiltered[level->matches[i]];
+		if(is_parent_dir(entry->name))
+		{
+			parent_entry = entry;
+			if(!cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)))
+			{
+				continue;
+			}
+		}
+		list[list_size++] = *entry;
+	}
+
+	view->list_rows = list_size;
+	view->filtered = view->local_filter.prefiltered_count
+	               + view->local_filter.unfiltered_count - list_size;
+	ensure_filtered_list_not_empty(view, parent_entry);
+}
+
+/* Retrieves result of filtering by current value of local filter computing it
+ * if necessary.  Levels that can't be narrowed to the current value are
+ * dropped.  Returns the level or NULL on error. */
+static struct filter_level_t *
+get_filter_level(FileView *view)
+{
+	const filter_t *const filter = &view->local_filter.filter;
+	struct filter_level_t *levels;
+	struct filter_level_t *level;
+	size_t *const nlevels = &view->local_filter.nlevels;
+
+	while(*nlevels > 0U)
+	{
+		level = &view->local_filter.levels[*nlevels - 1U];
+		if(strcmp(level->value, filter->raw) == 0 &&
+				level->cflags == filter->cflags)
+		{
+			/* Entries could have been added after the level was computed. */
+			return (fill_filter_level(view, level, level) == 0) ? level : NULL;
+		}
+		if(regexp_narrows(level->value, level->cflags, filter->raw,
+					filter->cflags))
+		{
+			break;
+		}
+
+		free(level->value);
+		free(level->matches);
+		--*nlevels;
+	}
+
+	levels = reallocarray(view->local_filter.levels, *nlevels + 1U,
+			sizeof(*levels));
+	if(levels == NULL)
+	{
+		return NULL;
+	}
+	view->local_filter.levels = levels;
+
+	level = &levels[*nlevels];
+	level->value = strdup(filter->raw);
+	level->cflags = filter->cflags;
+	level->matches = NULL;
+	level->match_count = 0U;
+	level->checked_count = 0U;
+
+	if(level->value == NULL ||
+			fill_filter_level(view, level, (*nlevels == 0U) ? NULL : level - 1) != 0)
+	{
+		free(level->value);
+		free(level->matches);
+		return NULL;
+	}
+
+	++*nlevels;
+	return level;
+}
+
+/* Matches entries of the unfiltered list against local filter and stores
+ * positions of those that pass into the level.  Only entries matched by prev
+ * level and entries added after it was computed are checked when prev isn't
+ * NULL, prev can be the same as level.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+fill_filter_level(FileView *view, struct filter_level_t *level,
+		const struct filter_level_t *prev)
+{
+	const size_t count = view->local_filter.unfiltered_count;
+	const size_t prev_count = (prev == NULL) ? 0U : prev->match_count;
+	const size_t prev_checked = (prev == NULL) ? 0U : prev->checked_count;
+	size_t match_count = 0U;
+	size_t i;
+	int *matches;
+
+	if(prev == level && prev_checked == count)
+	{
+		return 0;
+	}
+
+	matches = reallocarray(NULL, prev_count + (count - prev_checked) + 1U,
+			sizeof(*matches));
+	if(matches == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < prev_count; ++i)
+	{
+		const int pos = prev->matches[i];
+		if(prev == level ||
+				entry_passes_local_filter(view, &view->local_filter.unfiltered[pos]))
+		{
+			matches[match_count++] = pos;
+		}
+	}
+
+	for(i = prev_checked; i < count; ++i)
+	{
+		if(entry_passes_local_filter(view, &view->local_filter.unfiltered[i]))
+		{
+			matches[match_count++] = i;
+		}
+	}
+
+	free(level->matches);
+	level->matches = matches;
+	level->match_count = match_count;
+	level->checked_count = count;
+	return 0;
+}
+
+/* Checks whether entry of the unfiltered list should be displayed for current
+ * value of local filter.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+entry_passes_local_filter(FileView *view, const dir_entry_t *entry)
+{
+	/* Visibility of parent directory doesn't depend on the filter. */
+	return is_parent_dir(entry->name) || local_filter_matches(view, entry);
+}
+
 /* Use parent_entry to make filtered list not empty, or create such entry (if
  * parent_entry is NULL) and put it to original list. */
 static void
@@ -464,7 +652,7 @@ local_filter_update_view(FileView *view, int rel_pos)
 	if(pos >= 0)
 	{
 		if(pos == 0 && is_parent_dir(view->dir_entry[0].name) &&
-				view->list_rows > 0)
+				view->list_rows > 1)
 		{
 			pos++;
 		}
@@ -589,6 +777,23 @@ local_filter_finish(FileView *view)
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
+
+	free_filter_levels(view);
+}
+
+/* Frees results of filtering by values of local filter. */
+static void
+free_filter_levels(FileView *view)
+{
+	size_t i;
+	for(i = 0U; i < view->local_filter.nlevels; ++i)
+	{
+		free(view->local_filter.levels[i].value);
+		free(view->local_filter.levels[i].matches);
+	}
+	free(view->local_filter.levels);
+	view->local_filter.levels = NULL;
+	view->local_filter.nlevels = 0U;
 }
 
 void
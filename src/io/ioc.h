@@ -95,6 +95,10 @@ struct io_args_t
 	 * outside. */
 	int cancellable;
 
+	/* Maximum number of threads that copy files of a subtree in parallel.  Values
+	 * less than two disable parallel processing. */
+	int max_threads;
+
 	/* File overwrite confirmation callback.  Set to NULL to silently
 	 * overwrite. */
 	io_confirm confirm;
@@ -18,17 +18,41 @@
 
 #include "ioeta.h"
 
+#include <pthread.h> /* pthread_* */
+
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* calloc() free() */
 
 #include "../ui/cancellation.h"
+#include "../utils/fs.h"
+#include "../utils/string_array.h"
 #include "private/ioeta.h"
 #include "private/traverser.h"
 
+/* State of calculation in background. */
+struct ioeta_counter_t
+{
+	pthread_mutex_t lock; /* Protects fields below. */
+	int running;          /* Whether thread is processing paths. */
+	int stop;             /* Whether calculation should be stopped. */
+	char **paths;         /* Queue of paths to process. */
+	int npaths;           /* Number of elements in the paths array. */
+	int next;             /* Index of the next path to process. */
+	size_t items;         /* Number of counted items. */
+	uint64_t bytes;       /* Number of counted bytes. */
+
+	pthread_t thread; /* Thread that does the calculation. */
+	int joinable;     /* Whether the thread wasn't joined yet. */
+};
+
 static VisitResult eta_visitor(const char full_path[], VisitAction action,
 		void *param);
+static ioeta_counter_t * get_counter(ioeta_estim_t *estim);
+static void * counter_thread(void *arg);
+static VisitResult bg_eta_visitor(const char full_path[], VisitAction action,
+		void *param);
 
 ioeta_estim_t *
 ioeta_alloc(void *param)
@@ -43,6 +67,19 @@ ioeta_free(ioeta_estim_t *estim)
 {
 	if(estim != NULL)
 	{
+		ioeta_counter_t *const counter = estim->counter;
+		if(counter != NULL)
+		{
+			pthread_mutex_lock(&counter->lock);
+			counter->stop = 1;
+			pthread_mutex_unlock(&counter->lock);
+
+			ioeta_wait(estim);
+
+			pthread_mutex_destroy(&counter->lock);
+			free(counter);
+		}
+
 		free(estim->item);
 		free(estim->target);
 		free(estim);
@@ -62,6 +99,118 @@ ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow)
 	}
 }
 
+void
+ioeta_calculate_bg(ioeta_estim_t *estim, const char path[], int shallow)
+{
+	ioeta_counter_t *counter;
+	int queued;
+
+	if(shallow && estim->counter == NULL)
+	{
+		ioeta_add_item(estim, path);
+		return;
+	}
+
+	counter = get_counter(estim);
+	if(counter == NULL)
+	{
+		ioeta_calculate(estim, path, shallow);
+		return;
+	}
+
+	pthread_mutex_lock(&counter->lock);
+
+	if(shallow)
+	{
+		++counter->items;
+		pthread_mutex_unlock(&counter->lock);
+		ioeta_sync(estim);
+		return;
+	}
+
+	queued = (add_to_string_array(&counter->paths, counter->npaths, 1,
+				path) == counter->npaths + 1);
+	if(queued)
+	{
+		++counter->npaths;
+	}
+
+	if(queued && !counter->running)
+	{
+		if(counter->joinable)
+		{
+			/* The thread has finished processing its queue. */
+			pthread_join(counter->thread, NULL);
+			counter->joinable = 0;
+		}
+
+		if(pthread_create(&counter->thread, NULL, &counter_thread, counter) == 0)
+		{
+			counter->running = 1;
+			counter->joinable = 1;
+		}
+		else
+		{
+			free(counter->paths[--counter->npaths]);
+			queued = 0;
+		}
+	}
+
+	pthread_mutex_unlock(&counter->lock);
+
+	if(!queued)
+	{
+		/* Fallback to calculating estimates on this thread. */
+		(void)traverse(path, &bg_eta_visitor, counter);
+	}
+
+	ioeta_sync(estim);
+}
+
+void
+ioeta_wait(ioeta_estim_t *estim)
+{
+	ioeta_counter_t *const counter = estim->counter;
+	if(counter == NULL)
+	{
+		return;
+	}
+
+	if(counter->joinable)
+	{
+		pthread_join(counter->thread, NULL);
+		counter->joinable = 0;
+	}
+
+	ioeta_sync(estim);
+}
+
+void
+ioeta_sync(ioeta_estim_t *estim)
+{
+	ioeta_counter_t *const counter = estim->counter;
+	if(counter == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&counter->lock);
+	estim->total_items = counter->items;
+	estim->total_bytes = counter->bytes;
+	estim->counting = counter->running;
+	pthread_mutex_unlock(&counter->lock);
+
+	/* Operation could have outrun the calculation. */
+	if(estim->current_item > estim->total_items)
+	{
+		estim->total_items = estim->current_item;
+	}
+	if(estim->current_byte > estim->total_bytes)
+	{
+		estim->total_bytes = estim->current_byte;
+	}
+}
+
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
  * success, otherwise non-zero is returned. */
 static VisitResult
@@ -90,5 +239,98 @@ eta_visitor(const char full_path[], VisitAction action, void *param)
 	return VR_OK;
 }
 
+/* Retrieves state of calculation in background, creating it on the first
+ * call.  Returns the state or NULL on error. */
+static ioeta_counter_t *
+get_counter(ioeta_estim_t *estim)
+{
+	ioeta_counter_t *counter = estim->counter;
+	if(counter != NULL)
+	{
+		return counter;
+	}
+
+	counter = calloc(1U, sizeof(*counter));
+	if(counter == NULL)
+	{
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&counter->lock, NULL) != 0)
+	{
+		free(counter);
+		return NULL;
+	}
+
+	/* Keep what was calculated before. */
+	counter->items = estim->total_items;
+	counter->bytes = estim->total_bytes;
+
+	estim->counter = counter;
+	return counter;
+}
+
+/* Entry point of a thread that calculates estimates for queued paths.  Exits
+ * when the queue becomes empty.  Returns NULL. */
+static void *
+counter_thread(void *arg)
+{
+	ioeta_counter_t *const counter = arg;
+
+	pthread_mutex_lock(&counter->lock);
+	while(counter->next != counter->npaths && !counter->stop)
+	{
+		char *const path = counter->paths[counter->next];
+		counter->paths[counter->next++] = NULL;
+		pthread_mutex_unlock(&counter->lock);
+
+		(void)traverse(path, &bg_eta_visitor, counter);
+		free(path);
+
+		pthread_mutex_lock(&counter->lock);
+	}
+
+	free_string_array(counter->paths, counter->npaths);
+	counter->paths = NULL;
+	counter->npaths = 0;
+	counter->next = 0;
+	counter->running = 0;
+	pthread_mutex_unlock(&counter->lock);
+
+	return NULL;
+}
+
+/* Implementation of traverse() visitor for calculation in background.  Returns
+ * 0 on success, otherwise non-zero is returned. */
+static VisitResult
+bg_eta_visitor(const char full_path[], VisitAction action, void *param)
+{
+	ioeta_counter_t *const counter = param;
+	uint64_t size = 0U;
+	int stop;
+
+	if(action == VA_FILE && !is_symlink(full_path))
+	{
+		size = get_file_size(full_path);
+	}
+
+	pthread_mutex_lock(&counter->lock);
+	if(action == VA_FILE)
+	{
+		++counter->items;
+		counter->bytes += size;
+	}
+	stop = counter->stop;
+	pthread_mutex_unlock(&counter->lock);
+
+	if(stop || ui_cancellation_requested())
+	{
+		return VR_CANCELLED;
+	}
+
+	/* Directories themselves aren't counted, same as in eta_visitor(). */
+	return (action == VA_DIR_ENTER) ? VR_SKIP_DIR_LEAVE : VR_OK;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
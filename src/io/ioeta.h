@@ -24,6 +24,9 @@
 
 /* ioeta - Input/Output estimation */
 
+/* Opaque declaration of state of calculation in background. */
+typedef struct ioeta_counter_t ioeta_counter_t;
+
 typedef struct
 {
 	/* Total number of items to process (T). */
@@ -61,6 +64,13 @@ typedef struct
 
 	/* Custom parameter for notification callbacks. */
 	void *param;
+
+	/* Whether totals are still being calculated in background and thus can
+	 * grow. */
+	int counting;
+
+	/* State of calculation in background or NULL. */
+	ioeta_counter_t *counter;
 }
 ioeta_estim_t;
 
@@ -75,6 +85,15 @@ void ioeta_free(ioeta_estim_t *estim);
  * directories. */
 void ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow);
 
+/* Same as ioeta_calculate(), but deep estimation is performed by a background
+ * thread, so that the operation can proceed immediately.  Totals of the estim
+ * are updated on progress updates and by ioeta_wait(). */
+void ioeta_calculate_bg(ioeta_estim_t *estim, const char path[], int shallow);
+
+/* Waits for calculation in background to finish and updates totals of the
+ * estim. */
+void ioeta_wait(ioeta_estim_t *estim);
+
 #endif /* VIFM__IO__IOETA_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -24,11 +24,22 @@
 
 #include "iop.h"
 
-#include <sys/stat.h> /* stat */
-#include <sys/types.h> /* mode_t */
-#include <unistd.h> /* rmdir() symlink() unlink() */
+#ifndef _WIN32
+#include <sys/ioctl.h> /* ioctl() */
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h> /* sendfile() */
+#endif
+#include <sys/syscall.h> /* SYS_copy_file_range */
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h> /* FICLONE */
+#endif
+#endif
 
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <sys/stat.h> /* fstat() stat */
+#include <sys/types.h> /* mode_t ssize_t */
+#include <unistd.h> /* rmdir() symlink() syscall() unlink() */
+
+#include <errno.h> /* EEXIST EINVAL ENOENT ENOSYS EISDIR EOPNOTSUPP EXDEV errno */
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* FILE fpos_t fclose() fgetpos() fread() fseek() fsetpos()
                       fwrite() snprintf() */
@@ -51,8 +62,49 @@
 #include "ioc.h"
 
 /* Amount of data to transfer at once. */
-#define BLOCK_SIZE 32*1024
+#define COPY_BLOCK_SIZE 32*1024
+
+/* Amount of data to transfer at once by the kernel.  It's bigger than
+ * COPY_BLOCK_SIZE as no user space buffer is involved, but small enough to keep
+ * progress reporting and cancellation responsive. */
+#define KERNEL_BLOCK_SIZE (8*1024*1024)
+
+/* Result of copying file contents by one of the methods. */
+typedef enum
+{
+	CR_DONE,        /* Everything was copied. */
+	CR_FAILED,      /* Copying has failed or was cancelled. */
+	CR_UNSUPPORTED, /* The rest of data needs to be copied by another method. */
+}
+CopyResult;
+
+/* Method of copying contents of input file to the end of output file.  Data is
+ * copied starting at current position of input file. */
+typedef CopyResult (*copy_method)(io_args_t *args, FILE *in, FILE *out);
 
+/* System call that copies at most count bytes between files advancing their
+ * positions.  Returns number of copied bytes or -1 on error. */
+typedef ssize_t (*kernel_copy_func)(int in_fd, int out_fd, size_t count);
+
+static int copy_file_contents(io_args_t *args, FILE *in, FILE *out,
+		int append);
+#ifndef _WIN32
+#ifdef FICLONE
+static CopyResult clone_file(io_args_t *args, FILE *in, FILE *out);
+#endif
+#ifdef SYS_copy_file_range
+static CopyResult copy_file_range_method(io_args_t *args, FILE *in,
+		FILE *out);
+static ssize_t copy_file_range_call(int in_fd, int out_fd, size_t count);
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+static CopyResult sendfile_method(io_args_t *args, FILE *in, FILE *out);
+static ssize_t sendfile_call(int in_fd, int out_fd, size_t count);
+#endif
+static CopyResult kernel_copy(io_args_t *args, FILE *in, FILE *out,
+		kernel_copy_func copy);
+#endif
+static CopyResult stdio_copy(io_args_t *args, FILE *in, FILE *out);
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -60,6 +112,23 @@ static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		HANDLE src_file, HANDLE dst_file, LPVOID param);
 #endif
 
+/* Methods of copying file contents in order of preference.  The last one works
+ * for any files. */
+static const copy_method copy_methods[] = {
+#ifndef _WIN32
+#ifdef FICLONE
+	&clone_file,
+#endif
+#ifdef SYS_copy_file_range
+	&copy_file_range_method,
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+	&sendfile_method,
+#endif
+#endif
+	&stdio_copy,
+};
+
 int
 iop_mkfile(io_args_t *const args)
 {
@@ -237,9 +306,7 @@ iop_cp(io_args_t *const args)
 	const int cancellable = args->cancellable;
 	struct stat st;
 
-	char block[BLOCK_SIZE];
 	FILE *in, *out;
-	size_t nread;
 	int error;
 	struct stat src_st;
 	const char *open_mode = "wb";
@@ -464,29 +531,9 @@ iop_cp(io_args_t *const args)
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
-
-	while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
-	{
-		if(cancellable && ui_cancellation_requested())
-		{
-			error = 1;
-			break;
-		}
-
-		if(fwrite(&block, 1, nread, out) != nread)
-		{
-			(void)ioe_errlst_append(&args->result.errors, dst, errno,
-					strerror(errno));
-			error = 1;
-			break;
-		}
-
-		ioeta_update(args->estim, NULL, NULL, 0, nread);
-	}
-	if(nread == 0U && !feof(in) && ferror(in))
+	if(copy_file_contents(args, in, out, crs == IO_CRS_APPEND_TO_FILES) != 0)
 	{
-		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
+		error = 1;
 	}
 
 	if(fclose(in) != 0)
@@ -513,6 +560,174 @@ iop_cp(io_args_t *const args)
 	return error;
 }
 
+/* Copies contents of the input file to output file trying methods from the
+ * fastest one to the most portable.  Appending works only for the last method,
+ * which respects current positions of the files.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+copy_file_contents(io_args_t *args, FILE *in, FILE *out, int append)
+{
+	size_t i = append ? ARRAY_LEN(copy_methods) - 1U : 0U;
+	for(; i < ARRAY_LEN(copy_methods); ++i)
+	{
+		switch(copy_methods[i](args, in, out))
+		{
+			case CR_DONE:
+				return 0;
+			case CR_FAILED:
+				return 1;
+			case CR_UNSUPPORTED:
+				break;
+		}
+	}
+	return 1;
+}
+
+#ifndef _WIN32
+
+#ifdef FICLONE
+
+/* Makes output file share data with the input file, which is supported by some
+ * file systems (e.g., btrfs and XFS).  It's all or nothing operation. */
+static CopyResult
+clone_file(io_args_t *args, FILE *in, FILE *out)
+{
+	struct stat st;
+
+	if(fstat(fileno(in), &st) != 0 ||
+			ioctl(fileno(out), FICLONE, fileno(in)) != 0)
+	{
+		return CR_UNSUPPORTED;
+	}
+
+	ioeta_update(args->estim, NULL, NULL, 0, st.st_size);
+	return CR_DONE;
+}
+
+#endif
+
+#ifdef SYS_copy_file_range
+
+/* Copies data by copy_file_range() system call, which avoids copying data to
+ * user space and can make use of features of file systems. */
+static CopyResult
+copy_file_range_method(io_args_t *args, FILE *in, FILE *out)
+{
+	return kernel_copy(args, in, out, &copy_file_range_call);
+}
+
+/* kernel_copy() callback that wraps copy_file_range() system call.  It's
+ * invoked directly as C library might lack a wrapper for it.  Returns number of
+ * copied bytes or -1 on error. */
+static ssize_t
+copy_file_range_call(int in_fd, int out_fd, size_t count)
+{
+	return syscall(SYS_copy_file_range, in_fd, NULL, out_fd, NULL, count, 0U);
+}
+
+#endif
+
+#ifdef HAVE_SYS_SENDFILE_H
+
+/* Copies data by sendfile() system call, which avoids copying data to user
+ * space. */
+static CopyResult
+sendfile_method(io_args_t *args, FILE *in, FILE *out)
+{
+	return kernel_copy(args, in, out, &sendfile_call);
+}
+
+/* kernel_copy() callback that wraps sendfile() system call.  Returns number of
+ * copied bytes or -1 on error. */
+static ssize_t
+sendfile_call(int in_fd, int out_fd, size_t count)
+{
+	return sendfile(out_fd, in_fd, NULL, count);
+}
+
+#endif
+
+/* Copies data in blocks by a system call reporting progress and checking for
+ * cancellation in between.  Returns result of copying. */
+static CopyResult
+kernel_copy(io_args_t *args, FILE *in, FILE *out, kernel_copy_func copy)
+{
+	int copied_any = 0;
+
+	while(1)
+	{
+		ssize_t ncopied;
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			return CR_FAILED;
+		}
+
+		ncopied = copy(fileno(in), fileno(out), KERNEL_BLOCK_SIZE);
+		if(ncopied == 0)
+		{
+			/* Some files (e.g., in /proc) report zero size, but have contents, which
+			 * can be obtained only by reading them. */
+			return copied_any ? CR_DONE : CR_UNSUPPORTED;
+		}
+
+		if(ncopied < 0)
+		{
+			/* Files are left at the position where copying has stopped, so next
+			 * method can continue. */
+			if(errno == EINVAL || errno == ENOSYS || errno == EXDEV ||
+					errno == EOPNOTSUPP)
+			{
+				return CR_UNSUPPORTED;
+			}
+
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					strerror(errno));
+			return CR_FAILED;
+		}
+
+		copied_any = 1;
+		ioeta_update(args->estim, NULL, NULL, 0, ncopied);
+	}
+}
+
+#endif
+
+/* Copies data via a buffer using standard I/O library. */
+static CopyResult
+stdio_copy(io_args_t *args, FILE *in, FILE *out)
+{
+	char block[COPY_BLOCK_SIZE];
+	size_t nread;
+	CopyResult result = CR_DONE;
+
+	while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
+	{
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			result = CR_FAILED;
+			break;
+		}
+
+		if(fwrite(&block, 1, nread, out) != nread)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					strerror(errno));
+			result = CR_FAILED;
+			break;
+		}
+
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+	}
+	if(nread == 0U && !feof(in) && ferror(in))
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+				strerror(errno));
+	}
+
+	return result;
+}
+
 #ifdef _WIN32
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
@@ -34,15 +34,31 @@
 #include "../utils/log.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
 #include "../background.h"
+#include "private/cp_pool.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
 #include "private/traverser.h"
 #include "ioc.h"
 #include "iop.h"
 
+/* State of copying a subtree by several threads. */
+typedef struct
+{
+	io_args_t *args; /* Arguments of the operation. */
+	cp_pool_t *pool; /* Threads that copy files. */
+	char **dirs;     /* Source directories that were left. */
+	int ndirs;       /* Number of elements in the dirs array. */
+}
+parallel_cp_t;
+
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
+static int can_cp_in_parallel(const io_args_t *args);
+static int cp_in_parallel(io_args_t *args);
+static VisitResult parallel_cp_visitor(const char full_path[],
+		VisitAction action, void *param);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
 		void *param);
 static int is_file(const char path[]);
@@ -149,9 +165,107 @@ ior_cp(io_args_t *const args)
 		}
 	}
 
+	if(can_cp_in_parallel(args))
+	{
+		return cp_in_parallel(args);
+	}
+
 	return traverse(src, &cp_visitor, args);
 }
 
+/* Checks whether files of a subtree can be copied by several threads.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+can_cp_in_parallel(const io_args_t *args)
+{
+	/* Overwriting of separate files requires interactive confirmation, which
+	 * can't be done from other threads. */
+	return args->max_threads > 1
+	    && args->arg3.crs != IO_CRS_REPLACE_FILES
+	    && is_dir(args->arg1.src)
+	    && !is_symlink(args->arg1.src);
+}
+
+/* Copies subtree by traversing it on the calling thread, which also creates
+ * directories, while files are copied by a pool of threads.  Permissions of
+ * directories are set after all files are copied.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+cp_in_parallel(io_args_t *args)
+{
+	parallel_cp_t pcp = { .args = args };
+	int result;
+	int failed;
+	int i;
+
+	pcp.pool = cp_pool_create(args->max_threads, args);
+	if(pcp.pool == NULL)
+	{
+		return traverse(args->arg1.src, &cp_visitor, args);
+	}
+
+	result = traverse(args->arg1.src, &parallel_cp_visitor, &pcp);
+	failed = cp_pool_finish(pcp.pool);
+	if(result == 0)
+	{
+		result = failed;
+	}
+
+	/* Directories are listed in the order they were left, so children are
+	 * processed before their parents. */
+	for(i = 0; i < pcp.ndirs && result == 0; ++i)
+	{
+		result = cp_visitor(pcp.dirs[i], VA_DIR_LEAVE, args);
+	}
+
+	free_string_array(pcp.dirs, pcp.ndirs);
+	return result;
+}
+
+/* Implementation of traverse() visitor for subtree copying by several threads.
+ * Returns 0 on success, otherwise non-zero is returned. */
+static VisitResult
+parallel_cp_visitor(const char full_path[], VisitAction action, void *param)
+{
+	parallel_cp_t *const pcp = param;
+	io_args_t *const args = pcp->args;
+	const char *rel_part;
+	char *dst_full_path;
+	VisitResult result;
+
+	switch(action)
+	{
+		case VA_DIR_ENTER:
+			return cp_visitor(full_path, action, args);
+		case VA_DIR_LEAVE:
+			if(add_to_string_array(&pcp->dirs, pcp->ndirs, 1, full_path) !=
+					pcp->ndirs + 1)
+			{
+				(void)ioe_errlst_append(&args->result.errors, full_path,
+						IO_ERR_UNKNOWN, "Not enough memory");
+				return VR_ERROR;
+			}
+			++pcp->ndirs;
+			return VR_OK;
+		case VA_FILE:
+			break;
+	}
+
+	if(args->cancellable && ui_cancellation_requested())
+	{
+		return VR_CANCELLED;
+	}
+
+	rel_part = full_path + strlen(args->arg1.src);
+	dst_full_path = format_str("%s/%s", args->arg2.dst, rel_part);
+	result = (cp_pool_add(pcp->pool, full_path, dst_full_path) == 0)
+	       ? VR_OK
+	       : VR_ERROR;
+	free(dst_full_path);
+
+	return result;
+}
+
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
  * success, otherwise non-zero is returned. */
 static VisitResult
@@ -0,0 +1,341 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "cp_pool.h"
+
+#include <pthread.h> /* pthread_* */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+
+#include "../../ui/cancellation.h"
+#include "../../utils/fs.h"
+#include "../ioc.h"
+#include "../ioe.h"
+#include "../iop.h"
+#include "ioe.h"
+#include "ioeta.h"
+
+/* Number of queue slots per thread. */
+#define SLOTS_PER_THREAD 64
+
+/* Single file to be copied. */
+typedef struct
+{
+	char *src;           /* Source path. */
+	char *dst;           /* Destination path. */
+	int done;            /* Whether processing is over. */
+	int skipped;         /* Whether copying wasn't even started. */
+	int error;           /* Whether copying has failed. */
+	uint64_t size;       /* Number of copied bytes. */
+	ioe_errlst_t errors; /* Errors of this copying. */
+}
+task_t;
+
+/* Pool of threads along with bounded queue of files.  Slots of the queue are
+ * used in a circular manner, counters below grow monotonically with
+ * tail <= next <= head and head - tail <= size. */
+struct cp_pool_t
+{
+	io_args_t *args;          /* Template and storage of results. */
+
+	pthread_mutex_t lock;     /* Protects fields below. */
+	pthread_cond_t task_cond; /* Signals about new tasks and finishing. */
+	pthread_cond_t done_cond; /* Signals about processed tasks. */
+
+	task_t *tasks;            /* Queue slots. */
+	size_t size;              /* Number of slots. */
+	size_t head;              /* Slot for the next new task. */
+	size_t next;              /* Slot for a thread to process next. */
+	size_t tail;              /* Oldest task that wasn't reported yet. */
+	int finishing;            /* No more tasks will be added. */
+	int failed;               /* Whether any task has failed. */
+
+	pthread_t *threads;       /* Started threads. */
+	int nthreads;             /* Number of started threads. */
+};
+
+static void * copier(void *arg);
+static void copy_file(const cp_pool_t *pool, task_t *task);
+static void report_done(cp_pool_t *pool);
+static void free_pool(cp_pool_t *pool);
+
+cp_pool_t *
+cp_pool_create(int nthreads, io_args_t *args)
+{
+	int i;
+
+	cp_pool_t *const pool = calloc(1, sizeof(*pool));
+	if(pool == NULL)
+	{
+		return NULL;
+	}
+
+	pool->args = args;
+	pool->size = (size_t)nthreads*SLOTS_PER_THREAD;
+	pool->tasks = calloc(pool->size, sizeof(*pool->tasks));
+	pool->threads = calloc(nthreads, sizeof(*pool->threads));
+	if(pool->tasks == NULL || pool->threads == NULL)
+	{
+		free_pool(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->task_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+
+	for(i = 0; i < nthreads; ++i)
+	{
+		if(pthread_create(&pool->threads[pool->nthreads], NULL, &copier,
+					pool) == 0)
+		{
+			++pool->nthreads;
+		}
+	}
+
+	if(pool->nthreads == 0)
+	{
+		pthread_cond_destroy(&pool->done_cond);
+		pthread_cond_destroy(&pool->task_cond);
+		pthread_mutex_destroy(&pool->lock);
+		free_pool(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+int
+cp_pool_add(cp_pool_t *pool, const char src[], const char dst[])
+{
+	int failed;
+	task_t *task;
+	char *const src_copy = strdup(src);
+	char *const dst_copy = strdup(dst);
+
+	pthread_mutex_lock(&pool->lock);
+
+	if(src_copy == NULL || dst_copy == NULL)
+	{
+		pool->failed = 1;
+	}
+
+	report_done(pool);
+	while(!pool->failed && pool->head - pool->tail == pool->size)
+	{
+		pthread_cond_wait(&pool->done_cond, &pool->lock);
+		report_done(pool);
+	}
+
+	failed = pool->failed;
+	if(!failed)
+	{
+		task = &pool->tasks[pool->head%pool->size];
+		task->src = src_copy;
+		task->dst = dst_copy;
+		task->done = 0;
+		task->skipped = 0;
+		task->error = 0;
+		task->size = 0U;
+		ioe_errlst_init(&task->errors);
+		task->errors.active = pool->args->result.errors.active;
+
+		++pool->head;
+		pthread_cond_signal(&pool->task_cond);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	if(failed)
+	{
+		free(src_copy);
+		free(dst_copy);
+	}
+	return failed;
+}
+
+int
+cp_pool_finish(cp_pool_t *pool)
+{
+	int i;
+	int failed;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->finishing = 1;
+	pthread_cond_broadcast(&pool->task_cond);
+
+	report_done(pool);
+	while(pool->tail != pool->head)
+	{
+		pthread_cond_wait(&pool->done_cond, &pool->lock);
+		report_done(pool);
+	}
+	failed = pool->failed;
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = 0; i < pool->nthreads; ++i)
+	{
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->task_cond);
+	pthread_mutex_destroy(&pool->lock);
+	free_pool(pool);
+
+	return failed;
+}
+
+/* Entry point of a copying thread.  Returns NULL. */
+static void *
+copier(void *arg)
+{
+	cp_pool_t *const pool = arg;
+
+	pthread_mutex_lock(&pool->lock);
+	while(1)
+	{
+		task_t *task;
+
+		while(pool->next == pool->head && !pool->finishing)
+		{
+			pthread_cond_wait(&pool->task_cond, &pool->lock);
+		}
+		if(pool->next == pool->head)
+		{
+			break;
+		}
+
+		task = &pool->tasks[pool->next++%pool->size];
+
+		/* Once something went wrong, remaining tasks are just drained to mimic
+		 * stopping of sequential copying. */
+		if(pool->failed ||
+				(pool->args->cancellable && ui_cancellation_requested()))
+		{
+			pool->failed = 1;
+			task->skipped = 1;
+		}
+		else
+		{
+			pthread_mutex_unlock(&pool->lock);
+			copy_file(pool, task);
+			pthread_mutex_lock(&pool->lock);
+
+			if(task->error)
+			{
+				pool->failed = 1;
+			}
+		}
+
+		task->done = 1;
+		pthread_cond_signal(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/* Copies single file described by the task storing results in it. */
+static void
+copy_file(const cp_pool_t *pool, task_t *task)
+{
+	/* Neither estimates nor confirmation callback are touched from this thread,
+	 * the pool is used only when no confirmation is needed. */
+	io_args_t args = {
+		.arg1.src = task->src,
+		.arg2.dst = task->dst,
+		.arg3.crs = pool->args->arg3.crs,
+
+		.cancellable = pool->args->cancellable,
+
+		.result.errors = task->errors,
+	};
+
+	task->error = (iop_cp(&args) != 0);
+	task->errors = args.result.errors;
+
+	if(!task->error && !is_symlink(task->dst))
+	{
+		task->size = get_file_size(task->dst);
+	}
+}
+
+/* Reports results of processed tasks in the order they were added.  Must be
+ * called with the lock held, which is released while reporting. */
+static void
+report_done(cp_pool_t *pool)
+{
+	size_t i;
+	size_t tail = pool->tail;
+
+	while(tail != pool->next && pool->tasks[tail%pool->size].done)
+	{
+		++tail;
+	}
+
+	if(tail == pool->tail)
+	{
+		return;
+	}
+
+	/* Slots between pool->tail and tail aren't accessed by other threads. */
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = pool->tail; i != tail; ++i)
+	{
+		size_t j;
+		task_t *const task = &pool->tasks[i%pool->size];
+
+		for(j = 0U; j < task->errors.error_count; ++j)
+		{
+			const ioe_err_t *const err = &task->errors.errors[j];
+			(void)ioe_errlst_append(&pool->args->result.errors, err->path,
+					err->error_code, err->msg);
+		}
+		ioe_errlst_free(&task->errors);
+
+		if(!task->skipped && !task->error)
+		{
+			ioeta_update(pool->args->estim, task->src, task->dst, 1, task->size);
+		}
+
+		free(task->src);
+		free(task->dst);
+		task->src = NULL;
+		task->dst = NULL;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->tail = tail;
+}
+
+/* Frees memory of the pool. */
+static void
+free_pool(cp_pool_t *pool)
+{
+	free(pool->threads);
+	free(pool->tasks);
+	free(pool);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,48 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__CP_POOL_H__
+#define VIFM__IO__PRIVATE__CP_POOL_H__
+
+#include "../ioc.h"
+
+/* cp_pool - pool of threads that copy files */
+
+/* Opaque declaration of the pool type. */
+typedef struct cp_pool_t cp_pool_t;
+
+/* Starts nthreads threads that copy files scheduled via cp_pool_add().  Errors
+ * and progress of copying are reported to the args on the calling thread,
+ * which is also used as a source of conflict resolution strategy and
+ * cancellation flag.  Returns NULL on error. */
+cp_pool_t * cp_pool_create(int nthreads, io_args_t *args);
+
+/* Schedules copying of src file to dst, waiting while the queue is full.
+ * Returns non-zero if copying of any of previously scheduled files has failed
+ * (no more files should be added then), otherwise zero is returned. */
+int cp_pool_add(cp_pool_t *pool, const char src[], const char dst[]);
+
+/* Waits for all scheduled files to be processed, stops threads and frees the
+ * pool.  Returns non-zero if copying of any file has failed, otherwise zero is
+ * returned. */
+int cp_pool_finish(cp_pool_t *pool);
+
+#endif /* VIFM__IO__PRIVATE__CP_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
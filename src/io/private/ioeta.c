@@ -64,6 +64,8 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		return;
 	}
 
+	ioeta_sync(estim);
+
 	estim->current_byte += bytes;
 	estim->current_file_byte += bytes;
 	if(estim->current_byte > estim->total_bytes)
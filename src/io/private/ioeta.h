@@ -34,6 +34,9 @@ void ioeta_add_file(ioeta_estim_t *estim, const char path[]);
 /* Adds directory to the estimation. */
 void ioeta_add_dir(ioeta_estim_t *estim, const char path[]);
 
+/* Updates totals of the estim with results of calculation in background. */
+void ioeta_sync(ioeta_estim_t *estim);
+
 /* ioeta_update_estim(e, "p", "t", 0, 100); -- 100 bytes of current item
  * processed.
  * ioeta_update_estim(e, "", "", 1, 50); -- Last 50 bytes of current item
@@ -26,9 +26,12 @@
 #include "../modes/dialogs/msg_dialog.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/find_expr.h"
+#include "../utils/fswalk.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
 #include "../macros.h"
 #include "menus.h"
 
@@ -38,6 +41,11 @@
 #define DEFAULT_PREDICATE "-name"
 #endif
 
+static int run_builtin_find(FileView *view, int with_path, const char args[],
+		menu_info *m);
+static void find_visit(fswalk_t *walk, const char path[], FswalkType type,
+		void *arg);
+static void free_expr(void *arg);
 static int execute_find_cb(FileView *view, menu_info *m);
 
 int
@@ -56,6 +64,11 @@ show_find_menu(FileView *view, int with_path, const char args[])
 
 	static menu_info m;
 
+	if(cfg.find_prg[0] == '\0')
+	{
+		return run_builtin_find(view, with_path, args, &m);
+	}
+
 	if(with_path)
 	{
 		macros[0].value = args;
@@ -105,6 +118,84 @@ show_find_menu(FileView *view, int with_path, const char args[])
 	return save_msg;
 }
 
+/* Looks for files using built-in engine instead of external program.  Returns
+ * non-zero if status bar message should be saved. */
+static int
+run_builtin_find(FileView *view, int with_path, const char args[],
+		menu_info *m)
+{
+	int save_msg;
+	char *error;
+	char **roots;
+	int nroots;
+	find_expr_t *expr;
+	char *custom_args = NULL;
+	const char *expr_args = args;
+
+	if(!with_path && args[0] != '-')
+	{
+		char *const escaped_args = shell_like_escape(args, 0);
+		custom_args = format_str("%s %s", DEFAULT_PREDICATE, escaped_args);
+		expr_args = custom_args;
+		free(escaped_args);
+	}
+
+	expr = find_expr_parse(expr_args, &roots, &nroots, &error);
+	free(custom_args);
+	if(expr == NULL)
+	{
+		status_bar_errorf("Find error: %s", error);
+		free(error);
+		return 1;
+	}
+
+	if(!with_path)
+	{
+		free_string_array(roots, nroots);
+		roots = prepare_target_list(view, &nroots);
+		if(roots == NULL)
+		{
+			show_error_msg("Find", "Failed to setup target directory.");
+			find_expr_free(expr);
+			return 0;
+		}
+	}
+	else if(nroots == 0)
+	{
+		nroots = add_to_string_array(&roots, nroots, 1, ".");
+	}
+
+	init_menu_info(m, format_str("Find %s", args), strdup("No files found"));
+
+	m->execute_handler = &execute_find_cb;
+	m->key_handler = &filelist_khandler;
+
+	status_bar_message("find...");
+	save_msg = capture_walk_to_menu(view, roots, nroots, 0, &find_visit, expr,
+			&free_expr, m);
+
+	free_string_array(roots, nroots);
+
+	return save_msg;
+}
+
+/* Implements fswalk_run() visitor that reports entries matching expression. */
+static void
+find_visit(fswalk_t *walk, const char path[], FswalkType type, void *arg)
+{
+	if(find_expr_matches(arg, path, type))
+	{
+		fswalk_report(walk, path);
+	}
+}
+
+/* Frees expression passed to capture_walk_to_menu(). */
+static void
+free_expr(void *arg)
+{
+	find_expr_free(arg);
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
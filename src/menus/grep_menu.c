@@ -26,12 +26,23 @@
 #include "../modes/dialogs/msg_dialog.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/fswalk.h"
+#include "../utils/grep.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
+#include "../utils/utils.h"
 #include "../macros.h"
 #include "menus.h"
 
+static int run_builtin_grep(FileView *view, const char pattern[], int invert,
+		menu_info *m);
+static void grep_visit(fswalk_t *walk, const char path[], FswalkType type,
+		void *arg);
+static void grep_match(const char path[], int line_num, const char line[],
+		void *arg);
+static void free_grep(void *arg);
 static int execute_grep_cb(FileView *view, menu_info *m);
 
 int
@@ -51,6 +62,11 @@ show_grep_menu(FileView *view, const char args[], int invert)
 
 	static menu_info m;
 
+	if(cfg.grep_prg[0] == '\0')
+	{
+		return run_builtin_grep(view, args, invert, &m);
+	}
+
 	targets = prepare_targets(view);
 	if(targets == NULL)
 	{
@@ -86,6 +102,79 @@ show_grep_menu(FileView *view, const char args[], int invert)
 	return save_msg;
 }
 
+/* Searches for the pattern in files using built-in engine instead of external
+ * program.  Returns non-zero if status bar message should be saved. */
+static int
+run_builtin_grep(FileView *view, const char pattern[], int invert,
+		menu_info *m)
+{
+	int save_msg;
+	int ntargets;
+	char **targets;
+	char *error;
+	grep_t *grep;
+
+	grep = grep_alloc(pattern, get_regexp_cflags(pattern), invert, &error);
+	if(grep == NULL)
+	{
+		status_bar_errorf("Regexp error: %s", error);
+		free(error);
+		return 1;
+	}
+
+	targets = prepare_target_list(view, &ntargets);
+	if(targets == NULL)
+	{
+		show_error_msg("Grep", "Failed to setup target directory.");
+		grep_free(grep);
+		return 0;
+	}
+
+	init_menu_info(m, format_str("Grep %s", pattern),
+			format_str("No matches found: %s", pattern));
+
+	m->execute_handler = &execute_grep_cb;
+	m->key_handler = &filelist_khandler;
+
+	status_bar_message("grep...");
+	save_msg = capture_walk_to_menu(view, targets, ntargets, FSWALK_SKIP_IGNORED,
+			&grep_visit, grep, &free_grep, m);
+
+	free_string_array(targets, ntargets);
+
+	return save_msg;
+}
+
+/* Implements fswalk_run() visitor that searches for matches in files. */
+static void
+grep_visit(fswalk_t *walk, const char path[], FswalkType type, void *arg)
+{
+	/* Like grep, don't follow symbolic links found during traversal. */
+	if(type == FWT_FILE)
+	{
+		(void)grep_file(arg, path, &grep_match, walk);
+	}
+}
+
+/* Reports matching line in the same format as output of grep. */
+static void
+grep_match(const char path[], int line_num, const char line[], void *arg)
+{
+	char *const result = format_str("%s:%d:%s", path, line_num, line);
+	if(result != NULL)
+	{
+		fswalk_report(arg, result);
+		free(result);
+	}
+}
+
+/* Frees pattern passed to capture_walk_to_menu(). */
+static void
+free_grep(void *arg)
+{
+	grep_free(arg);
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
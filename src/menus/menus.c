@@ -20,19 +20,26 @@
 #include "menus.h"
 
 #include <curses.h>
+#include <pthread.h> /* pthread_* */
+#include <regex.h> /* regcomp() regexec() regfree() */
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <sys/types.h> /* pid_t */
+#include <unistd.h> /* usleep() */
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memmove() memset() strdup() strcat() strncat() strchr()
-                       strlen() strrchr() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memcpy() memmove() memset() strdup() strcat() strchr()
+                       strcspn() strlen() strncat() strrchr() */
 #include <wchar.h> /* wchar_t wcscmp() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
 #include "../compat/reallocarray.h"
+#include "../engine/mode.h"
 #include "../modes/dialogs/msg_dialog.h"
 #include "../modes/cmdline.h"
 #include "../modes/menu.h"
@@ -40,11 +47,14 @@
 #include "../ui/cancellation.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/file_streams.h"
 #include "../utils/fs.h"
+#include "../utils/fswalk.h"
 #include "../utils/log.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/str_pool.h"
 #include "../utils/string_array.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
@@ -60,16 +70,88 @@
 #include "../status.h"
 #include "../vim.h"
 
+/* Interval between checks of a feed that's loaded before menu can be displayed
+ * in microseconds. */
+#define FEED_WAIT_STEP 10000
+
+/* Initial size of buffer of pending items of a feed. */
+#define FEED_PENDING_SIZE 4096U
+
+/* Minimal interval between redraws of a menu that's being loaded in
+ * milliseconds. */
+#define FEED_REDRAW_PERIOD 100U
+
+/* Producer of menu items running in background.  Shared by the main thread and
+ * the background task, freed by the one that's done with it last. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects the five fields below. */
+	char *pending;        /* Items that weren't yet moved to the menu, each one
+	                         is terminated by a null character. */
+	size_t pending_len;   /* Number of used bytes of the pending buffer. */
+	size_t pending_size;  /* Number of allocated bytes of the pending buffer. */
+	int finished;         /* Set by the task after it's done. */
+	int abandoned;        /* Set when items aren't needed anymore. */
+
+	/* External command, which produces items. */
+	pid_t pid; /* Process id of the command or (pid_t)-1. */
+	FILE *out; /* Output stream of the command, owned by the task. */
+	FILE *err; /* Error stream of the command. */
+
+	/* Traversal of file system, which produces items. */
+	char **roots;                   /* Where to start traversal. */
+	int nroots;                     /* Number of roots. */
+	int flags;                      /* Flags of fswalk_run(). */
+	fswalk_visit_func visit;        /* Visitor of capture_walk_to_menu(). */
+	void *arg;                      /* Argument of the visitor. */
+	void (*free_arg)(void *arg);    /* Frees arg, can be NULL. */
+
+	/* These are used only by the main thread. */
+	menu_info *m;       /* Menu being loaded. */
+	int items_size;     /* Number of allocated elements of m->items. */
+	char *line_buf;     /* Buffer for expanding tabulation. */
+	size_t line_size;   /* Size of the line buffer. */
+	int dirty;          /* Whether menu has changed since it was last drawn. */
+	uint64_t last_draw; /* Time of the last redraw in milliseconds. */
+}
+menu_feed_t;
+
 static void draw_menu_item(menu_info *m, char buf[], int off,
 		const col_attr_t *col);
 static void open_selected_file(const char path[], int line_num);
 static void navigate_to_selected_file(FileView *view, const char path[]);
 static void normalize_top(menu_info *m);
-static void output_handler(const char line[], void *arg);
+static void normalize_items(menu_info *m);
+static const char * get_draw_buf(const char item[]);
+static menu_feed_t * alloc_feed(void);
+static void free_feed(menu_feed_t *feed);
+static int run_feed(FileView *view, menu_feed_t *feed, const char descr[],
+		bg_task_func task, menu_info *m);
+static int pull_feed_items(void);
+static void append_item(menu_feed_t *feed, const char line[]);
+static void update_matches(menu_info *m, int from);
+static FILE * detach_feed(void);
+static void leave_empty_menu(menu_info *m);
+static void cancel_feed(void);
+static void cmd_feed_task(bg_op_t *bg_op, void *arg);
+static void walk_feed_task(bg_op_t *bg_op, void *arg);
+static void walk_visit(fswalk_t *walk, const char path[], FswalkType type,
+		void *arg);
+static void walk_result(const char result[], void *arg);
+static int walk_cancelled(void *arg);
+static int add_feed_item(menu_feed_t *feed, const char item[]);
+static void finish_feed(menu_feed_t *feed);
+static uint64_t get_time_ms(void);
+static int display_captured_menu(menu_info *m, FileView *view);
 static void append_to_string(char **str, const char suffix[]);
-static char * expand_tabulation_a(const char line[], size_t tab_stops);
 static size_t chars_in_str(const char s[], char c);
 
+/* Feed of menu that's being loaded or NULL. */
+static menu_feed_t *curr_feed;
+/* Menu whose feed finished without items while another mode was active on top
+ * of menu mode or NULL. */
+static menu_info *empty_menu;
+
 static void
 show_position_in_menu(menu_info *m)
 {
@@ -84,7 +166,16 @@ remove_current_item(menu_info *m)
 {
 	clean_menu_position(m);
 
-	remove_from_string_array(m->items, m->len, m->pos);
+	if(m->pool != NULL)
+	{
+		str_pool_release(m->items[m->pos]);
+		memmove(m->items + m->pos, m->items + m->pos + 1,
+				sizeof(*m->items)*((m->len - 1) - m->pos));
+	}
+	else
+	{
+		remove_from_string_array(m->items, m->len, m->pos);
+	}
 	if(m->matches != NULL)
 	{
 		if(m->matches[m->pos])
@@ -106,6 +197,12 @@ clean_menu_position(menu_info *m)
 	char *buf;
 	col_attr_t col;
 
+	/* Menu that's being loaded can be empty. */
+	if(m->pos >= m->len)
+	{
+		return;
+	}
+
 	x = getmaxx(menu_win) + utf8_stro(m->items[m->pos]);
 
 	buf = malloc(x + 2);
@@ -164,6 +261,7 @@ init_menu_info(menu_info *m, char title[], char empty_msg[])
 	m->title = title;
 	m->args = NULL;
 	m->items = NULL;
+	m->pool = NULL;
 	m->data = NULL;
 	m->key_handler = NULL;
 	m->extra_data = 0;
@@ -174,6 +272,15 @@ init_menu_info(menu_info *m, char title[], char empty_msg[])
 void
 reset_popup_menu(menu_info *m)
 {
+	if(curr_feed != NULL && curr_feed->m == m)
+	{
+		cancel_feed();
+	}
+	if(empty_menu == m)
+	{
+		empty_menu = NULL;
+	}
+
 	free(m->args);
 	/* Menu elements don't always have data associated with them.  That's why we
 	 * need this check. */
@@ -181,7 +288,20 @@ reset_popup_menu(menu_info *m)
 	{
 		free_string_array(m->data, m->len);
 	}
-	free_string_array(m->items, m->len);
+	if(m->pool != NULL)
+	{
+		int i;
+		str_pool_free(m->pool);
+		for(i = 0; i < m->len; ++i)
+		{
+			str_pool_release(m->items[i]);
+		}
+		free(m->items);
+	}
+	else
+	{
+		free_string_array(m->items, m->len);
+	}
 	free(m->regexp);
 	free(m->matches);
 	free(m->title);
@@ -458,6 +578,10 @@ draw_menu(menu_info *m)
 	checked_wmove(menu_win, 0, 3);
 	wprint(menu_win, " ");
 	wprint(menu_win, m->title);
+	if(curr_feed != NULL && curr_feed->m == m)
+	{
+		wprint(menu_win, " (running...)");
+	}
 	wprint(menu_win, " ");
 	wattroff(menu_win, A_BOLD);
 
@@ -465,13 +589,8 @@ draw_menu(menu_info *m)
 	{
 		int z, off;
 		char *buf;
-		char *ptr = NULL;
 		col_attr_t col;
 
-		chomp(m->items[x]);
-		if((ptr = strchr(m->items[x], '\n')) || (ptr = strchr(m->items[x], '\r')))
-			*ptr = '\0';
-
 		col = cfg.cs.color[WIN_COLOR];
 
 		if(cfg.hl_search && m->matches != NULL && m->matches[x])
@@ -489,10 +608,11 @@ draw_menu(menu_info *m)
 			off += l;
 		}
 
-		buf = strdup(m->items[x] + off);
-		for(z = 0; buf[z] != '\0'; z++)
-			if(buf[z] == '\t')
-				buf[z] = ' ';
+		buf = (char *)get_draw_buf(m->items[x] + off);
+		if(buf == NULL)
+		{
+			break;
+		}
 
 		checked_wmove(menu_win, i, 2);
 		if(utf8_strsw(buf) > (size_t)(win_len - 4))
@@ -511,8 +631,6 @@ draw_menu(menu_info *m)
 		}
 		waddstr(menu_win, " ");
 
-		free(buf);
-
 		wattroff(menu_win, COLOR_PAIR(colmgr_get_pair(col.fg, col.bg)) | col.attr);
 
 		if(i + 3 > y)
@@ -520,6 +638,42 @@ draw_menu(menu_info *m)
 	}
 }
 
+/* Copies the item into a buffer that's reused between calls replacing
+ * tabulation characters with spaces.  Returns the buffer or NULL on error. */
+static const char *
+get_draw_buf(const char item[])
+{
+	static char *buf;
+	static size_t buf_size;
+
+	char *p;
+	const size_t len = strlen(item);
+
+	if(len + 1U > buf_size)
+	{
+		char *const new_buf = realloc(buf, len + 1U);
+		if(new_buf == NULL)
+		{
+			return NULL;
+		}
+		buf = new_buf;
+		buf_size = len + 1U;
+	}
+
+	memcpy(buf, item, len + 1U);
+	for(p = buf; (p = strchr(p, '\t')) != NULL; ++p)
+	{
+		*p = ' ';
+	}
+	return buf;
+}
+
+int
+menu_is_loading(const menu_info *m)
+{
+	return curr_feed != NULL && curr_feed->m == m;
+}
+
 /* Ensures that value of m->top lies in a correct range. */
 static void
 normalize_top(menu_info *m)
@@ -531,34 +685,615 @@ int
 capture_output_to_menu(FileView *view, const char cmd[], int user_sh,
 		menu_info *m)
 {
-	if(process_cmd_output("Loading menu", cmd, user_sh, &output_handler, m) != 0)
+	menu_feed_t *feed;
+	FILE *out, *err;
+	pid_t pid;
+
+	LOG_INFO_MSG("Capturing output of the command: %s", cmd);
+
+	pid = background_and_capture((char *)cmd, user_sh, &out, &err);
+	if(pid == (pid_t)-1)
 	{
 		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
 		return 0;
 	}
 
-	if(ui_cancellation_requested())
+	feed = alloc_feed();
+	if(feed == NULL)
 	{
-		append_to_string(&m->title, "(cancelled)");
-		append_to_string(&m->empty_msg, " (cancelled)");
+		interrupt_process(pid);
+		fclose(out);
+		fclose(err);
+		show_error_msg("Trouble running command", "Not enough memory");
+		return 0;
 	}
 
-	return display_menu(m, view);
+	feed->pid = pid;
+	feed->out = out;
+	feed->err = err;
+	return run_feed(view, feed, cmd, &cmd_feed_task, m);
 }
 
-/* Implements process_cmd_output() callback that loads lines to a menu. */
+int
+capture_walk_to_menu(FileView *view, char *roots[], int nroots, int flags,
+		fswalk_visit_func visit, void *arg, void (*free_arg)(void *arg),
+		menu_info *m)
+{
+	int i;
+	menu_feed_t *const feed = alloc_feed();
+	if(feed == NULL)
+	{
+		free_arg(arg);
+		show_error_msg("Loading menu", "Not enough memory");
+		return 0;
+	}
+
+	feed->flags = flags;
+	feed->visit = visit;
+	feed->arg = arg;
+	feed->free_arg = free_arg;
+	for(i = 0; i < nroots; ++i)
+	{
+		feed->nroots = add_to_string_array(&feed->roots, feed->nroots, 1,
+				roots[i]);
+	}
+
+	return run_feed(view, feed, m->title, &walk_feed_task, m);
+}
+
+/* Allocates and initializes empty feed.  Returns the feed or NULL on error. */
+static menu_feed_t *
+alloc_feed(void)
+{
+	menu_feed_t *const feed = malloc(sizeof(*feed));
+	if(feed == NULL)
+	{
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&feed->lock, NULL) != 0)
+	{
+		free(feed);
+		return NULL;
+	}
+
+	feed->pending = NULL;
+	feed->pending_len = 0U;
+	feed->pending_size = 0U;
+	feed->finished = 0;
+	feed->abandoned = 0;
+	feed->pid = (pid_t)-1;
+	feed->out = NULL;
+	feed->err = NULL;
+	feed->roots = NULL;
+	feed->nroots = 0;
+	feed->flags = 0;
+	feed->visit = NULL;
+	feed->arg = NULL;
+	feed->free_arg = NULL;
+	feed->m = NULL;
+	feed->items_size = 0;
+	feed->line_buf = NULL;
+	feed->line_size = 0U;
+	feed->dirty = 0;
+	feed->last_draw = 0U;
+	return feed;
+}
+
+/* Frees the feed along with everything it owns. */
 static void
-output_handler(const char line[], void *arg)
+free_feed(menu_feed_t *feed)
+{
+	if(feed->out != NULL)
+	{
+		fclose(feed->out);
+	}
+	if(feed->err != NULL)
+	{
+		fclose(feed->err);
+	}
+	if(feed->free_arg != NULL)
+	{
+		feed->free_arg(feed->arg);
+	}
+	free_string_array(feed->roots, feed->nroots);
+	free(feed->pending);
+	free(feed->line_buf);
+	pthread_mutex_destroy(&feed->lock);
+	free(feed);
+}
+
+/* Starts the feed in background and displays the menu right away, loading of
+ * items goes on after the menu is displayed.  Takes ownership of the feed.
+ * Returns non-zero if status bar message should be saved. */
+static int
+run_feed(FileView *view, menu_feed_t *feed, const char descr[],
+		bg_task_func task, menu_info *m)
 {
-	menu_info *m = arg;
-	char *expanded_line;
+	FILE *err = NULL;
+	int finished = 0;
+
+	cancel_feed();
+
+	if(m->pool == NULL)
+	{
+		m->pool = str_pool_create();
+		if(m->pool == NULL)
+		{
+			if(feed->pid != (pid_t)-1)
+			{
+				interrupt_process(feed->pid);
+			}
+			free_feed(feed);
+			show_error_msg("Loading menu", "Not enough memory");
+			return 0;
+		}
+	}
+
+	feed->m = m;
+	feed->items_size = m->len;
+	if(bg_execute(descr, "Loading menu", BG_UNDEFINED_TOTAL, 0, task, feed) != 0)
+	{
+		if(feed->pid != (pid_t)-1)
+		{
+			interrupt_process(feed->pid);
+		}
+		free_feed(feed);
+		show_error_msg("Loading menu", "Failed to start background job");
+		return 0;
+	}
+	curr_feed = feed;
+
+	ui_cancellation_reset();
+
+	/* Items are loaded completely if menu can't be displayed right away. */
+	if(curr_stats.load_stage < 2)
+	{
+		ui_cancellation_enable();
+		while(!(finished = pull_feed_items()))
+		{
+			if(ui_cancellation_requested())
+			{
+				cancel_feed();
+				break;
+			}
+			usleep(FEED_WAIT_STEP);
+		}
+		ui_cancellation_disable();
+	}
+	else
+	{
+		/* Take whatever is ready to not show an empty menu needlessly. */
+		finished = pull_feed_items();
+	}
 
-	m->items = reallocarray(m->items, m->len + 1, sizeof(char *));
-	expanded_line = expand_tabulation_a(line, cfg.tab_stop);
-	if(expanded_line != NULL)
+	if(finished)
 	{
-		m->items[m->len++] = expanded_line;
+		err = detach_feed();
 	}
+
+	show_errors_from_file(err, "Loading menu");
+	return display_captured_menu(m, view);
+}
+
+void
+menus_check_for_updates(void)
+{
+	int finished;
+	int redraw;
+	menu_info *m;
+	FILE *err = NULL;
+
+	/* Empty menu is left once its mode is back, e.g. after command-line mode
+	 * has been closed. */
+	if(empty_menu != NULL && vle_mode_is(MENU_MODE))
+	{
+		m = empty_menu;
+		empty_menu = NULL;
+		leave_empty_menu(m);
+	}
+
+	if(curr_feed == NULL)
+	{
+		return;
+	}
+
+	m = curr_feed->m;
+	finished = pull_feed_items();
+
+	/* Limit rate of redraws to not waste time on drawing a menu that changes
+	 * faster than one can see. */
+	redraw = finished;
+	if(curr_feed->dirty)
+	{
+		const uint64_t now = get_time_ms();
+		if(now - curr_feed->last_draw >= FEED_REDRAW_PERIOD)
+		{
+			curr_feed->dirty = 0;
+			curr_feed->last_draw = now;
+			redraw = 1;
+		}
+	}
+
+	if(finished)
+	{
+		err = detach_feed();
+	}
+
+	if(finished && m->len == 0 && vle_mode_get_primary() == MENU_MODE)
+	{
+		/* Menu was displayed while it was empty and there is nothing to show.
+		 * Leaving it from under another mode would break that mode. */
+		if(vle_mode_is(MENU_MODE))
+		{
+			leave_empty_menu(m);
+		}
+		else
+		{
+			empty_menu = m;
+		}
+		redraw = 0;
+	}
+
+	if(redraw && vle_mode_is(MENU_MODE))
+	{
+		draw_menu(m);
+		move_to_menu_pos(m->pos, m);
+		wrefresh(menu_win);
+	}
+
+	show_errors_from_file(err, "Loading menu");
+}
+
+/* Moves items produced by current feed into its menu.  Returns non-zero if the
+ * feed is done producing items. */
+static int
+pull_feed_items(void)
+{
+	menu_feed_t *const feed = curr_feed;
+	menu_info *const m = feed->m;
+	char *pending;
+	size_t pending_len, pending_size;
+	size_t pos;
+	int finished;
+	const int old_len = m->len;
+
+	pthread_mutex_lock(&feed->lock);
+	pending = feed->pending;
+	pending_len = feed->pending_len;
+	pending_size = feed->pending_size;
+	finished = feed->finished;
+	feed->pending = NULL;
+	feed->pending_len = 0U;
+	feed->pending_size = 0U;
+	pthread_mutex_unlock(&feed->lock);
+
+	for(pos = 0U; pos < pending_len; pos += strlen(pending + pos) + 1U)
+	{
+		append_item(feed, pending + pos);
+	}
+
+	/* Give the buffer back to the task to avoid allocating a new one. */
+	pthread_mutex_lock(&feed->lock);
+	if(feed->pending == NULL)
+	{
+		feed->pending = pending;
+		feed->pending_size = pending_size;
+		pending = NULL;
+	}
+	pthread_mutex_unlock(&feed->lock);
+	free(pending);
+
+	if(m->len != old_len)
+	{
+		update_matches(m, old_len);
+		feed->dirty = 1;
+	}
+
+	return finished;
+}
+
+/* Appends the line to the menu of the feed expanding tabulation and cutting it
+ * at the first end-of-line character. */
+static void
+append_item(menu_feed_t *feed, const char line[])
+{
+	menu_info *const m = feed->m;
+	char *item;
+
+	if(m->len >= feed->items_size)
+	{
+		const int new_size = (feed->items_size == 0) ? 256 : feed->items_size*2;
+		char **const items = reallocarray(m->items, new_size, sizeof(*items));
+		if(items == NULL)
+		{
+			return;
+		}
+		m->items = items;
+		feed->items_size = new_size;
+	}
+
+	item = make_menu_item(m->pool, line, &feed->line_buf, &feed->line_size);
+	if(item != NULL)
+	{
+		m->items[m->len++] = item;
+	}
+}
+
+char *
+make_menu_item(str_pool_t *pool, const char line[], char **buf,
+		size_t *buf_size)
+{
+	const size_t len = strcspn(line, "\r\n");
+	size_t max_len;
+
+	if(line[len] == '\0' && strchr(line, '\t') == NULL)
+	{
+		return str_pool_dup(pool, line);
+	}
+
+	/* Whole line is expanded, so the buffer must fit all of it, not just the
+	 * part that ends up in the item. */
+	max_len = strlen(line) + chars_in_str(line, '\t')*cfg.tab_stop;
+	if(max_len + 1U > *buf_size)
+	{
+		char *const new_buf = realloc(*buf, max_len + 1U);
+		if(new_buf == NULL)
+		{
+			return NULL;
+		}
+		*buf = new_buf;
+		*buf_size = max_len + 1U;
+	}
+
+	(void)expand_tabulation(line, (size_t)-1, cfg.tab_stop, *buf);
+	(*buf)[strcspn(*buf, "\r\n")] = '\0';
+	return str_pool_dup(pool, *buf);
+}
+
+/* Extends list of search matches of the menu to cover items starting with the
+ * from one. */
+static void
+update_matches(menu_info *m, int from)
+{
+	regex_t re;
+	int i;
+	int *matches;
+
+	if(m->matches == NULL)
+	{
+		return;
+	}
+
+	matches = reallocarray(m->matches, m->len, sizeof(*matches));
+	if(matches == NULL)
+	{
+		return;
+	}
+	m->matches = matches;
+	memset(m->matches + from, 0, sizeof(*m->matches)*(m->len - from));
+
+	if(m->regexp == NULL || m->regexp[0] == '\0' ||
+			regcomp(&re, m->regexp, get_regexp_cflags(m->regexp)) != 0)
+	{
+		return;
+	}
+
+	for(i = from; i < m->len; ++i)
+	{
+		if(regexec(&re, m->items[i], 0, NULL, 0) == 0)
+		{
+			m->matches[i] = 1;
+			++m->matching_entries;
+		}
+	}
+	regfree(&re);
+}
+
+/* Forgets about current feed, which must be finished.  Returns error stream of
+ * external command or NULL. */
+static FILE *
+detach_feed(void)
+{
+	menu_info *const m = curr_feed->m;
+	FILE *const err = curr_feed->err;
+	curr_feed->err = NULL;
+
+	/* Give back memory that isn't used. */
+	if(m->len != 0 && m->len != curr_feed->items_size)
+	{
+		char **const items = reallocarray(m->items, m->len, sizeof(*items));
+		if(items != NULL)
+		{
+			m->items = items;
+		}
+	}
+
+	free_feed(curr_feed);
+	curr_feed = NULL;
+	return err;
+}
+
+/* Leaves menu mode for a menu that has no items and reports that on the status
+ * bar. */
+static void
+leave_empty_menu(menu_info *m)
+{
+	char *const empty_msg = m->empty_msg;
+	m->empty_msg = NULL;
+	leave_menu_mode();
+	status_bar_message(empty_msg);
+	curr_stats.save_msg = 1;
+	free(empty_msg);
+}
+
+/* Stops current feed, if any, interrupting command that produces items. */
+static void
+cancel_feed(void)
+{
+	int finished;
+
+	if(curr_feed == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&curr_feed->lock);
+	finished = curr_feed->finished;
+	if(!finished)
+	{
+		curr_feed->abandoned = 1;
+		if(curr_feed->pid != (pid_t)-1)
+		{
+			interrupt_process(curr_feed->pid);
+		}
+	}
+	pthread_mutex_unlock(&curr_feed->lock);
+
+	if(finished)
+	{
+		free_feed(curr_feed);
+	}
+	curr_feed = NULL;
+}
+
+/* Entry point of background task that reads output of external command. */
+static void
+cmd_feed_task(bg_op_t *bg_op, void *arg)
+{
+	menu_feed_t *const feed = arg;
+	char *line = NULL;
+
+	while((line = read_line(feed->out, line)) != NULL)
+	{
+		if(add_feed_item(feed, line) != 0)
+		{
+			free(line);
+			break;
+		}
+	}
+
+	fclose(feed->out);
+	feed->out = NULL;
+
+	finish_feed(feed);
+}
+
+/* Entry point of background task that traverses file system. */
+static void
+walk_feed_task(bg_op_t *bg_op, void *arg)
+{
+	menu_feed_t *const feed = arg;
+	(void)fswalk_run(feed->roots, feed->nroots, feed->flags, &walk_visit,
+			&walk_result, &walk_cancelled, feed);
+	finish_feed(feed);
+}
+
+/* Implements fswalk_run() visitor by forwarding the call to the visitor of
+ * capture_walk_to_menu() caller. */
+static void
+walk_visit(fswalk_t *walk, const char path[], FswalkType type, void *arg)
+{
+	menu_feed_t *const feed = arg;
+	feed->visit(walk, path, type, feed->arg);
+}
+
+/* Implements fswalk_run() callback that passes results to the main thread. */
+static void
+walk_result(const char result[], void *arg)
+{
+	(void)add_feed_item(arg, result);
+}
+
+/* Implements fswalk_run() callback that checks whether the feed is still
+ * needed.  Returns non-zero if traversal should be stopped. */
+static int
+walk_cancelled(void *arg)
+{
+	menu_feed_t *const feed = arg;
+	int abandoned;
+
+	pthread_mutex_lock(&feed->lock);
+	abandoned = feed->abandoned;
+	pthread_mutex_unlock(&feed->lock);
+
+	return abandoned;
+}
+
+/* Queues item for the main thread.  Returns non-zero if the feed isn't needed
+ * anymore. */
+static int
+add_feed_item(menu_feed_t *feed, const char item[])
+{
+	int abandoned;
+
+	const size_t len = strlen(item) + 1U;
+
+	pthread_mutex_lock(&feed->lock);
+	abandoned = feed->abandoned;
+	if(!abandoned && feed->pending_len + len > feed->pending_size)
+	{
+		size_t new_size = MAX(feed->pending_size, FEED_PENDING_SIZE);
+		char *pending;
+		while(feed->pending_len + len > new_size)
+		{
+			new_size *= 2U;
+		}
+		pending = realloc(feed->pending, new_size);
+		if(pending != NULL)
+		{
+			feed->pending = pending;
+			feed->pending_size = new_size;
+		}
+	}
+	if(!abandoned && feed->pending_len + len <= feed->pending_size)
+	{
+		memcpy(feed->pending + feed->pending_len, item, len);
+		feed->pending_len += len;
+	}
+	pthread_mutex_unlock(&feed->lock);
+
+	return abandoned;
+}
+
+/* Marks the feed as finished freeing it if it was abandoned. */
+static void
+finish_feed(menu_feed_t *feed)
+{
+	int abandoned;
+
+	pthread_mutex_lock(&feed->lock);
+	abandoned = feed->abandoned;
+	feed->finished = 1;
+	pthread_mutex_unlock(&feed->lock);
+
+	if(abandoned)
+	{
+		free_feed(feed);
+	}
+}
+
+/* Retrieves current time.  Returns the time in milliseconds. */
+static uint64_t
+get_time_ms(void)
+{
+	struct timeval tv;
+	(void)gettimeofday(&tv, NULL);
+	return tv.tv_sec*1000ULL + tv.tv_usec/1000U;
+}
+
+/* Marks menu as cancelled if loading of its items was interrupted and displays
+ * it.  Returns non-zero if status bar message should be saved. */
+static int
+display_captured_menu(menu_info *m, FileView *view)
+{
+	if(ui_cancellation_requested())
+	{
+		append_to_string(&m->title, "(cancelled)");
+		append_to_string(&m->empty_msg, " (cancelled)");
+	}
+
+	return display_menu(m, view);
 }
 
 /* Replaces *str with a copy of the with string extended by the suffix.  *str
@@ -576,29 +1311,6 @@ append_to_string(char **str, const char suffix[])
 	}
 }
 
-/* Clones the line replacing all occurrences of horizontal tabulation character
- * with appropriate number of spaces.  The tab_stops parameter shows how many
- * character position are taken by one tabulation.  Returns newly allocated
- * string. */
-static char *
-expand_tabulation_a(const char line[], size_t tab_stops)
-{
-	const size_t tab_count = chars_in_str(line, '\t');
-	const size_t extra_line_len = tab_count*tab_stops;
-	const size_t expanded_line_len = (strlen(line) - tab_count) + extra_line_len;
-	char *const expanded_line = malloc(expanded_line_len + 1);
-
-	if(expanded_line != NULL)
-	{
-		const char *const end = expand_tabulation(line, (size_t)-1, tab_stops,
-				expanded_line);
-		assert(*end == '\0' && "The line should be processed till the end");
-		(void)end;
-	}
-
-	return expanded_line;
-}
-
 /* Returns number of c char occurrences in the s string. */
 static size_t
 chars_in_str(const char s[], char c)
@@ -617,7 +1329,7 @@ chars_in_str(const char s[], char c)
 int
 display_menu(menu_info *m, FileView *view)
 {
-	if(m->len < 1)
+	if(m->len < 1 && !menu_is_loading(m))
 	{
 		status_bar_message(m->empty_msg);
 		reset_popup_menu(m);
@@ -625,6 +1337,7 @@ display_menu(menu_info *m, FileView *view)
 	}
 	else
 	{
+		normalize_items(m);
 		setup_menu();
 		draw_menu(m);
 		move_to_menu_pos(m->pos, m);
@@ -633,6 +1346,25 @@ display_menu(menu_info *m, FileView *view)
 	}
 }
 
+/* Cuts items at the first end-of-line character, so that they don't need to be
+ * processed on every redraw.  Items loaded via a feed are already in this
+ * form. */
+static void
+normalize_items(menu_info *m)
+{
+	int i;
+
+	if(m->pool != NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < m->len; ++i)
+	{
+		m->items[i][strcspn(m->items[i], "\r\n")] = '\0';
+	}
+}
+
 char *
 prepare_targets(FileView *view)
 {
@@ -649,6 +1381,34 @@ prepare_targets(FileView *view)
 	return (vifm_chdir(flist_get_dir(view)) == 0) ? strdup(".") : NULL;
 }
 
+char **
+prepare_target_list(FileView *view, int *count)
+{
+	char **list = NULL;
+
+	*count = 0;
+
+	if(view->selected_files > 0)
+	{
+		dir_entry_t *entry = NULL;
+		while(iter_selected_entries(view, &entry))
+		{
+			char path[PATH_MAX];
+			get_short_path_of(view, entry, 0, sizeof(path), path);
+			*count = add_to_string_array(&list, *count, 1, path);
+		}
+		return list;
+	}
+
+	if(flist_custom_active(view) && vifm_chdir(flist_get_dir(view)) != 0)
+	{
+		return NULL;
+	}
+
+	*count = add_to_string_array(&list, *count, 1, ".");
+	return list;
+}
+
 KHandlerResponse
 filelist_khandler(menu_info *m, const wchar_t keys[])
 {
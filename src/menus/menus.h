@@ -23,6 +23,8 @@
 #include <stddef.h> /* wchar_t */
 
 #include "../ui/ui.h"
+#include "../utils/fswalk.h"
+#include "../utils/str_pool.h"
 
 enum
 {
@@ -57,6 +59,9 @@ typedef struct menu_info
 	char *args;
 	/* Contains titles of all menu items. */
 	char **items;
+	/* Pool from which items are allocated or NULL if they are allocated by
+	 * malloc(). */
+	str_pool_t *pool;
 	/* Contains additional data, associated with each of menu items, can be
 	 * NULL. */
 	char **data;
@@ -106,11 +111,42 @@ void goto_selected_directory(FileView *view, const char path[]);
  * returned. */
 char * prepare_targets(FileView *view);
 
-/* Runs external command and puts its output to the m menu.  Returns non-zero if
- * status bar message should be saved. */
+/* Same as prepare_targets(), but produces list of paths instead of a string
+ * for a shell.  On success returns newly allocated array of *count elements,
+ * which should be freed by the caller, otherwise NULL is returned. */
+char ** prepare_target_list(FileView *view, int *count);
+
+/* Runs external command and puts its output to the m menu.  Menu is displayed
+ * right away (unless it's done on startup) and is filled in background while
+ * it's shown.  Returns non-zero if status bar message should be
+ * saved. */
 int capture_output_to_menu(FileView *view, const char cmd[], int user_sh,
 		menu_info *m);
 
+/* Traverses file system trees starting at the roots (see fswalk_run()) and
+ * puts results reported by the visitor to the m menu.  Menu is displayed in the
+ * same way as by capture_output_to_menu().  Takes ownership of the arg, which
+ * is freed by free_arg once traversal is over.  Returns non-zero if status bar
+ * message should be saved. */
+int capture_walk_to_menu(FileView *view, char *roots[], int nroots, int flags,
+		fswalk_visit_func visit, void *arg, void (*free_arg)(void *arg),
+		menu_info *m);
+
+/* Makes menu item out of a line of output by expanding tabulation and cutting
+ * it at the first end-of-line character.  *buf of *buf_size bytes is reused
+ * between calls and should be freed by the caller.  Returns item allocated in
+ * the pool or NULL on error. */
+char * make_menu_item(str_pool_t *pool, const char line[], char **buf,
+		size_t *buf_size);
+
+/* Moves items loaded in background into the menu and redraws it if needed. */
+void menus_check_for_updates(void);
+
+/* Checks whether items of the menu are still being loaded, in which case it
+ * can be displayed while it's empty.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int menu_is_loading(const menu_info *m);
+
 /* Prepares menu, draws it and switches to the menu mode.  Returns non-zero if
  * status bar message should be saved. */
 int display_menu(menu_info *m, FileView *view);
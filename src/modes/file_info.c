@@ -41,12 +41,11 @@
 #include "../utils/fs.h"
 #include "../utils/macros.h"
 #include "../utils/str.h"
-#include "../utils/tree.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
+#include "../dircache.h"
 #include "../filelist.h"
 #include "../file_magic.h"
-#include "../status.h"
 #include "../types.h"
 #include "modes.h"
 
@@ -140,7 +139,8 @@ redraw_file_info_dialog(void)
 	{
 		char full_path[PATH_MAX];
 		get_current_full_path(view, sizeof(full_path), full_path);
-		tree_get_data(curr_stats.dirsize_cache, full_path, &size);
+		(void)dcache_get_size(full_path, cfg.dir_size_allocated,
+				&size);
 	}
 
 	if(size == 0)
@@ -38,6 +38,8 @@
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
 #include "../utils/macros.h"
+#include "../utils/str.h"
+#include "../utils/test_helpers.h"
 #include "../utils/utils.h"
 #include "../commands.h"
 #include "../filelist.h"
@@ -60,7 +62,6 @@ static void menu_select_range(int id, const cmd_info_t *cmd_info);
 static int skip_at_beginning(int id, const char *args);
 
 static int key_handler(wchar_t key);
-static void leave_menu_mode(void);
 static void cmd_ctrl_b(key_info_t key_info, keys_info_t *keys_info);
 static int can_scroll_menu_up(const menu_info *menu);
 static void cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info);
@@ -106,7 +107,10 @@ static int all_lines_visible(const menu_info *const menu);
 static int goto_cmd(const cmd_info_t *cmd_info);
 static int quit_cmd(const cmd_info_t *cmd_info);
 
-static int search_menu(menu_info *m, int start_pos);
+TSTATIC int search_menu(menu_info *m, int start_pos,
+		const char prev_regexp[]);
+static int item_matches(regex_t *re, const char item[], const char literal[],
+		int icase);
 static int search_menu_forwards(menu_info *m, int start_pos);
 static int search_menu_backwards(menu_info *m, int start_pos);
 static int get_match_index(const menu_info *m);
@@ -277,7 +281,7 @@ enter_menu_mode(menu_info *m, FileView *active_view)
 	if(curr_stats.load_stage < 2)
 		return;
 
-	assert(m->len > 0 && "Menu cannot be empty.");
+	assert((m->len > 0 || menu_is_loading(m)) && "Menu cannot be empty.");
 
 	werase(status_bar);
 
@@ -315,7 +319,7 @@ menu_redraw(void)
 	redraw_menu(menu);
 }
 
-static void
+void
 leave_menu_mode(void)
 {
 	reset_popup_menu(menu);
@@ -432,6 +436,12 @@ cmd_ctrl_m(key_info_t key_info, keys_info_t *keys_info)
 {
 	static menu_info *saved_menu;
 
+	/* There is nothing to pick in a menu that's being loaded yet. */
+	if(menu->len == 0)
+	{
+		return;
+	}
+
 	vle_mode_set(NORMAL_MODE, VMT_PRIMARY);
 	saved_menu = menu;
 	if(menu->execute_handler != NULL && menu->execute_handler(curr_view, menu))
@@ -533,6 +543,7 @@ cmd_question(key_info_t key_info, keys_info_t *keys_info)
 	last_search_backward = 1;
 	menu->match_dir = NONE;
 	free(menu->regexp);
+	menu->regexp = NULL;
 	enter_cmdline_mode(CLS_MENU_BSEARCH, L"", menu);
 }
 
@@ -668,7 +679,7 @@ pass_combination_to_khandler(const wchar_t keys[])
 {
 	KHandlerResponse handler_response;
 
-	if(menu->key_handler == NULL)
+	if(menu->key_handler == NULL || menu->len == 0)
 	{
 		return 0;
 	}
@@ -896,8 +907,14 @@ search_menu_list(const char pattern[], menu_info *m)
 
 	if(pattern != NULL)
 	{
+		char *const prev_regexp = m->regexp;
+		int err;
+
 		m->regexp = strdup(pattern);
-		if(search_menu(m, m->pos) != 0)
+		err = search_menu(m, m->pos, prev_regexp);
+		free(prev_regexp);
+
+		if(err != 0)
 		{
 			draw_menu(m);
 			move_to_menu_pos(m->pos, m);
@@ -924,46 +941,94 @@ search_menu_list(const char pattern[], menu_info *m)
 	return save;
 }
 
-/* Returns non-zero on error */
-static int
-search_menu(menu_info *m, int start_pos)
+/* Updates list of matches of the menu for its current regexp.  When previous
+ * regexp is given and the current one merely extends it, only items that
+ * matched previously are checked.  Returns non-zero on error. */
+TSTATIC int
+search_menu(menu_info *m, int start_pos, const char prev_regexp[])
 {
 	int cflags;
 	regex_t re;
 	int err;
+	int x;
+	const char *literal;
+	int icase;
+	const int narrow = m->matches != NULL
+	                && prev_regexp != NULL && prev_regexp[0] != '\0'
+	                && regexp_narrows(prev_regexp, get_regexp_cflags(prev_regexp),
+	                                  m->regexp, get_regexp_cflags(m->regexp));
 
 	if(m->matches == NULL)
 	{
 		m->matches = reallocarray(NULL, m->len, sizeof(int));
 	}
 
-	memset(m->matches, 0, sizeof(int)*m->len);
-	m->matching_entries = 0;
+	if(!narrow || m->regexp[0] == '\0')
+	{
+		memset(m->matches, 0, sizeof(int)*m->len);
+		m->matching_entries = 0;
+	}
 
 	if(m->regexp[0] == '\0')
 		return 0;
 
 	cflags = get_regexp_cflags(m->regexp);
-	if((err = regcomp(&re, m->regexp, cflags)) == 0)
+	if((err = regcomp(&re, m->regexp, cflags)) != 0)
+	{
+		status_bar_errorf("Regexp error: %s", get_regexp_error(err, &re));
+		regfree(&re);
+		return -1;
+	}
+
+	icase = (cflags & REG_ICASE);
+	literal = regexp_is_literal(m->regexp) ? m->regexp : NULL;
+	if(literal != NULL && icase && !is_ascii(literal))
+	{
+		literal = NULL;
+	}
+
+	for(x = 0; x < m->len; x++)
 	{
-		int x;
-		for(x = 0; x < m->len; x++)
+		if(narrow)
+		{
+			if(m->matches[x] &&
+					!item_matches(&re, m->items[x], literal, icase))
+			{
+				m->matches[x] = 0;
+				m->matching_entries--;
+			}
+		}
+		else if(item_matches(&re, m->items[x], literal, icase))
 		{
-			if(regexec(&re, m->items[x], 0, NULL, 0) != 0)
-				continue;
 			m->matches[x] = 1;
-
 			m->matching_entries++;
 		}
-		regfree(&re);
-		return 0;
 	}
-	else
+
+	regfree(&re);
+	return 0;
+}
+
+/* Checks whether menu item matches the regular expression.  literal is
+ * non-NULL when the expression is a plain string, in which case it's looked up
+ * directly.  Returns non-zero if so, otherwise zero is returned. */
+static int
+item_matches(regex_t *re, const char item[], const char literal[], int icase)
+{
+	if(literal != NULL)
 	{
-		status_bar_errorf("Regexp error: %s", get_regexp_error(err, &re));
-		regfree(&re);
-		return -1;
+		if(!icase)
+		{
+			return strstr(item, literal) != NULL;
+		}
+		/* strcasestr() ignores case of ASCII letters only. */
+		if(is_ascii(item))
+		{
+			return strcasestr(item, literal) != NULL;
+		}
 	}
+
+	return regexec(re, item, 0, NULL, 0) == 0;
 }
 
 static int
@@ -22,12 +22,16 @@
 
 #include "../ui/ui.h"
 #include "../menus/menus.h"
+#include "../utils/test_helpers.h"
 
 /* Initiailizes menu mode. */
 void init_menu_mode(void);
 
 void enter_menu_mode(menu_info *m, FileView *active_view);
 
+/* Leaves menu mode freeing the menu. */
+void leave_menu_mode(void);
+
 void menu_pre(void);
 
 /* Performs post-actions (at the end of input processing loop) for menus. */
@@ -58,6 +62,10 @@ int get_last_visible_line(const menu_info *m);
 /* Prints results or error message about search operation to the user. */
 void menu_print_search_msg(const menu_info *m);
 
+TSTATIC_DEFS(
+	int search_menu(menu_info *m, int start_pos, const char prev_regexp[]);
+)
+
 #endif /* VIFM__MODES__MENU_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
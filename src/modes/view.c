@@ -25,7 +25,8 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* ptrdiff_t size_t */
-#include <string.h> /* memset() strdup() */
+#include <stdint.h> /* intptr_t */
+#include <string.h> /* memchr() memset() strdup() strlen() */
 #include <stdio.h>  /* fclose() snprintf() */
 #include <stdlib.h> /* free() */
 
@@ -36,14 +37,15 @@
 #include "../engine/keys.h"
 #include "../engine/mode.h"
 #include "../modes/dialogs/msg_dialog.h"
+#include "../ui/cancellation.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
 #include "../utils/filemon.h"
 #include "../utils/fs.h"
+#include "../utils/line_index.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
-#include "../utils/string_array.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../color_manager.h"
@@ -64,6 +66,18 @@
 /* Column at which view content should be displayed. */
 #define COL 1
 
+/* Maximum length of a UTF-8 character. */
+#define MAX_CHAR_LEN 4
+
+/* Number of bytes of a line retrieved per screen cell, which leaves room for
+ * multibyte characters and escape sequences.  Only beginning of a line that
+ * can fit on the screen is retrieved. */
+#define BYTES_PER_CELL 16
+
+/* How long to wait (in milliseconds) for lines to be indexed before offering
+ * to cancel waiting. */
+#define QUIET_WAIT_MS 100
+
 /* Named boolean values of "silent" parameter for better readability. */
 enum
 {
@@ -73,7 +87,10 @@ enum
 
 typedef struct
 {
-	char **lines;
+	line_index_t *lines; /* Lines of the file, which are indexed gradually. */
+	int tab_stop;        /* Value of 'tabstop' used to measure lines. */
+	int bottom;          /* Virtual line that was the bottom of the view while
+	                        lines were still being indexed, or -1. */
 	int (*widths)[2];
 	int nlines;
 	int nlinesv;
@@ -112,10 +129,16 @@ static void init_view_info(view_info_t *vi);
 static void free_view_info(view_info_t *vi);
 static void redraw(void);
 static void calc_vlines(void);
-static void calc_vlines_wrapped(view_info_t *vi);
-static void calc_vlines_non_wrapped(view_info_t *vi);
+static void calc_vlines_wrapped(view_info_t *vi, int from);
+static void calc_vlines_non_wrapped(view_info_t *vi, int from);
+static int update_lines(view_info_t *vi, int nlines);
+static int wait_for_lines(view_info_t *vi, int nlines);
+static const char * get_line(const view_info_t *vi, int n);
+static void forget_lines(view_info_t *vi, int nlines);
 static void draw(void);
 static int get_part(const char line[], int offset, size_t max_len, char part[]);
+static int get_vline_part(const view_info_t *vi, int l, int n, char part[]);
+static int get_last_vline(const view_info_t *vi, int l);
 static void display_error(const char error_msg[]);
 static void cmd_ctrl_l(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_wH(key_info_t key_info, keys_info_t *keys_info);
@@ -150,6 +173,8 @@ static void cmd_R(key_info_t key_info, keys_info_t *keys_info);
 static int load_view_data(view_info_t *vi, const char action[],
 		const char file_to_view[], int silent);
 static int get_view_data(view_info_t *vi, const char file_to_view[]);
+static size_t measure_line(const char text[], size_t len, int last,
+		size_t *width, void *arg);
 static void replace_vi(view_info_t *const orig, view_info_t *const new);
 static void cmd_b(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_d(key_info_t key_info, keys_info_t *keys_info);
@@ -174,6 +199,7 @@ static void update_with_win(key_info_t *const key_info);
 static int is_trying_the_same_file(void);
 static int get_file_to_explore(const FileView *view, char buf[],
 		size_t buf_len);
+static int index_more(view_info_t *vi);
 static int forward_if_changed(view_info_t *vi);
 static int scroll_to_bottom(view_info_t *vi);
 static void reload_view(view_info_t *vi, int silent);
@@ -402,8 +428,15 @@ view_post(void)
 void
 view_ruler_update(void)
 {
-	char buf[POS_WIN_MIN_WIDTH + 1];
-	snprintf(buf, sizeof(buf), "%d-%d ", vi->line + 1, vi->nlines);
+	/* Two numbers, separator, mark of incomplete index and trailing space. */
+	char buf[2*11 + 3 + 1];
+	int complete = 1;
+	if(vi->lines != NULL)
+	{
+		(void)line_index_count(vi->lines, &complete);
+	}
+	snprintf(buf, sizeof(buf), "%d-%d%s ", vi->line + 1, vi->nlines,
+			complete ? "" : "+");
 
 	ui_ruler_set(buf);
 }
@@ -496,14 +529,16 @@ init_view_info(view_info_t *vi)
 	vi->width = -1;
 	vi->last_search_backward = -1;
 	vi->search_repeat = NO_COUNT_GIVEN;
+	vi->bottom = -1;
 }
 
 /* Frees all resources allocated by view_info_t structure instance. */
 static void
 free_view_info(view_info_t *vi)
 {
-	free_string_array(vi->lines, vi->nlines);
+	line_index_free(vi->lines);
 	free(vi->widths);
+	filemon_reset(&vi->file_mon);
 	if(vi->last_search_backward != -1)
 	{
 		regfree(&vi->re);
@@ -524,6 +559,21 @@ redraw(void)
 static void
 calc_vlines(void)
 {
+	int remeasured = 0;
+
+	/* Lines are measured while they are indexed, so the index has to process the
+	 * text anew to update their widths. */
+	if(vi->lines != NULL && !vi->graphics && vi->tab_stop != cfg.tab_stop)
+	{
+		vi->tab_stop = cfg.tab_stop;
+		line_index_remeasure(vi->lines, (void *)(intptr_t)cfg.tab_stop);
+		vi->nlines = 0;
+		vi->width = -1;
+		(void)update_lines(vi, vi->line + vi->view->window_rows);
+		vi->line = MAX(MIN(vi->line, vi->nlines - 1), 0);
+		remeasured = 1;
+	}
+
 	if((int)vi->view->window_width - 1 == vi->width &&
 			vi->wrap == cfg.wrap_quick_view)
 	{
@@ -535,42 +585,166 @@ calc_vlines(void)
 
 	if(vi->wrap)
 	{
-		calc_vlines_wrapped(vi);
+		calc_vlines_wrapped(vi, 0);
 	}
 	else
 	{
-		calc_vlines_non_wrapped(vi);
+		calc_vlines_non_wrapped(vi, 0);
+	}
+
+	if(remeasured)
+	{
+		vi->linev = (vi->nlines == 0) ? 0 : vi->widths[vi->line][0];
 	}
 }
 
-/* Recalculates virtual lines of a view with line wrapping. */
+/* Recalculates virtual lines of a view with line wrapping starting with the
+ * specified line. */
 static void
-calc_vlines_wrapped(view_info_t *vi)
+calc_vlines_wrapped(view_info_t *vi, int from)
 {
 	int i;
-	vi->nlinesv = 0;
-	for(i = 0; i < vi->nlines; i++)
+	if(from == 0)
+	{
+		vi->nlinesv = 0;
+	}
+	for(i = from; i < vi->nlines; i++)
 	{
 		vi->widths[i][0] = vi->nlinesv++;
-		vi->widths[i][1] = utf8_strsw_with_tabs(vi->lines[i], cfg.tab_stop) -
-			esc_str_overhead(vi->lines[i]);
+		vi->widths[i][1] = line_index_width(vi->lines, i);
 		vi->nlinesv += vi->widths[i][1]/vi->width;
 	}
 }
 
-/* Recalculates virtual lines of a view without line wrapping. */
+/* Recalculates virtual lines of a view without line wrapping starting with the
+ * specified line. */
 static void
-calc_vlines_non_wrapped(view_info_t *vi)
+calc_vlines_non_wrapped(view_info_t *vi, int from)
 {
 	int i;
 	vi->nlinesv = vi->nlines;
-	for(i = 0; i < vi->nlines; i++)
+	for(i = from; i < vi->nlines; i++)
 	{
 		vi->widths[i][0] = i;
 		vi->widths[i][1] = vi->width;
 	}
 }
 
+/* Drops information about lines of the view starting with the specified one,
+ * so that it's recalculated by update_lines(). */
+static void
+forget_lines(view_info_t *vi, int nlines)
+{
+	if(nlines >= vi->nlines)
+	{
+		return;
+	}
+
+	vi->nlines = nlines;
+	vi->nlinesv = nlines;
+	if(vi->wrap && vi->width != -1 && nlines != 0)
+	{
+		const int last = nlines - 1;
+		vi->nlinesv = vi->widths[last][0] + 1 + vi->widths[last][1]/vi->width;
+	}
+}
+
+/* Waits until at least nlines lines of the view are indexed (negative value
+ * means all of them, zero means no waiting) and updates information about
+ * lines of the view.  Waiting can be cancelled by the user.  Returns non-zero
+ * if number of lines has changed. */
+static int
+update_lines(view_info_t *vi, int nlines)
+{
+	int count, complete;
+	int from;
+	void *p;
+
+	if(vi->lines == NULL)
+	{
+		return 0;
+	}
+
+	if(nlines != 0)
+	{
+		(void)wait_for_lines(vi, nlines);
+	}
+
+	count = line_index_count(vi->lines, &complete);
+	if(count == vi->nlines)
+	{
+		return 0;
+	}
+
+	p = reallocarray(vi->widths, count, sizeof(*vi->widths));
+	if(p == NULL)
+	{
+		return 0;
+	}
+	vi->widths = p;
+
+	from = vi->nlines;
+	vi->nlines = count;
+
+	/* Otherwise all virtual lines will be calculated on redraw. */
+	if(vi->width != -1)
+	{
+		if(vi->wrap)
+		{
+			calc_vlines_wrapped(vi, from);
+		}
+		else
+		{
+			calc_vlines_non_wrapped(vi, from);
+		}
+	}
+	return 1;
+}
+
+/* Waits until at least nlines lines of the view are indexed (negative value
+ * means all of them).  Waiting that takes long can be cancelled by the user.
+ * Returns non-zero if waiting was cancelled, otherwise zero is returned. */
+static int
+wait_for_lines(view_info_t *vi, int nlines)
+{
+	int complete;
+	int cancelled;
+	int count = line_index_wait_for(vi->lines, nlines, QUIET_WAIT_MS);
+	(void)line_index_count(vi->lines, &complete);
+	if(complete || (nlines >= 0 && count >= nlines))
+	{
+		return 0;
+	}
+
+	ui_sb_quick_msgf("%s", "Indexing lines... (press Ctrl-C to cancel)");
+
+	ui_cancellation_reset();
+	ui_cancellation_enable();
+	do
+	{
+		count = line_index_wait_for(vi->lines, nlines, QUIET_WAIT_MS);
+		(void)line_index_count(vi->lines, &complete);
+	}
+	while(!complete && (nlines < 0 || count < nlines) &&
+			!ui_cancellation_requested());
+	cancelled = ui_cancellation_requested();
+	ui_cancellation_disable();
+
+	clean_status_bar();
+	return cancelled;
+}
+
+/* Retrieves beginning of the line that can fit on the screen.  The n must be
+ * less than number of lines of the view.  Returns pointer to the line or NULL
+ * on error. */
+static const char *
+get_line(const view_info_t *vi, int n)
+{
+	const size_t max_len =
+		(size_t)vi->view->window_width*vi->view->window_rows*BYTES_PER_CELL;
+	return line_index_get(vi->lines, n, max_len);
+}
+
 static void
 draw(void)
 {
@@ -578,8 +752,8 @@ draw(void)
 	const col_scheme_t *cs = ui_view_get_cs(vi->view);
 	const int height = vi->view->window_rows - 1;
 	const int width = vi->view->window_width - 1;
-	const int max_l = MIN(vi->line + height, vi->nlines);
 	const int searched = (vi->last_search_backward != -1);
+	int max_l;
 	esc_state state;
 
 	if(vi->graphics)
@@ -588,11 +762,17 @@ draw(void)
 		cmd = (cmd != NULL) ? ma_get_clean_cmd(cmd) : NULL;
 		qv_cleanup(vi->view, cmd);
 
-		free_string_array(vi->lines, vi->nlines);
+		line_index_free(vi->lines);
+		vi->lines = NULL;
+		vi->nlines = 0;
 		(void)get_view_data(vi, vi->filename);
+		(void)update_lines(vi, -1);
 		return;
 	}
 
+	(void)update_lines(vi, vi->line + height);
+	max_l = MIN(vi->line + height, vi->nlines);
+
 	esc_state_init(&state, &cs->color[WIN_COLOR]);
 
 	ui_view_erase(vi->view);
@@ -601,8 +781,17 @@ draw(void)
 	{
 		int offset = 0;
 		int t = 0;
-		char *const line = vi->lines[l];
-		char *p = searched ? esc_highlight_pattern(line, &vi->re) : line;
+		const char *const line = get_line(vi, l);
+		char *highlighted;
+		const char *p;
+
+		if(line == NULL)
+		{
+			continue;
+		}
+
+		highlighted = searched ? esc_highlight_pattern(line, &vi->re) : NULL;
+		p = searched ? highlighted : line;
 		do
 		{
 			int printed;
@@ -613,10 +802,7 @@ draw(void)
 			t++;
 		}
 		while(vi->wrap && p[offset] != '\0' && vl < height);
-		if(searched)
-		{
-			free(p);
-		}
+		free(highlighted);
 	}
 	refresh_view_win(vi->view);
 }
@@ -879,6 +1065,8 @@ cmd_percent(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count > 100)
 		key_info.count = 100;
 
+	(void)update_lines(vi, -1);
+
 	vi->line = (key_info.count*vi->nlinesv)/100;
 	if(vi->line >= vi->nlines)
 		vi->line = vi->nlines - 1;
@@ -1009,15 +1197,9 @@ load_view_data(view_info_t *vi, const char action[], const char file_to_view[],
 			return 1;
 	}
 
-	vi->widths = reallocarray(NULL, vi->nlines, sizeof(*vi->widths));
-	if(vi->widths == NULL)
-	{
-		free_string_array(vi->lines, vi->nlines);
-		vi->lines = NULL;
-		vi->nlines = 0;
-		show_error_msg(action, "Not enough memory");
-		return 1;
-	}
+	/* Index enough lines to fill the window, the rest is indexed in
+	 * background. */
+	(void)update_lines(vi, (vi->view == NULL) ? 1 : vi->view->window_rows);
 
 	return 0;
 }
@@ -1031,6 +1213,8 @@ get_view_data(view_info_t *vi, const char file_to_view[])
 	FILE *fp;
 	const char *const viewer = gv_get_viewer(file_to_view);
 
+	vi->tab_stop = cfg.tab_stop;
+
 	if(is_null_or_empty(viewer))
 	{
 		if(is_dir(file_to_view))
@@ -1038,13 +1222,12 @@ get_view_data(view_info_t *vi, const char file_to_view[])
 			return 1;
 		}
 
-		fp = os_fopen(file_to_view, "rb");
-		if(fp == NULL)
+		vi->lines = line_index_from_file(file_to_view, &measure_line,
+				(void *)(intptr_t)cfg.tab_stop);
+		if(vi->lines == NULL)
 		{
 			return 2;
 		}
-
-		vi->lines = read_file_lines(fp, &vi->nlines);
 	}
 	else
 	{
@@ -1075,19 +1258,62 @@ get_view_data(view_info_t *vi, const char file_to_view[])
 			vi->graphics = 1;
 		}
 
-		vi->lines = read_stream_lines(fp, &vi->nlines);
+		vi->lines = line_index_from_stream(fp, &measure_line,
+				(void *)(intptr_t)cfg.tab_stop);
+		fclose(fp);
 	}
 
-	fclose(fp);
-
-	if(vi->lines == NULL || vi->nlines == 0)
+	if(vi->lines == NULL || line_index_wait(vi->lines, 1) == 0)
 	{
+		line_index_free(vi->lines);
+		vi->lines = NULL;
 		return 4;
 	}
 
 	return 0;
 }
 
+/* Computes width of a part of a line of a file on the screen.  Characters and
+ * escape sequences that might continue in the next part are left unprocessed.
+ * The arg is value of 'tabstop' option.  Returns number of processed bytes. */
+static size_t
+measure_line(const char text[], size_t len, int last, size_t *width,
+		void *arg)
+{
+	const int tab_stop = (intptr_t)arg;
+	size_t i = 0U;
+
+	while(i < len)
+	{
+		if(!last && len - i < MAX_CHAR_LEN)
+		{
+			break;
+		}
+
+		if(text[i] == '\033')
+		{
+			const char *const end = memchr(text + i, 'm', len - i);
+			if(end == NULL && !last && len - i < LINE_INDEX_MAX_TAIL)
+			{
+				break;
+			}
+			/* Escape sequences take no space on the screen. */
+			i = (end == NULL) ? len : (size_t)(end - text) + 1U;
+		}
+		else if(text[i] == '\t')
+		{
+			*width += tab_stop - *width%tab_stop;
+			++i;
+		}
+		else
+		{
+			*width += utf8_chrsw(text + i);
+			i += utf8_chrw(text + i);
+		}
+	}
+	return i;
+}
+
 /* Replaces view_info_t structure with another one preserving as much as
  * possible. */
 static void
@@ -1109,7 +1335,10 @@ replace_vi(view_info_t *const orig, view_info_t *const new)
 	new->linev = orig->linev;
 	new->view = orig->view;
 	new->auto_forward = orig->auto_forward;
-	filemon_assign(&new->file_mon, &orig->file_mon);
+
+	/* Move the monitor, so that it's not released along with the orig. */
+	new->file_mon = orig->file_mon;
+	orig->file_mon.type = FMT_UNINITIALIZED;
 
 	free_view_info(orig);
 	*orig = *new;
@@ -1152,6 +1381,8 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
 
+	(void)update_lines(vi, key_info.count + vi->view->window_rows);
+
 	key_info.count = MIN(vi->nlinesv - (vi->view->window_rows - 1),
 			key_info.count);
 	key_info.count = MAX(1, key_info.count);
@@ -1166,6 +1397,9 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_j(key_info_t key_info, keys_info_t *keys_info)
 {
+	const int count = (key_info.count == NO_COUNT_GIVEN) ? 1 : key_info.count;
+	(void)update_lines(vi, vi->line + count + vi->view->window_rows);
+
 	if(key_info.reg == NO_REG_GIVEN)
 	{
 		if((vi->linev + 1) + (vi->view->window_rows - 1) > vi->nlinesv)
@@ -1264,7 +1498,6 @@ search(int repeat_count, int backward)
 static void
 find_previous(int vline_offset)
 {
-	int i;
 	int offset = 0;
 	char buf[(vi->view->window_width - 1)*4];
 	int vl, l;
@@ -1275,8 +1508,7 @@ find_previous(int vline_offset)
 	if(l > 0 && vl < vi->widths[l][0])
 		l--;
 
-	for(i = 0; i <= vl - vi->widths[l][0]; i++)
-		offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+	offset = get_vline_part(vi, l, vl - vi->widths[l][0], buf);
 
 	/* Don't stop until we go above first virtual line of the first line. */
 	while(l >= 0 && vl >= 0)
@@ -1290,13 +1522,20 @@ find_previous(int vline_offset)
 		if(l > 0 && vl - 1 < vi->widths[l][0])
 		{
 			l--;
-			offset = 0;
-			for(i = 0; i <= vl - 1 - vi->widths[l][0]; i++)
-				offset = get_part(vi->lines[l], offset, vi->view->window_width - 1,
-						buf);
+			offset = get_vline_part(vi, l, vl - 1 - vi->widths[l][0], buf);
 		}
 		else
-			offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+		{
+			const int prev_offset = offset;
+			offset = get_part(get_line(vi, l), offset, vi->view->window_width - 1,
+					buf);
+			/* Only beginning of a huge line is retrieved, there is nothing to search
+			 * in the rest of it. */
+			if(offset == prev_offset && vl > vi->widths[l][0])
+			{
+				vl = vi->widths[l][0] + 1;
+			}
+		}
 		vl--;
 	}
 	draw();
@@ -1309,10 +1548,14 @@ find_previous(int vline_offset)
 static void
 find_next(void)
 {
-	int i;
 	int offset = 0;
 	char buf[(vi->view->window_width - 1)*4];
 	int vl, l;
+	int cancelled;
+
+	/* Lines are searched as they are indexed. */
+	cancelled = wait_for_lines(vi, vi->line + 2);
+	(void)update_lines(vi, 0);
 
 	vl = vi->linev + 1;
 	l = vi->line;
@@ -1320,17 +1563,23 @@ find_next(void)
 	if(l < vi->nlines - 1 && vl == vi->widths[l + 1][0])
 		l++;
 
-	for(i = 0; i <= vl - vi->widths[l][0]; i++)
-		offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+	offset = get_vline_part(vi, l, vl - vi->widths[l][0], buf);
 
 	while(l < vi->nlines)
 	{
+		int prev_offset;
+
 		if(regexec(&vi->re, buf, 0, NULL, 0) == 0)
 		{
 			vi->linev = vl;
 			vi->line = l;
 			break;
 		}
+		if(l == vi->nlines - 1 && !cancelled)
+		{
+			cancelled = wait_for_lines(vi, vi->nlines + 1);
+			(void)update_lines(vi, 0);
+		}
 		if(l < vi->nlines && (l == vi->nlines - 1 ||
 				vl + 1 >= vi->widths[l + 1][0]))
 		{
@@ -1339,7 +1588,15 @@ find_next(void)
 			l++;
 			offset = 0;
 		}
-		offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+		prev_offset = offset;
+		offset = get_part(get_line(vi, l), offset, vi->view->window_width - 1,
+				buf);
+		/* Only beginning of a huge line is retrieved, there is nothing to search in
+		 * the rest of it. */
+		if(offset == prev_offset && offset != 0)
+		{
+			vl = MAX(vl, get_last_vline(vi, l) - 1);
+		}
 		vl++;
 	}
 	draw();
@@ -1349,6 +1606,36 @@ find_next(void)
 	}
 }
 
+/* Extracts part of the line that is displayed at its n-th virtual line.
+ * Returns offset in the line right after the part. */
+static int
+get_vline_part(const view_info_t *vi, int l, int n, char part[])
+{
+	int i;
+	int offset = 0;
+	const char *const line = get_line(vi, l);
+
+	for(i = 0; i <= n; ++i)
+	{
+		const int prev_offset = offset;
+		offset = get_part(line, offset, vi->view->window_width - 1, part);
+		/* The rest of parts are empty. */
+		if(offset == prev_offset)
+		{
+			break;
+		}
+	}
+	return offset;
+}
+
+/* Retrieves number of the last virtual line of the line.  Returns the
+ * number. */
+static int
+get_last_vline(const view_info_t *vi, int l)
+{
+	return (l < vi->nlines - 1) ? vi->widths[l + 1][0] - 1 : vi->nlinesv - 1;
+}
+
 /* Extracts part of the line replacing all occurrences of horizontal tabulation
  * character with appropriate number of spaces.  The offset specifies beginning
  * of the part in the line.  The max_len parameter designates the maximum number
@@ -1357,10 +1644,23 @@ find_next(void)
 static int
 get_part(const char line[], int offset, size_t max_len, char part[])
 {
-	char *const no_esc = esc_remove(line);
-	const char *const begin = no_esc + offset;
-	const char *const end = expand_tabulation(begin, max_len, cfg.tab_stop, part);
-	const ptrdiff_t processed_chars = end - no_esc;
+	char *no_esc;
+	const char *begin;
+	const char *end;
+	ptrdiff_t processed_chars;
+
+	/* Line can't be retrieved if file was changed or on memory error. */
+	if(line == NULL)
+	{
+		part[0] = '\0';
+		return offset;
+	}
+
+	no_esc = esc_remove(line);
+	/* Line could have become shorter since the previous part was taken. */
+	begin = no_esc + MIN((size_t)offset, strlen(no_esc));
+	end = expand_tabulation(begin, max_len, cfg.tab_stop, part);
+	processed_chars = end - no_esc;
 	free(no_esc);
 	return processed_chars;
 }
@@ -1527,6 +1827,10 @@ view_check_for_updates(void)
 {
 	int need_redraw = 0;
 
+	need_redraw += index_more(&view_info[VI_QV]);
+	need_redraw += index_more(&view_info[VI_LWIN]);
+	need_redraw += index_more(&view_info[VI_RWIN]);
+
 	need_redraw += forward_if_changed(&view_info[VI_QV]);
 	need_redraw += forward_if_changed(&view_info[VI_LWIN]);
 	need_redraw += forward_if_changed(&view_info[VI_RWIN]);
@@ -1537,18 +1841,46 @@ view_check_for_updates(void)
 	}
 }
 
+/* Picks up lines that were indexed in background since the last time.  Returns
+ * non-zero if view needs to be redrawn, otherwise zero is returned. */
+static int
+index_more(view_info_t *vi)
+{
+	if(!update_lines(vi, 0))
+	{
+		return 0;
+	}
+
+	/* Keep following the bottom unless the view was scrolled since then. */
+	if(vi->bottom != -1 && vi->bottom == vi->linev)
+	{
+		return scroll_to_bottom(vi) || vle_mode_is(VIEW_MODE);
+	}
+
+	/* Update number of lines in the ruler. */
+	return vle_mode_is(VIEW_MODE);
+}
+
 /* Forwards the view if underlying file changed.  Returns non-zero if reload
  * occurred, otherwise zero is returned. */
 static int
 forward_if_changed(view_info_t *vi)
 {
 	filemon_t mon;
+	int first_changed;
+	int changed = 0;
 
 	if(!vi->auto_forward)
 	{
 		return 0;
 	}
 
+	/* This doesn't query file system if change notifications are available. */
+	if(!filemon_file_changed(&vi->file_mon))
+	{
+		return 0;
+	}
+
 	if(filemon_from_file(vi->filename, &mon) != 0)
 	{
 		return 0;
@@ -1559,18 +1891,43 @@ forward_if_changed(view_info_t *vi)
 		return 0;
 	}
 
-	filemon_assign(&vi->file_mon, &mon);
-	reload_view(vi, SILENT);
-	return scroll_to_bottom(vi);
+	/* Keeps the same notification descriptor unless the file was replaced. */
+	(void)filemon_watch_file(vi->filename, &vi->file_mon);
+
+	/* Only appended part of the file is processed unless the file was replaced
+	 * or truncated. */
+	if(vi->lines != NULL &&
+			line_index_follow(vi->lines, vi->filename, &first_changed) == 0)
+	{
+		forget_lines(vi, first_changed);
+		changed = update_lines(vi, 0);
+	}
+	else
+	{
+		reload_view(vi, SILENT);
+	}
+
+	return scroll_to_bottom(vi) || changed;
 }
 
-/* Scrolls view to the bottom if there is any room for that.  Returns non-zero
- * if position was changed, otherwise zero is returned. */
+/* Scrolls view to the bottom if there is any room for that.  Only lines that
+ * are indexed so far are considered, the view keeps following the bottom as
+ * more lines are indexed until the position is changed.  Returns non-zero if
+ * position was changed, otherwise zero is returned. */
 static int
 scroll_to_bottom(view_info_t *vi)
 {
+	int complete = 1;
+
+	(void)update_lines(vi, 0);
+	if(vi->lines != NULL)
+	{
+		(void)line_index_count(vi->lines, &complete);
+	}
+
 	if(vi->linev + 1 + vi->view->window_rows - 1 > vi->nlinesv)
 	{
+		vi->bottom = complete ? -1 : vi->linev;
 		return 0;
 	}
 
@@ -1583,6 +1940,7 @@ scroll_to_bottom(view_info_t *vi)
 		}
 	}
 
+	vi->bottom = complete ? -1 : vi->linev;
 	return 1;
 }
 
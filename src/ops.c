@@ -179,7 +179,7 @@ ops_enqueue(ops_t *ops, const char src[], const char dst[])
 	}
 
 	/* Check once and cache result, it should be the same for each invocation. */
-	if(ops->estim->total_items == 0)
+	if(ops->total == 1)
 	{
 		switch(ops->main_op)
 		{
@@ -215,7 +215,9 @@ ops_enqueue(ops_t *ops, const char src[], const char dst[])
 		}
 	}
 
-	ioeta_calculate(ops->estim, src, ops->shallow_eta);
+	/* Operation doesn't wait for the whole tree to be traversed, estimates
+	 * converge as it proceeds. */
+	ioeta_calculate_bg(ops->estim, src, ops->shallow_eta);
 }
 
 void
@@ -879,6 +881,7 @@ exec_io_op(ops_t *ops, int (*func)(io_args_t *const), io_args_t *const args)
 
 	args->estim = (ops == NULL) ? NULL : ops->estim;
 	args->confirm = &confirm_overwrite;
+	args->max_threads = cfg.io_threads;
 
 	if(ops != NULL)
 	{
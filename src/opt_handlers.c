@@ -56,6 +56,10 @@
 /* Default value of 'viewcolumns' option, used when it's empty. */
 #define DEFAULT_VIEW_COLUMNS "-{name},{}"
 
+/* Upper limit on value of 'dirloadthreads'.  Stat'ing is bound by I/O, more
+ * threads than this only waste resources. */
+#define MAX_DIR_LOAD_THREADS 64
+
 typedef union
 {
 	int *bool_val;
@@ -104,6 +108,8 @@ static const char * pick_out_decoration(const char classify_item[],
 static void columns_handler(OPT_OP op, optval_t val);
 static void confirm_handler(OPT_OP op, optval_t val);
 static void cpoptions_handler(OPT_OP op, optval_t val);
+static void dirloadthreads_handler(OPT_OP op, optval_t val);
+static void dirsizemode_handler(OPT_OP op, optval_t val);
 static void dotdirs_handler(OPT_OP op, optval_t val);
 static void fastrun_handler(OPT_OP op, optval_t val);
 static void fillchars_handler(OPT_OP op, optval_t val);
@@ -118,6 +124,7 @@ static void hlsearch_handler(OPT_OP op, optval_t val);
 static void iec_handler(OPT_OP op, optval_t val);
 static void ignorecase_handler(OPT_OP op, optval_t val);
 static void incsearch_handler(OPT_OP op, optval_t val);
+static void iothreads_handler(OPT_OP op, optval_t val);
 static int parse_range(const char range[], int *from, int *to);
 static int parse_endpoint(const char **str, int *endpoint);
 static void laststatus_handler(OPT_OP op, optval_t val);
@@ -254,6 +261,12 @@ static const char *sort_types[] = {
 };
 ARRAY_GUARD(sort_types, SK_COUNT*3);
 
+/* Possible values of 'dirsizemode' option. */
+static const char *dirsizemode_enum[] = {
+	"apparent",
+	"allocated",
+};
+
 /* Possible values of 'sortorder' option. */
 static const char *sortorder_enum[] = {
 	"ascending",
@@ -329,6 +342,15 @@ options[] = {
 	  OPT_CHARSET, cpoptions_count, &cpoptions_vals, &cpoptions_handler, NULL,
 	  { .init = &init_cpoptions },
 	},
+	{ "dirloadthreads", "",
+	  OPT_INT, 0, NULL, &dirloadthreads_handler, NULL,
+	  { .ref.int_val = &cfg.dir_load_threads },
+	},
+	{ "dirsizemode", "",
+	  OPT_ENUM, ARRAY_LEN(dirsizemode_enum), dirsizemode_enum,
+	  &dirsizemode_handler, NULL,
+	  { .ref.enum_item = &cfg.dir_size_allocated },
+	},
 	{ "dotdirs", "",
 	  OPT_SET, ARRAY_LEN(dotdirs_vals), dotdirs_vals, &dotdirs_handler, NULL,
 	  { .ref.set_items = &cfg.dot_dirs },
@@ -382,6 +404,10 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &incsearch_handler , NULL,
 	  { .ref.bool_val = &cfg.inc_search },
 	},
+	{ "iothreads", "",
+	  OPT_INT, 0, NULL, &iothreads_handler, NULL,
+	  { .ref.int_val = &cfg.io_threads },
+	},
 	{ "laststatus", "ls",
 	  OPT_BOOL, 0, NULL, &laststatus_handler, NULL,
 	  { .ref.bool_val = &cfg.display_statusline },
@@ -1146,6 +1172,40 @@ cpoptions_handler(OPT_OP op, optval_t val)
 	}
 }
 
+/* Limits number of threads used to read meta-data of files on loading
+ * directories. */
+static void
+dirloadthreads_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val <= 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be > 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 1;
+		set_option("dirloadthreads", val, OPT_GLOBAL);
+		return;
+	}
+
+	if(val.int_val > MAX_DIR_LOAD_THREADS)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be <= %d: %d",
+				MAX_DIR_LOAD_THREADS, val.int_val);
+		error = 1;
+		val.int_val = MAX_DIR_LOAD_THREADS;
+		set_option("dirloadthreads", val, OPT_GLOBAL);
+	}
+
+	cfg.dir_load_threads = val.int_val;
+}
+
+/* Chooses between apparent sizes of files and space allocated for them when
+ * calculating sizes of directories. */
+static void
+dirsizemode_handler(OPT_OP op, optval_t val)
+{
+	cfg.dir_size_allocated = val.enum_item;
+}
+
 static void
 dotdirs_handler(OPT_OP op, optval_t val)
 {
@@ -1286,6 +1346,22 @@ incsearch_handler(OPT_OP op, optval_t val)
 	cfg.inc_search = val.bool_val;
 }
 
+/* Limits number of threads used to copy files of directories. */
+static void
+iothreads_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val <= 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be > 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 1;
+		set_option("iothreads", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.io_threads = val.int_val;
+}
+
 /* Parses range, which can be shortened to single endpoint if first element
  * matches last one.  Returns non-zero on error, otherwise zero is returned. */
 static int
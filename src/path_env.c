@@ -18,9 +18,14 @@
 
 #include "path_env.h"
 
+#include <sys/stat.h> /* stat */
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+
+#include <stdint.h> /* intptr_t */
 #include <stdio.h> /* snprintf() sprintf() */
 #include <stdlib.h> /* malloc() free() */
-#include <string.h> /* strchr() strlen() */
+#include <string.h> /* memcmp() memset() strchr() strdup() strlen() */
+#include <time.h> /* time_t time() timespec */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -32,15 +37,52 @@
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/trie.h"
+#include "utils/utils.h"
 
+/* Modification time of a directory. */
+typedef struct
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	struct timespec ts; /* Sub-second precision, where it's available. */
+#else
+	time_t ts;          /* Time in seconds. */
+#endif
+}
+dir_mtime_t;
+
+static void update_path_env_locked(int force);
 static int path_env_was_changed(int force);
 static void append_scripts_dirs(void);
 static void add_dirs_to_path(const char *path);
 static void add_to_path(const char *path);
 static void split_path_list(void);
+static int path_dirs_changed(void);
+static void get_dir_mtime(const char path[], dir_mtime_t *mtime);
+static int lookup_cmd(const char cmd[], size_t path_len, char path[]);
+static void store_cmd(const char cmd[], const char path[]);
+static void reset_cmd_cache(void);
+
+/* Protects all of the state below, as commands can be searched for from
+ * background threads. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 
 static char **paths;
 static int paths_count;
+/* Modification times of elements of the paths array. */
+static dir_mtime_t *paths_mtimes;
+/* Whether all elements of the paths array are absolute, otherwise results of
+ * searches depend on current directory and can't be cached. */
+static int paths_absolute;
+/* Time of the last check of the paths_mtimes array. */
+static time_t mtimes_check_time;
+
+/* Names of commands to index into cmd_paths array plus one. */
+static trie_t cmd_cache = NULL_TRIE;
+/* Paths to commands, NULL for commands that weren't found. */
+static char **cmd_paths;
+/* Number of elements in the cmd_paths array. */
+static int cmd_paths_count;
 
 static char *clean_path;
 static char *real_path;
@@ -48,13 +90,24 @@ static char *real_path;
 char **
 get_paths(size_t *count)
 {
-	update_path_env(0);
+	pthread_mutex_lock(&lock);
+	update_path_env_locked(0);
 	*count = paths_count;
+	pthread_mutex_unlock(&lock);
 	return paths;
 }
 
 void
 update_path_env(int force)
+{
+	pthread_mutex_lock(&lock);
+	update_path_env_locked(force);
+	pthread_mutex_unlock(&lock);
+}
+
+/* Implementation of update_path_env(), which expects the lock to be held. */
+static void
+update_path_env_locked(int force)
 {
 	if(path_env_was_changed(force))
 	{
@@ -160,6 +213,10 @@ split_path_list(void)
 
 	path = env_get("PATH");
 
+	reset_cmd_cache();
+	free(paths_mtimes);
+	paths_mtimes = NULL;
+
 	if(paths != NULL)
 		free_string_array(paths, paths_count);
 
@@ -234,22 +291,215 @@ split_path_list(void)
 	}
 	while(q[0] != '\0');
 	paths_count = i;
+
+	paths_absolute = 1;
+	paths_mtimes = reallocarray(NULL, paths_count, sizeof(*paths_mtimes));
+	for(i = 0; i < paths_count; ++i)
+	{
+		paths_absolute &= is_path_absolute(paths[i]);
+		if(paths_mtimes != NULL)
+		{
+			get_dir_mtime(paths[i], &paths_mtimes[i]);
+		}
+	}
+	mtimes_check_time = time(NULL);
+}
+
+int
+path_env_find_cmd(const char cmd[], size_t path_len, char path[])
+{
+	int i;
+	int cached;
+
+	pthread_mutex_lock(&lock);
+
+	cached = lookup_cmd(cmd, path_len, path);
+	if(cached != 0)
+	{
+		pthread_mutex_unlock(&lock);
+		return (cached > 0) ? 0 : 1;
+	}
+
+	for(i = 0; i < paths_count; ++i)
+	{
+		char tmp_path[PATH_MAX];
+		snprintf(tmp_path, sizeof(tmp_path), "%s/%s", paths[i], cmd);
+
+		/* Need to check for executable, not just a file, as this additionally
+		 * checks for path with different executable extensions on Windows. */
+		if(executable_exists(tmp_path))
+		{
+			if(path != NULL)
+			{
+				copy_str(path, path_len, tmp_path);
+			}
+			store_cmd(cmd, tmp_path);
+			pthread_mutex_unlock(&lock);
+			return 0;
+		}
+	}
+
+	store_cmd(cmd, NULL);
+	pthread_mutex_unlock(&lock);
+	return 1;
+}
+
+/* Looks up result of previous search of the cmd in directories of PATH.  The
+ * result stays valid until either PATH or list of files in one of its
+ * directories changes.  Returns zero if there is no such result, positive
+ * number if the command was found (its path is copied into the path buffer if
+ * it's not NULL) and negative number if it wasn't found. */
+static int
+lookup_cmd(const char cmd[], size_t path_len, char path[])
+{
+	void *data;
+	const char *cmd_path;
+
+	update_path_env_locked(0);
+
+	if(path_dirs_changed())
+	{
+		reset_cmd_cache();
+	}
+
+	if(cmd_cache == NULL_TRIE || trie_get(cmd_cache, cmd, &data) != 0)
+	{
+		return 0;
+	}
+
+	cmd_path = cmd_paths[(intptr_t)data - 1];
+	if(cmd_path == NULL)
+	{
+		return -1;
+	}
+
+	if(path != NULL)
+	{
+		copy_str(path, path_len, cmd_path);
+	}
+	return 1;
+}
+
+/* Remembers result of searching for the cmd in directories of PATH.  path
+ * should be NULL if the command wasn't found. */
+static void
+store_cmd(const char cmd[], const char path[])
+{
+	char *path_copy = NULL;
+
+	if(!paths_absolute || paths_mtimes == NULL)
+	{
+		return;
+	}
+
+	if(cmd_cache == NULL_TRIE)
+	{
+		cmd_cache = trie_create();
+		if(cmd_cache == NULL_TRIE)
+		{
+			return;
+		}
+	}
+
+	if(path != NULL)
+	{
+		path_copy = strdup(path);
+		if(path_copy == NULL)
+		{
+			return;
+		}
+	}
+
+	if(put_into_string_array(&cmd_paths, cmd_paths_count, path_copy) !=
+			cmd_paths_count + 1)
+	{
+		free(path_copy);
+		return;
+	}
+
+	/* The array owns the path even if it's not referenced by the cache. */
+	++cmd_paths_count;
+	(void)trie_set(cmd_cache, cmd, (void *)(intptr_t)cmd_paths_count);
+}
+
+/* Checks whether list of files of any of the directories in PATH was changed.
+ * Directories are checked at most once per second.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+path_dirs_changed(void)
+{
+	int i;
+	int changed = 0;
+	const time_t now = time(NULL);
+
+	if(paths_mtimes == NULL || cmd_cache == NULL_TRIE ||
+			now == mtimes_check_time)
+	{
+		return 0;
+	}
+	mtimes_check_time = now;
+
+	for(i = 0; i < paths_count; ++i)
+	{
+		dir_mtime_t mtime;
+		get_dir_mtime(paths[i], &mtime);
+		if(memcmp(&mtime, &paths_mtimes[i], sizeof(mtime)) != 0)
+		{
+			paths_mtimes[i] = mtime;
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/* Retrieves modification time of the directory.  The time is zeroed on
+ * error. */
+static void
+get_dir_mtime(const char path[], dir_mtime_t *mtime)
+{
+	struct stat st;
+
+	memset(mtime, 0, sizeof(*mtime));
+	if(os_stat(path, &st) == 0)
+	{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+		mtime->ts = st.st_mtim;
+#else
+		mtime->ts = st.st_mtime;
+#endif
+	}
+}
+
+/* Forgets results of all previous searches of commands. */
+static void
+reset_cmd_cache(void)
+{
+	trie_free(cmd_cache);
+	cmd_cache = NULL_TRIE;
+
+	free_string_array(cmd_paths, cmd_paths_count);
+	cmd_paths = NULL;
+	cmd_paths_count = 0;
 }
 
 void
 load_clean_path_env(void)
 {
+	pthread_mutex_lock(&lock);
 	(void)replace_string(&real_path, env_get("PATH"));
 	env_set("PATH", clean_path);
+	pthread_mutex_unlock(&lock);
 }
 
 void
 load_real_path_env(void)
 {
+	pthread_mutex_lock(&lock);
 	env_set("PATH", real_path);
 
 	free(real_path);
 	real_path = NULL;
+	pthread_mutex_unlock(&lock);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -25,10 +25,18 @@
 void update_path_env(int force);
 
 /* Reparses PATH environment variable if needed. Returns list of paths, which
- * shouldn't be freed by the caller. The number of paths is returned through
+ * shouldn't be freed by the caller and stays valid only until PATH changes,
+ * so it's meant for the main thread. The number of paths is returned through
  * the count argument. */
 char ** get_paths(size_t *count);
 
+/* Searches for the cmd in directories of PATH reusing results of previous
+ * searches, which stay valid until either PATH or list of files in one of its
+ * directories changes.  Can be called from any thread.  Returns zero if the
+ * command was found (its path is copied into the path buffer if it's not
+ * NULL), otherwise non-zero is returned. */
+int path_env_find_cmd(const char cmd[], size_t path_len, char path[]);
+
 /* Sets PATH to its value that was set by user or another program. Use
  * load_real_path_env() function to revert this effect. */
 void load_clean_path_env(void);
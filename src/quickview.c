@@ -20,12 +20,17 @@
 #include "quickview.h"
 
 #include <curses.h> /* mvwaddstr() wattrset() */
+#include <pthread.h> /* pthread_* */
+#include <sys/stat.h> /* stat */
+#include <sys/types.h> /* pid_t */
 #include <unistd.h> /* usleep() */
 
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE fclose() fdopen() feof() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* memmove() strlen() strncat() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fdopen() feof() fmemopen() fread() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memmove() strcmp() strlen() strncat() */
+#include <time.h> /* time_t */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -60,7 +65,69 @@
 /* Size of buffer holding preview line (in characters). */
 #define PREVIEW_LINE_BUF_LEN 4096
 
+/* Maximum number of bytes of viewer output that is read and cached.  Only the
+ * beginning of the output fits on the screen anyway. */
+#define MAX_OUTPUT_LEN (64*1024)
+
+/* Maximum number of viewer outputs kept in the cache. */
+#define CACHE_SIZE 16
+
+/* How many times and how long (in microseconds) to wait for a viewer before
+ * leaving it running in background.  Fast viewers thus don't cause flickering
+ * of "loading" message. */
+#define SYNC_WAIT_STEPS 10
+#define SYNC_WAIT_STEP 5000
+
+/* Identifies output of a viewer. */
+typedef struct
+{
+	char *path;    /* Full path to the file. */
+	char *cmd;     /* Viewer command with all macros expanded. */
+	time_t mtime;  /* Modification time of the file. */
+	uint64_t size; /* Size of the file. */
+	int width;     /* Width of the preview pane. */
+}
+preview_key_t;
+
+/* Output of a viewer. */
+typedef struct
+{
+	preview_key_t key; /* What this output corresponds to. */
+	char *output;      /* Output (not null-terminated), can be NULL. */
+	size_t len;        /* Length of the output. */
+}
+preview_t;
+
+/* Viewer running in background.  Shared by the main thread and the reading
+ * thread, freed by the one that's done with it last. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects finished and abandoned fields. */
+	preview_t preview;    /* Output being collected.  Key is immutable. */
+	FILE *fp;             /* Output stream of the viewer. */
+	pid_t pgid;           /* Process group of the viewer. */
+	int finished;         /* Set by the thread after it's done reading. */
+	int abandoned;        /* Set when output isn't needed anymore. */
+}
+preview_job_t;
+
 static void view_file(const char path[]);
+static void view_viewer_output(const char path[], const char viewer[]);
+TSTATIC int get_viewer_output(const char path[], const char viewer[],
+		const char **output, size_t *len, int *pending);
+static int make_key(preview_key_t *key, const char path[],
+		const char viewer[]);
+static int keys_equal(const preview_key_t *a, const preview_key_t *b);
+static void free_key(preview_key_t *key);
+static const preview_t * cache_lookup(const preview_key_t *key);
+static const preview_t * cache_put(preview_t *preview);
+static void free_preview(preview_t *preview);
+static int start_job(preview_key_t *key);
+static void * preview_thread(void *arg);
+static int take_job_result(preview_t *preview);
+static void cancel_job(void);
+static void free_job(preview_job_t *job);
+static void view_text(const char text[], size_t len);
 static void view_stream(FILE *fp, int wrapped);
 static int shift_line(char line[], size_t len, size_t offset);
 static size_t add_to_line(FILE *fp, size_t max, char line[], size_t len);
@@ -68,6 +135,15 @@ static void write_message(const char msg[]);
 static void cleanup_for_text(void);
 static char * get_viewer_command(const char viewer[]);
 static char * get_typed_fname(const char path[]);
+TSTATIC void drop_previews(void);
+
+/* Most recently used outputs of viewers, the most recent one comes first. */
+static preview_t cache[CACHE_SIZE];
+/* Number of used elements of the cache array. */
+static int cache_len;
+
+/* Currently running viewer or NULL. */
+static preview_job_t *curr_job;
 
 void
 toggle_quick_view(void)
@@ -92,6 +168,8 @@ toggle_quick_view(void)
 
 		update_string(&curr_stats.preview_cleanup, NULL);
 		curr_stats.graphics_preview = 0;
+
+		cancel_job();
 	}
 	else
 	{
@@ -154,6 +232,24 @@ quick_view_file(FileView *view)
 	ui_view_title_update(other_view);
 }
 
+void
+qv_check_for_updates(void)
+{
+	preview_t preview;
+
+	if(curr_job == NULL || !take_job_result(&preview))
+	{
+		return;
+	}
+
+	(void)cache_put(&preview);
+
+	if(curr_stats.view && vle_mode_get_primary() != MENU_MODE)
+	{
+		quick_view_file(curr_view);
+	}
+}
+
 /* Displays contents of file or output of its viewer in the other pane
  * starting from the second line and second column. */
 static void
@@ -168,10 +264,20 @@ view_file(const char path[])
 
 	if(viewer == NULL && is_dir(path))
 	{
+		cancel_job();
 		write_message("File is a Directory");
 		return;
 	}
 
+	if(!is_null_or_empty(viewer) && !is_graphics_viewer(viewer))
+	{
+		view_viewer_output(path, viewer);
+		return;
+	}
+
+	/* Output of viewer that might be running in background is of no use now. */
+	cancel_job();
+
 	if(is_null_or_empty(viewer))
 	{
 		fp = os_fopen(path, "rb");
@@ -183,14 +289,12 @@ view_file(const char path[])
 	}
 	else
 	{
-		graphics = is_graphics_viewer(viewer);
-		/* If graphics will be displayed, clear the window and wait a bit to let
-		 * terminal emulator do actual refresh (at least some of them need this). */
-		if(graphics)
-		{
-			qv_cleanup(other_view, curr_stats.preview_cleanup);
-			usleep(50000);
-		}
+		/* Graphics viewers draw directly on the screen and thus are run in
+		 * foreground.  Clear the window and wait a bit to let terminal emulator do
+		 * actual refresh (at least some of them need this). */
+		graphics = 1;
+		qv_cleanup(other_view, curr_stats.preview_cleanup);
+		usleep(50000);
 		fp = use_info_prog(viewer);
 		if(fp == NULL)
 		{
@@ -215,6 +319,376 @@ view_file(const char path[])
 	fclose(fp);
 }
 
+/* Displays output of textual viewer for the file.  Output is taken from the
+ * cache or the viewer is started in background, in which case the output is
+ * drawn by qv_check_for_updates() once it's ready. */
+static void
+view_viewer_output(const char path[], const char viewer[])
+{
+	const char *output;
+	size_t len;
+	int pending;
+	if(get_viewer_output(path, viewer, &output, &len, &pending) != 0)
+	{
+		write_message(pending ? "Loading preview..." : "Cannot read viewer output");
+		return;
+	}
+
+	cleanup_for_text();
+	update_string(&curr_stats.preview_cleanup, ma_get_clean_cmd(viewer));
+
+	wattrset(other_view->win, 0);
+	view_text(output, len);
+}
+
+/* Retrieves output of the viewer for the file either from the cache or by
+ * running the viewer.  *pending is set to non-zero if the viewer is still
+ * running in background.  Returns zero and sets *output (can be NULL) and *len
+ * on success, output stays valid until the cache is modified, otherwise
+ * non-zero is returned. */
+TSTATIC int
+get_viewer_output(const char path[], const char viewer[], const char **output,
+		size_t *len, int *pending)
+{
+	preview_key_t key;
+	preview_t preview;
+	const preview_t *cached;
+	int i;
+
+	*pending = 0;
+
+	if(make_key(&key, path, viewer) != 0)
+	{
+		return 1;
+	}
+
+	if(curr_job != NULL && take_job_result(&preview))
+	{
+		(void)cache_put(&preview);
+	}
+
+	cached = cache_lookup(&key);
+	if(cached != NULL)
+	{
+		free_key(&key);
+		*output = cached->output;
+		*len = cached->len;
+		return 0;
+	}
+
+	if(curr_job != NULL && keys_equal(&curr_job->preview.key, &key))
+	{
+		free_key(&key);
+		*pending = 1;
+		return 1;
+	}
+
+	cancel_job();
+	if(start_job(&key) != 0)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < SYNC_WAIT_STEPS; ++i)
+	{
+		usleep(SYNC_WAIT_STEP);
+		if(take_job_result(&preview))
+		{
+			cached = cache_put(&preview);
+			*output = cached->output;
+			*len = cached->len;
+			return 0;
+		}
+	}
+
+	*pending = 1;
+	return 1;
+}
+
+/* Fills the key for the file and its viewer.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+make_key(preview_key_t *key, const char path[], const char viewer[])
+{
+	struct stat st;
+
+	if(os_stat(path, &st) != 0)
+	{
+		st.st_mtime = 0;
+		st.st_size = 0;
+	}
+
+	key->path = strdup(path);
+	key->cmd = get_viewer_command(viewer);
+	key->mtime = st.st_mtime;
+	key->size = st.st_size;
+	key->width = other_view->window_width;
+
+	if(key->path == NULL || key->cmd == NULL)
+	{
+		free_key(key);
+		return 1;
+	}
+	return 0;
+}
+
+/* Compares two keys.  Returns non-zero if they are equal, otherwise zero is
+ * returned. */
+static int
+keys_equal(const preview_key_t *a, const preview_key_t *b)
+{
+	return a->mtime == b->mtime
+	    && a->size == b->size
+	    && a->width == b->width
+	    && strcmp(a->path, b->path) == 0
+	    && strcmp(a->cmd, b->cmd) == 0;
+}
+
+/* Frees resources of the key. */
+static void
+free_key(preview_key_t *key)
+{
+	free(key->path);
+	free(key->cmd);
+}
+
+/* Looks up output in the cache and makes it the most recently used one.
+ * Returns pointer to the output or NULL if it's not in the cache. */
+static const preview_t *
+cache_lookup(const preview_key_t *key)
+{
+	int i;
+	for(i = 0; i < cache_len; ++i)
+	{
+		if(keys_equal(&cache[i].key, key))
+		{
+			const preview_t found = cache[i];
+			memmove(&cache[1], &cache[0], sizeof(*cache)*i);
+			cache[0] = found;
+			return &cache[0];
+		}
+	}
+	return NULL;
+}
+
+/* Puts output into the cache as the most recently used one evicting the least
+ * recently used output if the cache is full.  Takes ownership of the preview.
+ * Returns pointer to the output in the cache. */
+static const preview_t *
+cache_put(preview_t *preview)
+{
+	if(cache_len == CACHE_SIZE)
+	{
+		free_preview(&cache[--cache_len]);
+	}
+
+	memmove(&cache[1], &cache[0], sizeof(*cache)*cache_len);
+	cache[0] = *preview;
+	++cache_len;
+	return &cache[0];
+}
+
+/* Frees resources of the preview. */
+static void
+free_preview(preview_t *preview)
+{
+	free_key(&preview->key);
+	free(preview->output);
+}
+
+/* Runs viewer in background and makes it the current job.  Output is read by
+ * an internal thread, so viewers don't show up in the list of jobs.  Takes
+ * ownership of the key.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+start_job(preview_key_t *key)
+{
+	pthread_t id;
+	preview_job_t *const job = malloc(sizeof(*job));
+	if(job == NULL)
+	{
+		free_key(key);
+		return 1;
+	}
+
+	job->preview.key = *key;
+	job->preview.output = NULL;
+	job->preview.len = 0U;
+	job->finished = 0;
+	job->abandoned = 0;
+
+	job->fp = read_cmd_output_in_group(key->cmd, &job->pgid);
+	if(job->fp == NULL)
+	{
+		free_preview(&job->preview);
+		free(job);
+		return 1;
+	}
+
+	if(pthread_mutex_init(&job->lock, NULL) != 0)
+	{
+		kill_process_group(job->pgid);
+		fclose(job->fp);
+		free_preview(&job->preview);
+		free(job);
+		return 1;
+	}
+
+	if(pthread_create(&id, NULL, &preview_thread, job) != 0)
+	{
+		kill_process_group(job->pgid);
+		fclose(job->fp);
+		free_job(job);
+		return 1;
+	}
+	(void)pthread_detach(id);
+
+	curr_job = job;
+	return 0;
+}
+
+/* Entry point of the thread that collects output of a viewer.  Returns
+ * NULL. */
+static void *
+preview_thread(void *arg)
+{
+	preview_job_t *const job = arg;
+	preview_t *const preview = &job->preview;
+	int abandoned;
+
+	preview->output = malloc(MAX_OUTPUT_LEN);
+	if(preview->output != NULL)
+	{
+		size_t n;
+		while(preview->len < MAX_OUTPUT_LEN &&
+				(n = fread(preview->output + preview->len, 1,
+					MAX_OUTPUT_LEN - preview->len, job->fp)) != 0U)
+		{
+			preview->len += n;
+		}
+	}
+
+	pthread_mutex_lock(&job->lock);
+	/* The rest of the output isn't needed. */
+	if(!job->abandoned && !feof(job->fp))
+	{
+		kill_process_group(job->pgid);
+	}
+	fclose(job->fp);
+	abandoned = job->abandoned;
+	job->finished = 1;
+	pthread_mutex_unlock(&job->lock);
+
+	if(abandoned)
+	{
+		free_job(job);
+	}
+	return NULL;
+}
+
+/* Retrieves output of current job if it has finished.  Returns non-zero if so
+ * and transfers ownership of the output to the caller, otherwise zero is
+ * returned. */
+static int
+take_job_result(preview_t *preview)
+{
+	int finished;
+
+	pthread_mutex_lock(&curr_job->lock);
+	finished = curr_job->finished;
+	pthread_mutex_unlock(&curr_job->lock);
+
+	if(!finished)
+	{
+		return 0;
+	}
+
+	*preview = curr_job->preview;
+	if(preview->output != NULL)
+	{
+		/* Give back memory that isn't used. */
+		char *const output = realloc(preview->output, preview->len + 1U);
+		if(output != NULL)
+		{
+			preview->output = output;
+		}
+	}
+
+	pthread_mutex_destroy(&curr_job->lock);
+	free(curr_job);
+	curr_job = NULL;
+	return 1;
+}
+
+/* Stops current job, if any, killing its viewer. */
+static void
+cancel_job(void)
+{
+	int finished;
+
+	if(curr_job == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&curr_job->lock);
+	finished = curr_job->finished;
+	if(!finished)
+	{
+		curr_job->abandoned = 1;
+		kill_process_group(curr_job->pgid);
+	}
+	pthread_mutex_unlock(&curr_job->lock);
+
+	if(finished)
+	{
+		free_job(curr_job);
+	}
+	curr_job = NULL;
+}
+
+/* Frees the job along with its output. */
+static void
+free_job(preview_job_t *job)
+{
+	pthread_mutex_destroy(&job->lock);
+	free_preview(&job->preview);
+	free(job);
+}
+
+/* Displays the text in the other pane starting from the second line and second
+ * column. */
+static void
+view_text(const char text[], size_t len)
+{
+	FILE *fp;
+
+	if(len == 0U)
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	fp = fmemopen((void *)text, len, "r");
+#else
+	fp = tmpfile();
+	if(fp != NULL)
+	{
+		fwrite(text, 1, len, fp);
+		rewind(fp);
+	}
+#endif
+
+	if(fp == NULL)
+	{
+		write_message("Cannot read viewer output");
+		return;
+	}
+
+	view_stream(fp, cfg.wrap_quick_view);
+	fclose(fp);
+}
+
 /* Displays contents read from the fp in the other pane starting from the second
  * line and second column.  The wrapped parameter determines whether lines
  * should be wrapped. */
@@ -410,5 +884,16 @@ get_typed_fname(const char path[])
 	return is_dir(path) ? format_str("%s/", last_part) : strdup(last_part);
 }
 
+/* Stops current viewer, if any, and empties the cache of outputs. */
+TSTATIC void
+drop_previews(void)
+{
+	cancel_job();
+	while(cache_len != 0)
+	{
+		free_preview(&cache[--cache_len]);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
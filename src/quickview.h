@@ -23,11 +23,16 @@
 #include <stdio.h> /* FILE */
 
 #include "ui/ui.h"
+#include "utils/test_helpers.h"
 
 void quick_view_file(FileView *view);
 
 void toggle_quick_view(void);
 
+/* Draws output of a viewer that was left running in background once it's
+ * ready. */
+void qv_check_for_updates(void);
+
 /* Quits preview pane or view modes. */
 void preview_close(void);
 
@@ -41,6 +46,12 @@ void qv_cleanup(FileView *view, const char cmd[]);
  * string stored internally. */
 const char * gv_get_viewer(const char path[]);
 
+TSTATIC_DEFS(
+	int get_viewer_output(const char path[], const char viewer[],
+			const char **output, size_t *len, int *pending);
+	void drop_previews(void);
+)
+
 #endif /* VIFM__QUICKVIEW_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -21,49 +21,95 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() qsort() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stdlib.h> /* abs() free() qsort() */
+#include <string.h> /* memcpy() strcmp() strdup() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/test_helpers.h"
-#include "utils/tree.h"
 #include "utils/utils.h"
+#include "dircache.h"
 #include "filelist.h"
-#include "status.h"
 #include "types.h"
 
+/* Data of an entry that is computed once before sorting instead of doing it on
+ * every comparison. */
+typedef struct
+{
+	char *name;       /* Name for comparison or NULL to use name of the entry. */
+	char *lower_name; /* Lower case version of the name or NULL. */
+	int is_dir;       /* Whether entry is a directory or link to a directory. */
+}
+sort_data_t;
+
 /* View which is being sorted. */
 static FileView* view;
 /* Whether the view displays custom file list. */
 static int custom_view;
-static int sort_descending;
-/* Key used to sort entries in current sorting round. */
-static SortingKey sort_type;
-
-static void sort_by_key(char key);
+/* Sorting keys in order of decreasing significance, negative values mean
+ * descending order. */
+static char sort_keys[SK_COUNT + 1];
+/* Number of elements in sort_keys array. */
+static int sort_key_count;
+/* Precomputed data of entries indexed by list_num field of entries. */
+static sort_data_t *sort_data;
+
+TSTATIC void sort_view_entries(FileView *v, int prepare);
+static void collect_sort_keys(const FileView *v);
+static int has_sort_key(SortingKey key);
+static int prepare_sort_data(void);
+static int fill_sort_data(dir_entry_t *entry, sort_data_t *data, int by_size,
+		int by_iname);
+static void free_sort_data(int count);
+static void free_sort_data_fields(sort_data_t *data);
+static void update_dir_sizes(void);
+static void sort_entries(void);
 static int sort_dir_list(const void *one, const void *two);
+static int sort_dir_list_ptrs(const void *one, const void *two);
+static int compare_entries(const dir_entry_t *first,
+		const dir_entry_t *second);
+static int compare_unprepared_entries(const dir_entry_t *first,
+		const dir_entry_t *second);
+static int compare_by_keys(const dir_entry_t *first,
+		const sort_data_t *first_data, const dir_entry_t *second,
+		const sort_data_t *second_data);
+static int compare_by_key(const dir_entry_t *first,
+		const sort_data_t *first_data, const dir_entry_t *second,
+		const sort_data_t *second_data, SortingKey key);
+static const char * sort_name(const dir_entry_t *entry,
+		const sort_data_t *data);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int vercmp(const char s[], const char t[]);
 #else
 static char * skip_leading_zeros(const char str[]);
 #endif
-static int compare_entry_names(const dir_entry_t *a, const dir_entry_t *b,
-		int ignore_case);
 static int compare_full_file_names(const char s[], const char t[],
-		int ignore_case);
+		const char lower_s[], const char lower_t[]);
 static int compare_file_names(const char s[], const char t[], int ignore_case);
+static int compare_lowered_file_names(const char s[], const char t[],
+		const char lower_s[], const char lower_t[]);
+static char * make_lower_name(const char name[]);
 
 void
 sort_view(FileView *v)
 {
-	int i;
+	sort_view_entries(v, 1);
+}
 
-	if(v->sort[0] > SK_LAST)
+/* Sorts entries of the view.  Data for comparison is computed beforehand if
+ * prepare is non-zero and there is enough memory for it, otherwise it's
+ * computed on every comparison. */
+TSTATIC void
+sort_view_entries(FileView *v, int prepare)
+{
+	int j;
+
+	if(v->sort[0] > SK_LAST || v->list_rows <= 0)
 	{
 		/* Completely skip sorting if primary key isn't set. */
 		return;
@@ -72,40 +118,277 @@ sort_view(FileView *v)
 	view = v;
 	custom_view = flist_custom_active(v);
 
-	i = SK_COUNT;
-	while(--i >= 0)
+	collect_sort_keys(v);
+
+	for(j = 0; j < view->list_rows; ++j)
+	{
+		view->dir_entry[j].list_num = j;
+	}
+
+	if(!prepare || prepare_sort_data() != 0)
+	{
+		sort_data = NULL;
+		update_dir_sizes();
+	}
+
+	sort_entries();
+
+	if(sort_data != NULL)
+	{
+		free_sort_data(view->list_rows);
+	}
+}
+
+int
+sort_find_pos(FileView *v, dir_entry_t *entry)
+{
+	sort_data_t entry_data;
+	int by_size, by_iname;
+	int lower, upper;
+
+	if(v->sort[0] > SK_LAST)
+	{
+		/* Unsorted list, just append. */
+		return v->list_rows;
+	}
+
+	view = v;
+	custom_view = flist_custom_active(v);
+
+	collect_sort_keys(v);
+	by_size = has_sort_key(SK_BY_SIZE);
+	by_iname = has_sort_key(SK_BY_INAME);
+
+	if(fill_sort_data(entry, &entry_data, by_size, by_iname) != 0)
 	{
-		const char sorting_key = view->sort[i];
+		return v->list_rows;
+	}
+
+	/* Binary search for the first entry greater than the one being inserted. */
+	lower = 0;
+	upper = v->list_rows;
+	while(lower < upper)
+	{
+		const int middle = lower + (upper - lower)/2;
+		dir_entry_t *const middle_entry = &v->dir_entry[middle];
+		sort_data_t middle_data;
+		int result;
+
+		if(fill_sort_data(middle_entry, &middle_data, by_size, by_iname) != 0)
+		{
+			break;
+		}
+
+		result = compare_by_keys(entry, &entry_data, middle_entry, &middle_data);
+		free_sort_data_fields(&middle_data);
 
-		if(abs(sorting_key) > SK_LAST)
+		if(result < 0)
 		{
-			continue;
+			upper = middle;
 		}
+		else
+		{
+			lower = middle + 1;
+		}
+	}
+
+	free_sort_data_fields(&entry_data);
+	return lower;
+}
+
+/* Sorts entries of the view.  All keys are compared at once, original position
+ * resolves ties, which is equivalent to a sequence of stable sorts by each key
+ * starting with the least significant one. */
+static void
+sort_entries(void)
+{
+	const size_t count = view->list_rows;
+	const dir_entry_t **order;
+	dir_entry_t *sorted;
+	size_t j;
+
+	/* Sorting pointers is cheaper than moving whole entries on every swap, so
+	 * entries are reordered only once at the end. */
+	order = reallocarray(NULL, count, sizeof(*order));
+	sorted = reallocarray(NULL, count, sizeof(*sorted));
+	if(order == NULL || sorted == NULL)
+	{
+		free(order);
+		free(sorted);
+		qsort(view->dir_entry, count, sizeof(dir_entry_t), &sort_dir_list);
+		return;
+	}
 
-		sort_by_key(sorting_key);
+	for(j = 0; j < count; ++j)
+	{
+		order[j] = &view->dir_entry[j];
 	}
 
+	qsort(order, count, sizeof(*order), &sort_dir_list_ptrs);
+
+	for(j = 0; j < count; ++j)
+	{
+		sorted[j] = *order[j];
+	}
+	memcpy(view->dir_entry, sorted, sizeof(*sorted)*count);
+
+	free(sorted);
+	free(order);
+}
+
+/* Fills sort_keys array with keys of the view.  Grouping of directories is the
+ * most significant key unless it's specified explicitly. */
+static void
+collect_sort_keys(const FileView *v)
+{
+	int i;
+
+	sort_key_count = 0;
+
 	if(!ui_view_sort_list_contains(v->sort, SK_BY_DIR))
 	{
-		sort_by_key(SK_BY_DIR);
+		sort_keys[sort_key_count++] = SK_BY_DIR;
+	}
+
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		if(abs(v->sort[i]) <= SK_LAST)
+		{
+			sort_keys[sort_key_count++] = v->sort[i];
+		}
+	}
+}
+
+/* Checks whether sorting is performed by the key in any order.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+has_sort_key(SortingKey key)
+{
+	int i;
+	for(i = 0; i < sort_key_count; ++i)
+	{
+		if(abs(sort_keys[i]) == key)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Computes data of entries which is needed for comparing them.  Sizes of
+ * directories are updated from the cache.  Returns non-zero on memory
+ * allocation error, otherwise zero is returned. */
+static int
+prepare_sort_data(void)
+{
+	const int by_size = has_sort_key(SK_BY_SIZE);
+	const int by_iname = has_sort_key(SK_BY_INAME);
+	int j;
+
+	sort_data = reallocarray(NULL, view->list_rows, sizeof(*sort_data));
+	if(sort_data == NULL)
+	{
+		return 1;
+	}
+
+	for(j = 0; j < view->list_rows; ++j)
+	{
+		if(fill_sort_data(&view->dir_entry[j], &sort_data[j], by_size,
+					by_iname) != 0)
+		{
+			free_sort_data(j);
+			return 1;
+		}
 	}
+
+	return 0;
 }
 
-/* Sorts view by the key in a stable way. */
+/* Computes data of a single entry which is needed for comparing it.  Size of
+ * directory is updated from the cache.  Returns non-zero on memory allocation
+ * error, otherwise zero is returned. */
+static int
+fill_sort_data(dir_entry_t *entry, sort_data_t *data, int by_size,
+		int by_iname)
+{
+	data->name = NULL;
+	data->lower_name = NULL;
+	data->is_dir = is_directory_entry(entry);
+
+	if(custom_view)
+	{
+		char short_path[PATH_MAX];
+		get_short_path_of(view, entry, 0, sizeof(short_path), short_path);
+		data->name = strdup(short_path);
+	}
+
+	if(by_iname)
+	{
+		data->lower_name = make_lower_name(sort_name(entry, data));
+	}
+
+	if(by_size && data->is_dir)
+	{
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		(void)dcache_get_size(full_path, cfg.dir_size_allocated,
+				&entry->size);
+	}
+
+	if((custom_view && data->name == NULL) ||
+			(by_iname && data->lower_name == NULL))
+	{
+		free_sort_data_fields(data);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Frees first count elements of sort_data array and the array itself. */
 static void
-sort_by_key(char key)
+free_sort_data(int count)
 {
 	int j;
+	for(j = 0; j < count; ++j)
+	{
+		free_sort_data_fields(&sort_data[j]);
+	}
+	free(sort_data);
+	sort_data = NULL;
+}
+
+/* Frees fields of sort data of a single entry. */
+static void
+free_sort_data_fields(sort_data_t *data)
+{
+	free(data->name);
+	free(data->lower_name);
+}
 
-	sort_descending = (key < 0);
-	sort_type = (SortingKey)abs(key);
+/* Updates sizes of directories from the cache if they are used for sorting.
+ * This is done by fill_sort_data() when data is prepared in advance. */
+static void
+update_dir_sizes(void)
+{
+	int j;
 
-	for(j = 0; j < view->list_rows; j++)
+	if(!has_sort_key(SK_BY_SIZE))
 	{
-		view->dir_entry[j].list_num = j;
+		return;
 	}
 
-	qsort(view->dir_entry, view->list_rows, sizeof(dir_entry_t), sort_dir_list);
+	for(j = 0; j < view->list_rows; ++j)
+	{
+		dir_entry_t *const entry = &view->dir_entry[j];
+		if(is_directory_entry(entry))
+		{
+			char full_path[PATH_MAX];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			(void)dcache_get_size(full_path, cfg.dir_size_allocated,
+					&entry->size);
+		}
+	}
 }
 
 /* Compares file names containing numbers correctly. */
@@ -169,15 +452,75 @@ skip_leading_zeros(const char str[])
 }
 #endif
 
+/* qsort() comparer for array of entries.  Returns standard -1, 0, 1 for
+ * comparisons. */
 static int
 sort_dir_list(const void *one, const void *two)
 {
-	int retval;
-	char *pfirst, *psecond;
-	dir_entry_t *const first = (dir_entry_t *)one;
-	dir_entry_t *const second = (dir_entry_t *)two;
-	int first_is_dir;
-	int second_is_dir;
+	return compare_entries(one, two);
+}
+
+/* qsort() comparer for array of pointers to entries.  Returns standard -1, 0,
+ * 1 for comparisons. */
+static int
+sort_dir_list_ptrs(const void *one, const void *two)
+{
+	const dir_entry_t *const *const first = one;
+	const dir_entry_t *const *const second = two;
+	return compare_entries(*first, *second);
+}
+
+/* Compares two entries by all sorting keys and their original positions.
+ * Returns negative value if first should go before second, otherwise positive
+ * value is returned. */
+static int
+compare_entries(const dir_entry_t *first, const dir_entry_t *second)
+{
+	const int result = (sort_data == NULL)
+	                 ? compare_unprepared_entries(first, second)
+	                 : compare_by_keys(first, &sort_data[first->list_num], second,
+	                                   &sort_data[second->list_num]);
+	return (result == 0) ? first->list_num - second->list_num : result;
+}
+
+/* Compares two entries by all sorting keys computing their data on the fly.
+ * Names are compared case sensitively if memory for their lower case versions
+ * can't be allocated.  Returns negative value if first should go before second,
+ * zero if they are equal, otherwise positive value is returned. */
+static int
+compare_unprepared_entries(const dir_entry_t *first, const dir_entry_t *second)
+{
+	const int by_iname = has_sort_key(SK_BY_INAME);
+	sort_data_t first_data, second_data;
+	int result;
+
+	/* Sizes of directories are already up to date. */
+	if(fill_sort_data((dir_entry_t *)first, &first_data, 0, by_iname) != 0)
+	{
+		first_data.name = NULL;
+		first_data.lower_name = NULL;
+	}
+	if(fill_sort_data((dir_entry_t *)second, &second_data, 0, by_iname) != 0)
+	{
+		second_data.name = NULL;
+		second_data.lower_name = NULL;
+	}
+
+	result = compare_by_keys(first, &first_data, second, &second_data);
+
+	free_sort_data_fields(&first_data);
+	free_sort_data_fields(&second_data);
+	return result;
+}
+
+/* Compares two entries by all sorting keys.  Returns negative value if first
+ * should go before second, zero if they are equal, otherwise positive value is
+ * returned. */
+static int
+compare_by_keys(const dir_entry_t *first, const sort_data_t *first_data,
+		const dir_entry_t *second, const sort_data_t *second_data)
+{
+	int i;
 
 	if(is_parent_dir(first->name))
 	{
@@ -188,160 +531,136 @@ sort_dir_list(const void *one, const void *two)
 		return 1;
 	}
 
-	first_is_dir = is_directory_entry(first);
-	second_is_dir = is_directory_entry(second);
+	for(i = 0; i < sort_key_count; ++i)
+	{
+		const char key = sort_keys[i];
+		const int retval = compare_by_key(first, first_data, second, second_data,
+				(SortingKey)abs(key));
+		if(retval != 0)
+		{
+			return (key < 0) ? -retval : retval;
+		}
+	}
 
-	retval = 0;
-	switch(sort_type)
+	return 0;
+}
+
+/* Compares two entries by a single key in ascending order.  Returns positive
+ * value if first is greater than second, zero if they are equal, otherwise
+ * negative value is returned. */
+static int
+compare_by_key(const dir_entry_t *first, const sort_data_t *first_data,
+		const dir_entry_t *second, const sort_data_t *second_data, SortingKey key)
+{
+	const int first_is_dir = first_data->is_dir;
+	const int second_is_dir = second_data->is_dir;
+	const char *pfirst, *psecond;
+
+	switch(key)
 	{
 		case SK_BY_NAME:
+			return compare_full_file_names(sort_name(first, first_data),
+					sort_name(second, second_data), NULL, NULL);
 		case SK_BY_INAME:
-			if(custom_view)
-			{
-				retval = compare_entry_names(first, second, sort_type == SK_BY_INAME);
-			}
-			else
-			{
-				retval = compare_full_file_names(first->name, second->name,
-						sort_type == SK_BY_INAME);
-			}
-			break;
+			return compare_full_file_names(sort_name(first, first_data),
+					sort_name(second, second_data), first_data->lower_name,
+					second_data->lower_name);
 
 		case SK_BY_DIR:
 			if(first_is_dir != second_is_dir)
 			{
-				retval = first_is_dir ? -1 : 1;
+				return first_is_dir ? -1 : 1;
 			}
-			break;
+			return 0;
 
 		case SK_BY_TYPE:
-			retval = strcmp(get_type_str(first->type), get_type_str(second->type));
-			break;
+			return strcmp(get_type_str(first->type), get_type_str(second->type));
 
 		case SK_BY_FILEEXT:
 		case SK_BY_EXTENSION:
 			pfirst = strrchr(first->name,  '.');
 			psecond = strrchr(second->name, '.');
 
-			if(first_is_dir && second_is_dir && sort_type == SK_BY_FILEEXT)
+			if(first_is_dir && second_is_dir && key == SK_BY_FILEEXT)
 			{
-				retval = compare_file_names(first->name, second->name, 0);
+				return compare_file_names(first->name, second->name, 0);
 			}
-			else if(first_is_dir != second_is_dir && sort_type == SK_BY_FILEEXT)
+			else if(first_is_dir != second_is_dir && key == SK_BY_FILEEXT)
 			{
-				retval = first_is_dir ? -1 : 1;
+				return first_is_dir ? -1 : 1;
 			}
 			else if(pfirst && psecond)
 			{
 				if(pfirst == first->name && psecond != second->name)
 				{
-					retval = -1;
+					return -1;
 				}
 				else if(pfirst != first->name && psecond == second->name)
 				{
-					retval = 1;
+					return 1;
 				}
 				else
 				{
-					retval = compare_file_names(++pfirst, ++psecond, 0);
+					return compare_file_names(++pfirst, ++psecond, 0);
 				}
 			}
 			else if(pfirst || psecond)
-				retval = pfirst ? -1 : 1;
+				return pfirst ? -1 : 1;
 			else
-				retval = compare_file_names(first->name, second->name, 0);
-			break;
+				return compare_file_names(first->name, second->name, 0);
 
 		case SK_BY_SIZE:
-			{
-				if(first_is_dir)
-				{
-					char full_path[PATH_MAX];
-					get_full_path_of(first, sizeof(full_path), full_path);
-					tree_get_data(curr_stats.dirsize_cache, full_path, &first->size);
-				}
-
-				if(second_is_dir)
-				{
-					char full_path[PATH_MAX];
-					get_full_path_of(second, sizeof(full_path), full_path);
-					tree_get_data(curr_stats.dirsize_cache, full_path, &second->size);
-				}
-
-				retval = (first->size < second->size)
-				       ? -1
-				       : (first->size > second->size);
-			}
-			break;
+			return (first->size < second->size) ? -1 : (first->size > second->size);
 
 		case SK_BY_TIME_MODIFIED:
-			retval = first->mtime - second->mtime;
-			break;
+			return (first->mtime < second->mtime) ? -1 : (first->mtime > second->mtime);
 
 		case SK_BY_TIME_ACCESSED:
-			retval = first->atime - second->atime;
-			break;
+			return (first->atime < second->atime) ? -1 : (first->atime > second->atime);
 
 		case SK_BY_TIME_CHANGED:
-			retval = first->ctime - second->ctime;
-			break;
+			return (first->ctime < second->ctime) ? -1 : (first->ctime > second->ctime);
 #ifndef _WIN32
 		case SK_BY_MODE:
-			retval = first->mode - second->mode;
-			break;
+			return (first->mode < second->mode) ? -1 : (first->mode > second->mode);
 
 		case SK_BY_OWNER_NAME: /* FIXME */
 		case SK_BY_OWNER_ID:
-			retval = first->uid - second->uid;
-			break;
+			return (first->uid < second->uid) ? -1 : (first->uid > second->uid);
 
 		case SK_BY_GROUP_NAME: /* FIXME */
 		case SK_BY_GROUP_ID:
-			retval = first->gid - second->gid;
-			break;
+			return (first->gid < second->gid) ? -1 : (first->gid > second->gid);
 
 		case SK_BY_PERMISSIONS:
 			{
 				char first_perm[11], second_perm[11];
 				get_perm_string(first_perm, sizeof(first_perm), first->mode);
 				get_perm_string(second_perm, sizeof(second_perm), second->mode);
-				retval = strcmp(first_perm, second_perm);
+				return strcmp(first_perm, second_perm);
 			}
-			break;
 #endif
 	}
 
-	if(retval == 0)
-	{
-		retval = first->list_num - second->list_num;
-	}
-	else if(sort_descending)
-	{
-		retval = -retval;
-	}
-
-	return retval;
+	return 0;
 }
 
-/* Compares names of two file entries.  Returns positive value if a is greater
- * than b, zero if they are equal, otherwise negative value is returned. */
-static int
-compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case)
+/* Picks name of the entry to be used for sorting by name.  Returns the
+ * name. */
+static const char *
+sort_name(const dir_entry_t *entry, const sort_data_t *data)
 {
-	char a_short_path[PATH_MAX];
-	char b_short_path[PATH_MAX];
-
-	get_short_path_of(view, a, 0, sizeof(a_short_path), a_short_path);
-	get_short_path_of(view, b, 0, sizeof(b_short_path), b_short_path);
-
-	return compare_full_file_names(a_short_path, b_short_path, ignore_case);
+	return (data->name == NULL) ? entry->name : data->name;
 }
 
 /* Compares two full filenames and assumes that dot character is smaller than
- * any other character.  Returns positive value if s is greater than t, zero if
- * they are equal, otherwise negative value is returned. */
+ * any other character.  Lower case versions of the names are used for
+ * case-insensitive comparison if they are passed in.  Returns positive value if
+ * s is greater than t, zero if they are equal, otherwise negative value is
+ * returned. */
 static int
-compare_full_file_names(const char s[], const char t[], int ignore_case)
+compare_full_file_names(const char s[], const char t[], const char lower_s[],
+		const char lower_t[])
 {
 	if(s[0] == '.' && t[0] != '.')
 	{
@@ -351,9 +670,13 @@ compare_full_file_names(const char s[], const char t[], int ignore_case)
 	{
 		return 1;
 	}
+	else if(lower_s != NULL && lower_t != NULL)
+	{
+		return compare_lowered_file_names(s, t, lower_s, lower_t);
+	}
 	else
 	{
-		return compare_file_names(s, t, ignore_case);
+		return compare_file_names(s, t, 0);
 	}
 }
 
@@ -389,6 +712,29 @@ compare_file_names(const char s[], const char t[], int ignore_case)
 	return result;
 }
 
+/* Same as compare_file_names() with ignore_case set, but uses already computed
+ * lower case versions of the names.  Returns positive value if s is greater
+ * than t, zero if they are equal, otherwise negative value is returned. */
+static int
+compare_lowered_file_names(const char s[], const char t[], const char lower_s[],
+		const char lower_t[])
+{
+	const int result = cfg.sort_numbers ? strnumcmp(lower_s, lower_t)
+	                                    : strcmp(lower_s, lower_t);
+	return (result == 0) ? strcmp(s, t) : result;
+}
+
+/* Makes lower case version of the name in the same way compare_file_names()
+ * does it.  Returns newly allocated string or NULL on error. */
+static char *
+make_lower_name(const char name[])
+{
+	char buf[NAME_MAX];
+	/* Ignore too small buffer errors by not caring about part that didn't fit. */
+	(void)str_to_lower(name, buf, sizeof(buf));
+	return strdup(buf);
+}
+
 SortingKey
 get_secondary_key(SortingKey primary_key)
 {
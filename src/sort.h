@@ -25,12 +25,18 @@
 
 void sort_view(FileView *view);
 
+/* Finds position at which the entry should be inserted into sorted list of the
+ * view to keep it sorted.  The entry goes after all entries equal to it.
+ * Returns the position. */
+int sort_find_pos(FileView *view, dir_entry_t *entry);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
 
 TSTATIC_DEFS(
 	int strnumcmp(const char s[], const char t[]);
+	void sort_view_entries(FileView *v, int prepare);
 )
 
 #endif /* VIFM__SORT_H__ */
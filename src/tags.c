@@ -41,6 +41,8 @@ const char *tags[] = {
 	"vifm-'confirm'",
 	"vifm-'cpo'",
 	"vifm-'cpoptions'",
+	"vifm-'dirloadthreads'",
+	"vifm-'dirsizemode'",
 	"vifm-'dotdirs'",
 	"vifm-'fastrun'",
 	"vifm-'fcs'",
@@ -59,6 +61,7 @@ const char *tags[] = {
 	"vifm-'iec'",
 	"vifm-'ignorecase'",
 	"vifm-'incsearch'",
+	"vifm-'iothreads'",
 	"vifm-'is'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
@@ -36,6 +36,7 @@
 #include "../compat/fs_limits.h"
 #include "../utils/filemon.h"
 #include "../utils/filter.h"
+#include "../utils/str_pool.h"
 #include "../utils/trie.h"
 #include "../color_scheme.h"
 #include "../column_view.h"
@@ -134,11 +135,30 @@ typedef struct
 }
 history_t;
 
+/* Fields are grouped by how often they are accessed: the first group is used
+ * by drawing and selection, the second one by sorting and the last one is
+ * rarely needed.  Flags are packed into bit-fields to keep the structure
+ * small, which matters for views with lots of entries. */
 typedef struct
 {
 	char *name;
-	char *origin;     /* Location where this file comes from. */
+	FileType type;
+	int hi_num;       /* File highlighting parameters cache (initially -1). */
+
+	unsigned int selected : 1;
+	unsigned int was_selected : 1; /* Previous selection state in Visual mode. */
+	unsigned int marked : 1;       /* Whether file should be processed. */
+	unsigned int pooled_name : 1;  /* Whether name comes from a string pool. */
+	unsigned int unfilled : 1;     /* Whether meta-data is yet to be loaded. */
+
+	short int match_left;  /* Starting position of the match. */
+	short int match_right; /* Ending position of the match. */
+	int search_match;      /* Whether the item matches last search. */
+
 	uint64_t size;
+	time_t mtime;
+	time_t atime;
+	time_t ctime;
 #ifndef _WIN32
 	uid_t uid;
 	gid_t gid;
@@ -146,23 +166,12 @@ typedef struct
 #else
 	DWORD attrs;
 #endif
-	time_t mtime;
-	time_t atime;
-	time_t ctime;
-	FileType type;
-
-	int selected;
-	int was_selected; /* Stores previous selection state in Visual mode. */
-
-	int search_match;      /* Whether the item matches last search. */
-	short int match_left;  /* Starting position of the match. */
-	short int match_right; /* Ending position of the match. */
-
 	int list_num;     /* Used by sorting comparer to perform stable sort. */
 
-	int marked;       /* Whether file should be processed. */
-
-	int hi_num;       /* File highlighting parameters cache (initially -1). */
+#ifndef _WIN32
+	ino_t inode;      /* Inode number, used to detect replaced files. */
+#endif
+	char *origin;     /* Location where this file comes from. */
 }
 dir_entry_t;
 
@@ -208,6 +217,10 @@ typedef struct
 #endif
 	char last_dir[PATH_MAX];
 
+	/* Storage for names of entries of the most recent file list, a new pool is
+	 * started on each full load of the list. */
+	str_pool_t *names_pool;
+
 	/* Number of files that match current search pattern. */
 	int matches;
 	/* Last used search pattern, empty if none. */
@@ -272,6 +285,12 @@ typedef struct
 		int *poshist;
 		/* Number of elements in the poshist field. */
 		size_t poshist_len;
+
+		/* Results of filtering by values of the filter typed so far, each next
+		 * one narrows the previous one. */
+		struct filter_level_t *levels;
+		/* Number of elements in the levels field. */
+		size_t nlevels;
 	}
 	local_filter;
 
@@ -307,6 +326,7 @@ typedef struct
 	uint64_t postponed_redraw;      /* Time of last redraw request. */
 	uint64_t postponed_reload;      /* Time of last redraw request. */
 	uint64_t postponed_full_reload; /* Time of last full redraw request. */
+	uint64_t notified_reload;       /* Time of reload request by file monitor. */
 
 	uint64_t last_redraw; /* Time of last redraw. */
 	uint64_t last_reload; /* Time of last [full] reload. */
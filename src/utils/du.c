@@ -0,0 +1,701 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "du.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <pthread.h> /* pthread_* */
+#include <sys/stat.h> /* S_ISDIR stat */
+#include <sys/types.h> /* dev_t ino_t */
+#include <dirent.h> /* DIR dirent */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW fstatat() */
+#include <unistd.h> /* sysconf() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* strdup() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "path.h"
+#include "str.h"
+
+/* Number of directories passed to du_publish_func at once. */
+#define PUBLISH_BATCH 128
+
+/* Maximum number of threads used when their number isn't specified. */
+#define MAX_DEFAULT_THREADS 8
+
+/* Directory of the subtree. */
+typedef struct dir_t
+{
+	struct dir_t *parent; /* Directory that contains this one or NULL. */
+	char *path;           /* Full path to the directory. */
+	uint64_t size;        /* Size accumulated so far. */
+	size_t nsubdirs;      /* Number of immediate subdirectories. */
+	int has_id;           /* Whether id field is filled in. */
+	du_id_t id;           /* Identity of the directory. */
+	/* Number of unfinished subdirectories plus one until files of this
+	 * directory are processed. */
+	int pending;
+}
+dir_t;
+
+/* Double-ended queue of directories of a worker.  Owner takes the newest
+ * directories, while other workers steal the oldest ones, which are likely to
+ * be closer to the root and thus have bigger subtrees. */
+typedef struct
+{
+	dir_t **dirs; /* Circular buffer. */
+	size_t cap;   /* Capacity of the buffer. */
+	size_t head;  /* Index of the oldest element. */
+	size_t count; /* Number of elements. */
+}
+deque_t;
+
+/* Identifier of a file. */
+typedef struct
+{
+	dev_t dev; /* Device. */
+	ino_t ino; /* Inode number, zero for unused slots. */
+}
+file_id_t;
+
+/* State of calculation. */
+typedef struct
+{
+	const du_params_t *params; /* Parameters of calculation. */
+
+	pthread_mutex_t lock; /* Protects all fields below. */
+	pthread_cond_t cond;  /* Signals about new directories or finishing. */
+
+	deque_t *deques; /* Queue of each worker. */
+	int nworkers;    /* Number of elements in the deques array. */
+	size_t queued;   /* Number of directories in all queues. */
+	size_t active;   /* Number of directories queued or being processed. */
+
+	file_id_t *links;  /* Hash set of files with several hard links. */
+	size_t links_cap;  /* Capacity of the links set, power of two. */
+	size_t nlinks;     /* Number of elements in the links set. */
+
+	du_dir_t *batch;  /* Directories to be published. */
+	size_t nbatch;    /* Number of elements in the batch array. */
+	size_t batch_cap; /* Capacity of the batch array. */
+
+	uint64_t total; /* Size of the root directory. */
+}
+du_state_t;
+
+/* Argument of a worker thread. */
+typedef struct
+{
+	du_state_t *state; /* State of calculation. */
+	int index;         /* Index of the worker. */
+}
+worker_t;
+
+static void * worker_thread(void *arg);
+static void run_worker(du_state_t *state, int index);
+static dir_t * take_dir(du_state_t *state, int index);
+static void process_dir(du_state_t *state, int index, dir_t *dir);
+static int query_dir_id(DIR *d, const char path[], du_id_t *id);
+static int query_entry(DIR *d, const char path[], const struct dirent *dentry,
+		struct stat *st);
+static int add_subdir(dir_t ***subdirs, size_t *nsubdirs, dir_t *parent,
+		char path[]);
+static int push_dir(deque_t *deque, dir_t *dir);
+static int is_first_link(du_state_t *state, const struct stat *st);
+static int grow_links(du_state_t *state);
+static size_t hash_file_id(dev_t dev, ino_t ino);
+static du_dir_t * finish_dir(du_state_t *state, dir_t *dir, size_t *count);
+static int add_to_batch(du_state_t *state, const dir_t *dir);
+static void publish(const du_state_t *state, du_dir_t batch[], size_t count);
+static int get_nthreads(void);
+
+uint64_t
+du_calculate(const char path[], const du_params_t *params)
+{
+	du_state_t state = { .params = params };
+	const int nthreads = (params->nthreads < 1) ? get_nthreads()
+	                                            : params->nthreads;
+	pthread_t *threads;
+	worker_t *workers;
+	dir_t *root;
+	int started;
+	int i;
+
+	state.deques = calloc(nthreads, sizeof(*state.deques));
+	threads = calloc(nthreads, sizeof(*threads));
+	workers = calloc(nthreads, sizeof(*workers));
+	root = malloc(sizeof(*root));
+	if(state.deques == NULL || threads == NULL || workers == NULL ||
+			root == NULL || (root->path = strdup(path)) == NULL)
+	{
+		free(root);
+		free(workers);
+		free(threads);
+		free(state.deques);
+		return 0U;
+	}
+
+	root->parent = NULL;
+	root->size = 0U;
+	root->nsubdirs = 0U;
+	root->has_id = 0;
+	root->pending = 1;
+
+	state.nworkers = nthreads;
+	if(push_dir(&state.deques[0], root) != 0)
+	{
+		free(root->path);
+		free(root);
+		free(workers);
+		free(threads);
+		free(state.deques);
+		return 0U;
+	}
+	state.queued = 1U;
+	state.active = 1U;
+
+	pthread_mutex_init(&state.lock, NULL);
+	pthread_cond_init(&state.cond, NULL);
+
+	/* Calling thread is the first worker. */
+	started = 0;
+	for(i = 1; i < nthreads; ++i)
+	{
+		workers[started].state = &state;
+		workers[started].index = i;
+		if(pthread_create(&threads[started], NULL, &worker_thread,
+					&workers[started]) == 0)
+		{
+			++started;
+		}
+	}
+
+	run_worker(&state, 0);
+
+	for(i = 0; i < started; ++i)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	publish(&state, state.batch, state.nbatch);
+
+	pthread_cond_destroy(&state.cond);
+	pthread_mutex_destroy(&state.lock);
+
+	for(i = 0; i < nthreads; ++i)
+	{
+		free(state.deques[i].dirs);
+	}
+	free(state.links);
+	free(workers);
+	free(threads);
+	free(state.deques);
+
+	return state.total;
+}
+
+/* Entry point of a worker thread.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	const worker_t *const worker = arg;
+	run_worker(worker->state, worker->index);
+	return NULL;
+}
+
+/* Processes directories until all of them are done. */
+static void
+run_worker(du_state_t *state, int index)
+{
+	pthread_mutex_lock(&state->lock);
+	while(1)
+	{
+		dir_t *dir;
+
+		while(state->queued == 0U && state->active != 0U)
+		{
+			pthread_cond_wait(&state->cond, &state->lock);
+		}
+		if(state->active == 0U)
+		{
+			break;
+		}
+
+		dir = take_dir(state, index);
+		pthread_mutex_unlock(&state->lock);
+
+		process_dir(state, index, dir);
+
+		pthread_mutex_lock(&state->lock);
+	}
+	pthread_mutex_unlock(&state->lock);
+}
+
+/* Picks directory to process from own queue or steals it from queue of another
+ * worker.  Must be called with the lock held and non-zero number of queued
+ * directories.  Returns the directory. */
+static dir_t *
+take_dir(du_state_t *state, int index)
+{
+	int i;
+	deque_t *deque = &state->deques[index];
+
+	--state->queued;
+
+	if(deque->count != 0U)
+	{
+		--deque->count;
+		return deque->dirs[(deque->head + deque->count)%deque->cap];
+	}
+
+	for(i = 1; i < state->nworkers; ++i)
+	{
+		deque = &state->deques[(index + i)%state->nworkers];
+		if(deque->count != 0U)
+		{
+			dir_t *const dir = deque->dirs[deque->head];
+			deque->head = (deque->head + 1U)%deque->cap;
+			--deque->count;
+			return dir;
+		}
+	}
+
+	/* Can't get here because queued counter isn't zero. */
+	return NULL;
+}
+
+/* Sums up sizes of files of the directory and queues its subdirectories. */
+static void
+process_dir(du_state_t *state, int index, dir_t *dir)
+{
+	const du_params_t *const params = state->params;
+	const char *const slash = ends_with_slash(dir->path) ? "" : "/";
+	dir_t **subdirs = NULL;
+	size_t nsubdirs = 0U;
+	uint64_t size = 0U;
+	size_t nfound = 0U;
+	du_dir_t *batch;
+	size_t count;
+	size_t i;
+	DIR *d;
+
+	d = os_opendir(dir->path);
+	if(d != NULL)
+	{
+		struct dirent *dentry;
+
+		dir->has_id = (query_dir_id(d, dir->path, &dir->id) == 0);
+
+		while((dentry = os_readdir(d)) != NULL)
+		{
+			struct stat st;
+			int type;
+
+			if(is_builtin_dir(dentry->d_name))
+			{
+				continue;
+			}
+
+			type = query_entry(d, dir->path, dentry, &st);
+			if(type < 0)
+			{
+				continue;
+			}
+
+			if(type > 0)
+			{
+				uint64_t known;
+				char *const path = format_str("%s%s%s", dir->path, slash,
+						dentry->d_name);
+
+				++nfound;
+
+				if(params->lookup != NULL && params->lookup(path, &known, params->arg))
+				{
+					size += known;
+					free(path);
+				}
+				else if(add_subdir(&subdirs, &nsubdirs, dir, path) != 0)
+				{
+					free(path);
+				}
+				continue;
+			}
+
+			if(st.st_nlink > 1 && !is_first_link(state, &st))
+			{
+				continue;
+			}
+
+#ifndef _WIN32
+			size += params->allocated ? (uint64_t)st.st_blocks*512U : st.st_size;
+#else
+			size += st.st_size;
+#endif
+		}
+		os_closedir(d);
+	}
+
+	pthread_mutex_lock(&state->lock);
+
+	dir->size += size;
+	dir->nsubdirs = nfound;
+	for(i = 0U; i < nsubdirs; ++i)
+	{
+		if(push_dir(&state->deques[index], subdirs[i]) == 0)
+		{
+			++dir->pending;
+			++state->queued;
+			++state->active;
+		}
+		else
+		{
+			free(subdirs[i]->path);
+			free(subdirs[i]);
+		}
+	}
+	if(nsubdirs != 0U)
+	{
+		pthread_cond_broadcast(&state->cond);
+	}
+
+	batch = finish_dir(state, dir, &count);
+
+	if(--state->active == 0U)
+	{
+		pthread_cond_broadcast(&state->cond);
+	}
+
+	pthread_mutex_unlock(&state->lock);
+
+	free(subdirs);
+
+	if(batch != NULL)
+	{
+		publish(state, batch, count);
+	}
+}
+
+/* Retrieves identity of an opened directory.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+query_dir_id(DIR *d, const char path[], du_id_t *id)
+{
+#ifndef _WIN32
+	struct stat st;
+	if(fstat(dirfd(d), &st) != 0)
+	{
+		return 1;
+	}
+
+	id->dev = st.st_dev;
+	id->ino = st.st_ino;
+	id->mtime = st.st_mtime;
+	return 0;
+#else
+	/* Inode numbers aren't available. */
+	return 1;
+#endif
+}
+
+/* Queries information about directory entry without following symbolic links.
+ * Returns negative number on error, zero for files and positive number for
+ * directories. */
+static int
+query_entry(DIR *d, const char path[], const struct dirent *dentry,
+		struct stat *st)
+{
+#ifndef _WIN32
+	if(dentry->d_type == DT_DIR)
+	{
+		return 1;
+	}
+	if(fstatat(dirfd(d), dentry->d_name, st, AT_SYMLINK_NOFOLLOW) != 0)
+	{
+		return -1;
+	}
+#else
+	char full_path[PATH_MAX];
+	snprintf(full_path, sizeof(full_path), "%s/%s", path, dentry->d_name);
+	if(os_lstat(full_path, st) != 0)
+	{
+		return -1;
+	}
+#endif
+	return S_ISDIR(st->st_mode) ? 1 : 0;
+}
+
+/* Appends new subdirectory of the parent to the list.  Takes ownership of the
+ * path on success.  Returns zero on success, otherwise non-zero is returned. */
+static int
+add_subdir(dir_t ***subdirs, size_t *nsubdirs, dir_t *parent, char path[])
+{
+	dir_t *dir;
+	void *const p = reallocarray(*subdirs, *nsubdirs + 1U, sizeof(**subdirs));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	*subdirs = p;
+
+	dir = malloc(sizeof(*dir));
+	if(dir == NULL)
+	{
+		return 1;
+	}
+
+	dir->parent = parent;
+	dir->path = path;
+	dir->size = 0U;
+	dir->nsubdirs = 0U;
+	dir->has_id = 0;
+	dir->pending = 1;
+
+	(*subdirs)[(*nsubdirs)++] = dir;
+	return 0;
+}
+
+/* Adds directory to the end of the queue.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+push_dir(deque_t *deque, dir_t *dir)
+{
+	if(deque->count == deque->cap)
+	{
+		size_t i;
+		const size_t new_cap = (deque->cap == 0U) ? 16U : deque->cap*2U;
+		dir_t **const dirs = reallocarray(NULL, new_cap, sizeof(*dirs));
+		if(dirs == NULL)
+		{
+			return 1;
+		}
+
+		for(i = 0U; i < deque->count; ++i)
+		{
+			dirs[i] = deque->dirs[(deque->head + i)%deque->cap];
+		}
+
+		free(deque->dirs);
+		deque->dirs = dirs;
+		deque->cap = new_cap;
+		deque->head = 0U;
+	}
+
+	deque->dirs[(deque->head + deque->count)%deque->cap] = dir;
+	++deque->count;
+	return 0;
+}
+
+/* Checks whether file with several hard links is seen for the first time.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_first_link(du_state_t *state, const struct stat *st)
+{
+	size_t i;
+	int first = 1;
+
+	pthread_mutex_lock(&state->lock);
+
+	if((state->nlinks + 1U)*4U > state->links_cap*3U && grow_links(state) != 0)
+	{
+		/* Count the file in case of memory shortage. */
+		pthread_mutex_unlock(&state->lock);
+		return 1;
+	}
+
+	i = hash_file_id(st->st_dev, st->st_ino) & (state->links_cap - 1U);
+	while(state->links[i].ino != 0)
+	{
+		if(state->links[i].ino == st->st_ino && state->links[i].dev == st->st_dev)
+		{
+			first = 0;
+			break;
+		}
+		i = (i + 1U) & (state->links_cap - 1U);
+	}
+
+	if(first)
+	{
+		state->links[i].dev = st->st_dev;
+		state->links[i].ino = st->st_ino;
+		++state->nlinks;
+	}
+
+	pthread_mutex_unlock(&state->lock);
+	return first;
+}
+
+/* Doubles capacity of the set of hard links.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+grow_links(du_state_t *state)
+{
+	size_t i;
+	const size_t new_cap = (state->links_cap == 0U) ? 64U : state->links_cap*2U;
+	file_id_t *const links = calloc(new_cap, sizeof(*links));
+	if(links == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < state->links_cap; ++i)
+	{
+		const file_id_t *const id = &state->links[i];
+		if(id->ino != 0)
+		{
+			size_t j = hash_file_id(id->dev, id->ino) & (new_cap - 1U);
+			while(links[j].ino != 0)
+			{
+				j = (j + 1U) & (new_cap - 1U);
+			}
+			links[j] = *id;
+		}
+	}
+
+	free(state->links);
+	state->links = links;
+	state->links_cap = new_cap;
+	return 0;
+}
+
+/* Computes hash of file identifier.  Returns the hash. */
+static size_t
+hash_file_id(dev_t dev, ino_t ino)
+{
+	const uint64_t key = (uint64_t)ino*0x9e3779b97f4a7c15ULL ^ (uint64_t)dev;
+	return (size_t)(key ^ (key >> 29));
+}
+
+/* Marks one part of the directory as done and propagates sizes of finished
+ * directories to their parents.  Must be called with the lock held.  Returns
+ * batch of directories to publish and sets *count or returns NULL. */
+static du_dir_t *
+finish_dir(du_state_t *state, dir_t *dir, size_t *count)
+{
+	du_dir_t *batch;
+
+	while(dir != NULL && --dir->pending == 0)
+	{
+		dir_t *const parent = dir->parent;
+
+		if(parent == NULL)
+		{
+			state->total = dir->size;
+		}
+		else
+		{
+			parent->size += dir->size;
+		}
+
+		/* On success path is owned by the batch. */
+		if(state->params->publish == NULL || add_to_batch(state, dir) != 0)
+		{
+			free(dir->path);
+		}
+
+		free(dir);
+		dir = parent;
+	}
+
+	if(state->nbatch < PUBLISH_BATCH)
+	{
+		return NULL;
+	}
+
+	batch = state->batch;
+	*count = state->nbatch;
+	state->batch = NULL;
+	state->nbatch = 0U;
+	state->batch_cap = 0U;
+
+	return batch;
+}
+
+/* Appends finished directory to the batch.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+add_to_batch(du_state_t *state, const dir_t *dir)
+{
+	if(state->nbatch == state->batch_cap)
+	{
+		const size_t new_cap = state->batch_cap + PUBLISH_BATCH;
+		du_dir_t *const batch = reallocarray(state->batch, new_cap,
+				sizeof(*batch));
+		if(batch == NULL)
+		{
+			return 1;
+		}
+		state->batch = batch;
+		state->batch_cap = new_cap;
+	}
+
+	state->batch[state->nbatch].path = dir->path;
+	state->batch[state->nbatch].size = dir->size;
+	state->batch[state->nbatch].nsubdirs = dir->nsubdirs;
+	state->batch[state->nbatch].has_id = dir->has_id;
+	state->batch[state->nbatch].id = dir->id;
+	++state->nbatch;
+	return 0;
+}
+
+/* Passes batch of directories to the callback and frees it. */
+static void
+publish(const du_state_t *state, du_dir_t batch[], size_t count)
+{
+	size_t i;
+
+	if(count != 0U)
+	{
+		state->params->publish(batch, count, state->params->arg);
+	}
+
+	for(i = 0U; i < count; ++i)
+	{
+		free((char *)batch[i].path);
+	}
+	free(batch);
+}
+
+/* Determines number of threads to use by default, which is the number of
+ * online processors.  Returns the number. */
+static int
+get_nthreads(void)
+{
+#ifndef _WIN32
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	SYSTEM_INFO info;
+	long n;
+	GetSystemInfo(&info);
+	n = info.dwNumberOfProcessors;
+#endif
+	return (n < 1) ? 1 : (n > MAX_DEFAULT_THREADS) ? MAX_DEFAULT_THREADS : n;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
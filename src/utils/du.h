@@ -0,0 +1,80 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DU_H__
+#define VIFM__UTILS__DU_H__
+
+#include <sys/types.h> /* dev_t ino_t */
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+#include <time.h> /* time_t */
+
+/* du - calculation of sizes of directories by several threads */
+
+/* Identity and state of a directory at the moment it was read. */
+typedef struct
+{
+	dev_t dev;    /* Device. */
+	ino_t ino;    /* Inode number. */
+	time_t mtime; /* Modification time. */
+}
+du_id_t;
+
+/* Size of a directory as reported to du_publish_func. */
+typedef struct
+{
+	const char *path; /* Path to the directory. */
+	uint64_t size;    /* Size of all files in the subtree. */
+	size_t nsubdirs;  /* Number of immediate subdirectories. */
+	int has_id;       /* Whether id field is filled in. */
+	du_id_t id;       /* Identity of the directory. */
+}
+du_dir_t;
+
+/* Checks whether size of the directory is already known, in which case it's
+ * not traversed.  Can be called by several threads at the same time.  Returns
+ * non-zero and sets *size if so, otherwise zero is returned. */
+typedef int (*du_lookup_func)(const char path[], uint64_t *size, void *arg);
+
+/* Receives sizes of count directories once they are calculated.  Can be called
+ * by several threads at the same time. */
+typedef void (*du_publish_func)(const du_dir_t dirs[], size_t count,
+		void *arg);
+
+/* Parameters of calculation. */
+typedef struct
+{
+	int nthreads;            /* Maximum number of threads to use, number of
+	                            online processors is used if it's zero. */
+	int allocated;           /* Count allocated blocks instead of sizes. */
+	du_lookup_func lookup;   /* Source of known sizes, can be NULL. */
+	du_publish_func publish; /* Receiver of calculated sizes, can be NULL. */
+	void *arg;               /* Parameter for callbacks. */
+}
+du_params_t;
+
+/* Calculates size of the directory at path and all of its subdirectories.
+ * Files with several hard links are counted once.  Symbolic links aren't
+ * followed.  Returns size of the directory, which is zero on error. */
+uint64_t du_calculate(const char path[], const du_params_t *params);
+
+#endif /* VIFM__UTILS__DU_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -18,11 +18,35 @@
 
 #include "filemon.h"
 
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h> /* IN_* inotify_add_watch() inotify_event
+                            inotify_init1() */
+#include <unistd.h> /* close() read() */
+#endif
 #include <sys/stat.h> /* stat */
 
+#include <errno.h> /* EINTR errno */
+#include <stddef.h> /* NULL */
 #include <string.h> /* memcmp() memcpy() */
 
+#include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "trie.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+/* Events that change list of files in a directory or invalidate the watch. */
+#define LIST_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+                   | IN_DELETE_SELF | IN_MOVE_SELF)
+/* Events that change files without changing list of files in a directory. */
+#define FILE_EVENTS (IN_ATTRIB | IN_CLOSE_WRITE | IN_MODIFY)
+/* Events that invalidate watch of a single file. */
+#define SELF_EVENTS (IN_DELETE_SELF | IN_MOVE_SELF)
+
+static int read_events(filemon_t *mon, filemon_change_cb cb, void *arg);
+static int add_watch(const char path[], uint32_t mask);
+
+#endif
 
 int
 filemon_from_file(const char path[], filemon_t *timestamp)
@@ -41,10 +65,164 @@ filemon_from_file(const char path[], filemon_t *timestamp)
 #endif
 	timestamp->dev = s.st_dev;
 	timestamp->inode = s.st_ino;
+	timestamp->type = FMT_MODIFIED;
+#ifdef HAVE_SYS_INOTIFY_H
+	timestamp->fd = -1;
+	timestamp->lost = 0;
+	timestamp->changed = 0;
+#endif
+
+	return 0;
+}
+
+int
+filemon_watch_dir(const char path[], filemon_t *mon)
+{
+	filemon_t current;
+
+	if(filemon_from_file(path, &current) != 0)
+	{
+		filemon_reset(mon);
+		return 1;
+	}
+
+#ifdef HAVE_SYS_INOTIFY_H
+	if(filemon_tracks_files(mon, path))
+	{
+		/* Keep watching the same directory, pending notifications are still
+		 * relevant. */
+		current.fd = mon->fd;
+		current.lost = 0;
+	}
+	else
+	{
+		filemon_reset(mon);
+
+		/* Changes made after time stamp was obtained and before watch is added
+		 * will be detected by comparing time stamps. */
+		current.fd = add_watch(path, LIST_EVENTS | FILE_EVENTS);
+		current.lost = 0;
+	}
+#else
+	filemon_reset(mon);
+#endif
+
+	*mon = current;
+	mon->type = FMT_CHANGED;
+	return 0;
+}
+
+int
+filemon_watch_file(const char path[], filemon_t *mon)
+{
+	filemon_t current;
+
+	if(filemon_from_file(path, &current) != 0)
+	{
+		filemon_reset(mon);
+		return 1;
+	}
+
+#ifdef HAVE_SYS_INOTIFY_H
+	if(filemon_tracks_files(mon, path))
+	{
+		current.fd = mon->fd;
+	}
+	else
+	{
+		filemon_reset(mon);
+		current.fd = add_watch(path, FILE_EVENTS | SELF_EVENTS);
+	}
+	current.lost = 0;
+#else
+	filemon_reset(mon);
+#endif
 
+	*mon = current;
+	mon->type = FMT_CHANGED;
 	return 0;
 }
 
+int
+filemon_file_changed(filemon_t *mon)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+	if(mon->type == FMT_CHANGED && mon->fd != -1 && !mon->lost)
+	{
+		/* Events of a file have no name, so the callback isn't invoked. */
+		const int invalidated = read_events(mon, NULL, NULL);
+		const int changed = (mon->changed || invalidated);
+		mon->changed = 0;
+		return changed;
+	}
+#endif
+	return 1;
+}
+
+int
+filemon_tracks_files(const filemon_t *mon, const char path[])
+{
+#ifdef HAVE_SYS_INOTIFY_H
+	filemon_t current;
+	return mon->type == FMT_CHANGED
+	    && mon->fd != -1
+	    && !mon->lost
+	    && filemon_from_file(path, &current) == 0
+	    && current.dev == mon->dev
+	    && current.inode == mon->inode;
+#else
+	return 0;
+#endif
+}
+
+int
+filemon_check(filemon_t *mon, const char path[], filemon_change_cb cb,
+		void *arg)
+{
+	filemon_t current;
+
+	if(mon->type == FMT_UNINITIALIZED)
+	{
+		return 1;
+	}
+
+#ifdef HAVE_SYS_INOTIFY_H
+	if(mon->type == FMT_CHANGED && mon->fd != -1)
+	{
+		const int list_changed = read_events(mon, cb, arg);
+
+		if(filemon_from_file(path, &current) != 0)
+		{
+			return -1;
+		}
+
+		if(list_changed)
+		{
+			/* The change is reported, so it shouldn't be reported again. */
+			mon->ts = current.ts;
+			return 1;
+		}
+
+		if(!filemon_equal(mon, &current))
+		{
+			/* Notifications don't match time stamp, so they can't be trusted
+			 * (e.g., they don't work for some network file systems). */
+			mon->lost = 1;
+			return 1;
+		}
+
+		return 0;
+	}
+#endif
+
+	/* Without notifications only time stamp can be checked. */
+	if(filemon_from_file(path, &current) != 0)
+	{
+		return -1;
+	}
+	return !filemon_equal(mon, &current);
+}
+
 int
 filemon_equal(const filemon_t *a, const filemon_t *b)
 {
@@ -59,5 +237,107 @@ filemon_assign(filemon_t *lhs, const filemon_t *rhs)
 	memcpy(lhs, rhs, sizeof(*rhs));
 }
 
+void
+filemon_reset(filemon_t *mon)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+	if(mon->type == FMT_CHANGED && mon->fd != -1)
+	{
+		(void)close(mon->fd);
+	}
+	mon->fd = -1;
+#endif
+	mon->type = FMT_UNINITIALIZED;
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+/* Creates notification descriptor that watches the path.  Returns the
+ * descriptor or -1 on error. */
+static int
+add_watch(const char path[], uint32_t mask)
+{
+	const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(fd != -1 && inotify_add_watch(fd, path, mask) == -1)
+	{
+		(void)close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Reads all pending events of the monitor.  Invokes the cb once per file which
+ * changed without changing list of files.  Returns non-zero if list of files
+ * might have changed, otherwise zero is returned. */
+static int
+read_events(filemon_t *mon, filemon_change_cb cb, void *arg)
+{
+	/* Buffer is aligned suitably for inotify_event structure. */
+	union
+	{
+		struct inotify_event event;
+		char data[64*(sizeof(struct inotify_event) + NAME_MAX + 1)];
+	}
+	buf;
+	int list_changed = 0;
+	/* Created on the first file event, as most of the polls read nothing. */
+	trie_t reported = NULL_TRIE;
+
+	while(1)
+	{
+		const char *p;
+		const ssize_t len = read(mon->fd, &buf, sizeof(buf));
+		if(len <= 0)
+		{
+			if(len < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+
+		for(p = buf.data; p < buf.data + len; )
+		{
+			const struct inotify_event *const event = (const void *)p;
+			p += sizeof(*event) + event->len;
+
+			if(event->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF |
+						IN_MOVE_SELF))
+			{
+				/* Some events were dropped or the watch doesn't work anymore. */
+				mon->lost = 1;
+			}
+
+			if(event->mask & (LIST_EVENTS | IN_Q_OVERFLOW | IN_IGNORED))
+			{
+				list_changed = 1;
+			}
+			else if((event->mask & FILE_EVENTS) && event->len == 0)
+			{
+				/* Watched file itself has changed. */
+				mon->changed = 1;
+			}
+			else if((event->mask & FILE_EVENTS) && event->len != 0)
+			{
+				if(reported == NULL_TRIE)
+				{
+					reported = trie_create();
+				}
+
+				/* Report every file only once. */
+				if(reported == NULL_TRIE || trie_put(reported, event->name) == 0)
+				{
+					cb(event->name, arg);
+				}
+			}
+		}
+	}
+
+	trie_free(reported);
+	return list_changed;
+}
+
+#endif
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
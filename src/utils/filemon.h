@@ -25,9 +25,19 @@
 
 /* Various time stamp service functions. */
 
+/* Type of file monitor. */
+typedef enum
+{
+	FMT_UNINITIALIZED, /* Monitor isn't initialized. */
+	FMT_MODIFIED,      /* Compares time stamps to detect modifications. */
+	FMT_CHANGED,       /* Additionally uses change notifications if possible. */
+}
+FileMonType;
+
 /* Storage for file monitoring information. */
 typedef struct
 {
+	FileMonType type; /* Type of the monitor. */
 #ifdef HAVE_STRUCT_STAT_ST_MTIM
 	struct timespec ts;
 #else
@@ -35,20 +45,64 @@ typedef struct
 #endif
 	dev_t dev;
 	ino_t inode;
+#ifdef HAVE_SYS_INOTIFY_H
+	int fd;      /* Notification descriptor of FMT_CHANGED monitor or -1. */
+	int lost;    /* Whether some of notifications were lost. */
+	int changed; /* Whether watched file itself has changed. */
+#endif
 }
 filemon_t;
 
+/* Callback invoked by filemon_check() for files inside watched directory which
+ * changed without affecting list of files in the directory. */
+typedef void (*filemon_change_cb)(const char name[], void *arg);
+
 /* Sets file monitor from a file.  Returns zero on success, otherwise non-zero
  * is returned. */
 int filemon_from_file(const char path[], filemon_t *timestamp);
 
+/* Starts watching directory for changes, releasing previous state of the
+ * monitor.  Change notifications are used when they are available, time stamp
+ * of the directory is checked in any case.  Watching of the same directory
+ * continues without losing pending notifications.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int filemon_watch_dir(const char path[], filemon_t *mon);
+
+/* Starts watching a file for changes, releasing previous state of the monitor
+ * unless it already watches the same file.  Change notifications are used when
+ * they are available.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int filemon_watch_file(const char path[], filemon_t *mon);
+
+/* Checks whether file watched via filemon_watch_file() might have changed.
+ * File system isn't queried, so when notifications aren't available this
+ * function always reports a change and time stamps should be compared.
+ * Returns non-zero if so, otherwise zero is returned. */
+int filemon_file_changed(filemon_t *mon);
+
+/* Checks whether the monitor watches the directory and reports all changes
+ * of files in it, so that information about them can be trusted without
+ * querying it again.  Returns non-zero if so, otherwise zero is returned. */
+int filemon_tracks_files(const filemon_t *mon, const char path[]);
+
+/* Checks directory watched via the monitor for changes.  Calls the cb once for
+ * every file in the directory that changed without changing the list of files.
+ * Returns negative value on error, positive value when list of files might
+ * have changed and zero otherwise. */
+int filemon_check(filemon_t *mon, const char path[], filemon_change_cb cb,
+		void *arg);
+
 /* Checks whether two timestamps are equal.  Returns non-zero if so, otherwise
  * zero is returned. */
 int filemon_equal(const filemon_t *a, const filemon_t *b);
 
-/* Assigns value of the *rhs to *lhs. */
+/* Assigns value of the *rhs to *lhs.  Should be used only for monitors created
+ * with filemon_from_file(). */
 void filemon_assign(filemon_t *lhs, const filemon_t *rhs);
 
+/* Releases resources of the monitor and makes it uninitialized. */
+void filemon_reset(filemon_t *mon);
+
 #endif /* VIFM__UTILS__FILEMON_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -27,9 +27,10 @@
 #include <assert.h> /* assert */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strdup() strlen() */
+#include <string.h> /* strcasestr() strdup() strlen() strstr() */
 
 #include "str.h"
+#include "utils.h"
 
 static int append_to_filter(filter_t *filter, const char value[]);
 static void reset_regex(filter_t *filter, const char value[]);
@@ -47,6 +48,7 @@ filter_init(filter_t *filter, int case_sensitive)
 	}
 
 	filter->is_regex_valid = 0;
+	filter->is_literal = 0;
 
 	filter->cflags = REG_EXTENDED;
 
@@ -199,6 +201,9 @@ compile_regex(filter_t *filter, const char value[])
 	assert(!filter->is_regex_valid && "Filter should have been freed.");
 	comp_error = regcomp(&filter->regex, value, filter->cflags);
 	filter->is_regex_valid = comp_error == 0;
+	/* Case of non-ASCII characters can't be ignored by strcasestr(). */
+	filter->is_literal = regexp_is_literal(value)
+	                  && (!(filter->cflags & REG_ICASE) || is_ascii(value));
 }
 
 /* Escapes the string for the purpose of using it in filter.  Returns new
@@ -229,14 +234,24 @@ escape_name_for_filter(const char string[])
 int
 filter_matches(filter_t *filter, const char pattern[])
 {
-	if(filter->is_regex_valid)
+	if(!filter->is_regex_valid)
 	{
-		return regexec(&filter->regex, pattern, 0, NULL, 0) == 0;
+		return -1;
 	}
-	else
+
+	if(filter->is_literal)
 	{
-		return -1;
+		if(!(filter->cflags & REG_ICASE))
+		{
+			return strstr(pattern, filter->raw) != NULL;
+		}
+		if(is_ascii(pattern))
+		{
+			return strcasestr(pattern, filter->raw) != NULL;
+		}
 	}
+
+	return regexec(&filter->regex, pattern, 0, NULL, 0) == 0;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
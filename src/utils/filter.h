@@ -37,6 +37,10 @@ typedef struct
 
 	/* The expression in compiled form when is_regex_valid != 0. */
 	regex_t regex;
+
+	/* Whether valid raw regexp has no special characters, in which case it's
+	 * looked up as a plain string. */
+	int is_literal;
 }
 filter_t;
 
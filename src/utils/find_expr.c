@@ -0,0 +1,513 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "find_expr.h"
+
+#ifndef _WIN32
+#include <fnmatch.h> /* FNM_CASEFOLD fnmatch() */
+#endif
+#include <regex.h> /* REG_EXTENDED REG_ICASE REG_NOSUB regex_t regexec() */
+#include <sys/stat.h> /* stat */
+
+#include <ctype.h> /* isdigit() isspace() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() strtoull() */
+#include <string.h> /* strchr() strcmp() strdup() */
+#include <time.h> /* time() time_t */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "globs.h"
+#include "path.h"
+#include "regex_set.h"
+#include "str.h"
+#include "string_array.h"
+#include "utils.h"
+
+/* Number of seconds in a day, which is the unit of -mtime. */
+#define SECS_PER_DAY (24*60*60)
+
+/* Kinds of predicates. */
+typedef enum
+{
+	PK_NAME,  /* Shell pattern matched against name of the entry. */
+	PK_PATH,  /* Regular expression matched against full path of the entry. */
+	PK_TYPE,  /* Type of the entry. */
+	PK_SIZE,  /* Size of the entry. */
+	PK_MTIME, /* Age of the entry in days. */
+}
+PredKind;
+
+/* Single predicate of the expression. */
+typedef struct
+{
+	PredKind kind;            /* Kind of the predicate. */
+	int re_index;             /* Index of regular expression for PK_PATH (and
+	                             PK_NAME on Windows). */
+	char *glob;               /* Pattern for PK_NAME. */
+	int fnm_flags;            /* Flags for fnmatch() for PK_NAME. */
+	FswalkType type;          /* Expected type for PK_TYPE. */
+	int cmp;                  /* -1, 0 or 1 for less than, equal to or greater
+	                             than the value for PK_SIZE and PK_MTIME. */
+	unsigned long long value; /* Value to compare against. */
+	unsigned long long unit;  /* Unit of size for PK_SIZE. */
+}
+pred_t;
+
+struct find_expr_t
+{
+	pred_t *preds; /* List of predicates. */
+	int npreds;    /* Number of predicates. */
+
+	regex_set_t *regexes; /* Regular expressions used by predicates. */
+
+	time_t now; /* Time of parsing, which is a base for -mtime. */
+};
+
+static char ** split_args(const char args[], int *count);
+static int parse_pred(find_expr_t *expr, char *argv[], int argc, int *i,
+		char **error);
+static int parse_number(const char arg[], int *cmp, unsigned long long *value,
+		unsigned long long *unit);
+static void free_preds(pred_t preds[], int count);
+static int pred_matches(const pred_t *pred, const find_expr_t *expr,
+		regex_t *regexes, const char path[], FswalkType type, struct stat *st,
+		int *st_state);
+static int compare(unsigned long long actual, int cmp,
+		unsigned long long expected);
+
+find_expr_t *
+find_expr_parse(const char args[], char ***roots, int *nroots, char **error)
+{
+	int argc;
+	char **argv;
+	int i;
+	find_expr_t *expr;
+
+	*error = NULL;
+	*roots = NULL;
+	*nroots = 0;
+
+	argv = split_args(args, &argc);
+	if(argc < 0)
+	{
+		replace_string(error, "Unmatched quote");
+		return NULL;
+	}
+
+	expr = malloc(sizeof(*expr));
+	if(expr == NULL)
+	{
+		free_string_array(argv, argc);
+		replace_string(error, "Not enough memory");
+		return NULL;
+	}
+
+	expr->preds = NULL;
+	expr->npreds = 0;
+	expr->regexes = regex_set_alloc();
+	expr->now = time(NULL);
+
+	if(expr->regexes == NULL)
+	{
+		free_string_array(argv, argc);
+		free(expr);
+		replace_string(error, "Not enough memory");
+		return NULL;
+	}
+
+	for(i = 0; i < argc && argv[i][0] != '-'; ++i)
+	{
+		*nroots = add_to_string_array(roots, *nroots, 1, argv[i]);
+	}
+
+	while(i < argc)
+	{
+		if(parse_pred(expr, argv, argc, &i, error) != 0)
+		{
+			break;
+		}
+	}
+
+	free_string_array(argv, argc);
+
+	if(*error != NULL)
+	{
+		find_expr_free(expr);
+		free_string_array(*roots, *nroots);
+		*roots = NULL;
+		*nroots = 0;
+		return NULL;
+	}
+
+	return expr;
+}
+
+/* Breaks command-line into arguments processing quotes and escaping like shell
+ * does.  *count is set to -1 on unmatched quote.  Returns list of arguments. */
+static char **
+split_args(const char args[], int *count)
+{
+	char **argv = NULL;
+	*count = 0;
+
+	while(1)
+	{
+		char *arg;
+		size_t len = 0U;
+
+		while(isspace((unsigned char)*args))
+		{
+			++args;
+		}
+		if(*args == '\0')
+		{
+			break;
+		}
+
+		arg = strdup("");
+		while(arg != NULL && *args != '\0' && !isspace((unsigned char)*args))
+		{
+			const char quote = *args;
+			if(quote == '\'' || quote == '"')
+			{
+				++args;
+				while(*args != '\0' && *args != quote)
+				{
+					if(quote == '"' && *args == '\\' && args[1] != '\0' &&
+							strchr("\"\\$`", args[1]) != NULL)
+					{
+						++args;
+					}
+					(void)strappendch(&arg, &len, *args++);
+				}
+				if(*args == '\0')
+				{
+					free(arg);
+					free_string_array(argv, *count);
+					*count = -1;
+					return NULL;
+				}
+				++args;
+				continue;
+			}
+
+			if(*args == '\\' && args[1] != '\0')
+			{
+				++args;
+			}
+			(void)strappendch(&arg, &len, *args++);
+		}
+
+		*count = put_into_string_array(&argv, *count, arg);
+	}
+
+	return argv;
+}
+
+/* Parses predicate at *i advancing the index.  Returns zero on success,
+ * otherwise non-zero is returned and *error is set. */
+static int
+parse_pred(find_expr_t *expr, char *argv[], int argc, int *i, char **error)
+{
+	pred_t pred = {
+		.re_index = -1, .glob = NULL, .cmp = 0, .value = 0ULL, .unit = 1ULL
+	};
+	const char *const name = argv[(*i)++];
+	const char *arg;
+	void *p;
+
+	if(strcmp(name, "-a") == 0 || strcmp(name, "-and") == 0 ||
+			strcmp(name, "-print") == 0)
+	{
+		return 0;
+	}
+
+	if(strcmp(name, "-name") != 0 && strcmp(name, "-iname") != 0 &&
+			strcmp(name, "-regex") != 0 && strcmp(name, "-iregex") != 0 &&
+			strcmp(name, "-type") != 0 && strcmp(name, "-size") != 0 &&
+			strcmp(name, "-mtime") != 0)
+	{
+		replace_string(error, format_str("Unsupported find argument: %s", name));
+		return 1;
+	}
+
+	if(*i >= argc)
+	{
+		replace_string(error, format_str("Missing argument of %s", name));
+		return 1;
+	}
+	arg = argv[(*i)++];
+
+	if(strcmp(name, "-name") == 0 || strcmp(name, "-iname") == 0)
+	{
+#ifndef _WIN32
+		/* Patterns are matched like find does it: as a whole and allowing
+		 * wildcards to match leading dot. */
+		pred.kind = PK_NAME;
+		pred.fnm_flags = (name[1] == 'i' ? FNM_CASEFOLD : 0);
+		pred.glob = strdup(arg);
+		if(pred.glob == NULL)
+		{
+			replace_string(error, "Not enough memory");
+			return 1;
+		}
+#else
+		char *const regex = globs_to_regex(arg);
+		if(regex == NULL)
+		{
+			replace_string(error, "Not enough memory");
+			return 1;
+		}
+		pred.kind = PK_NAME;
+		pred.re_index = regex_set_add(expr->regexes, regex,
+				REG_EXTENDED | REG_NOSUB | (name[1] == 'i' ? REG_ICASE : 0), error);
+		free(regex);
+		if(pred.re_index < 0)
+		{
+			return 1;
+		}
+#endif
+	}
+	else if(strcmp(name, "-regex") == 0 || strcmp(name, "-iregex") == 0)
+	{
+		char *const regex = format_str("^(%s)$", arg);
+		pred.kind = PK_PATH;
+		pred.re_index = regex_set_add(expr->regexes, regex,
+				REG_EXTENDED | REG_NOSUB | (name[1] == 'i' ? REG_ICASE : 0), error);
+		free(regex);
+		if(pred.re_index < 0)
+		{
+			return 1;
+		}
+	}
+	else if(strcmp(name, "-type") == 0)
+	{
+		pred.kind = PK_TYPE;
+		if(strcmp(arg, "f") == 0)
+		{
+			pred.type = FWT_FILE;
+		}
+		else if(strcmp(arg, "d") == 0)
+		{
+			pred.type = FWT_DIR;
+		}
+		else if(strcmp(arg, "l") == 0)
+		{
+			pred.type = FWT_LINK;
+		}
+		else
+		{
+			replace_string(error, format_str("Wrong argument of %s: %s", name, arg));
+			return 1;
+		}
+	}
+	else
+	{
+		pred.kind = (name[1] == 's') ? PK_SIZE : PK_MTIME;
+		pred.unit = (pred.kind == PK_SIZE) ? 512ULL : 1ULL;
+		if(parse_number(arg, &pred.cmp, &pred.value,
+					(pred.kind == PK_SIZE) ? &pred.unit : NULL) != 0)
+		{
+			replace_string(error, format_str("Wrong argument of %s: %s", name, arg));
+			return 1;
+		}
+	}
+
+	p = reallocarray(expr->preds, expr->npreds + 1, sizeof(*expr->preds));
+	if(p == NULL)
+	{
+		free(pred.glob);
+		replace_string(error, "Not enough memory");
+		return 1;
+	}
+	expr->preds = p;
+	expr->preds[expr->npreds++] = pred;
+	return 0;
+}
+
+/* Parses numerical argument of the form [+-]N with optional suffix of size
+ * unit if unit isn't NULL.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+parse_number(const char arg[], int *cmp, unsigned long long *value,
+		unsigned long long *unit)
+{
+	char *end;
+
+	*cmp = 0;
+	if(arg[0] == '+' || arg[0] == '-')
+	{
+		*cmp = (arg[0] == '+') ? 1 : -1;
+		++arg;
+	}
+
+	if(!isdigit((unsigned char)arg[0]))
+	{
+		return 1;
+	}
+
+	*value = strtoull(arg, &end, 10);
+	if(*end == '\0')
+	{
+		return 0;
+	}
+	if(unit == NULL || end[1] != '\0')
+	{
+		return 1;
+	}
+
+	switch(*end)
+	{
+		case 'c': *unit = 1ULL; break;
+		case 'w': *unit = 2ULL; break;
+		case 'b': *unit = 512ULL; break;
+		case 'k': *unit = 1024ULL; break;
+		case 'M': *unit = 1024ULL*1024ULL; break;
+		case 'G': *unit = 1024ULL*1024ULL*1024ULL; break;
+
+		default:
+			return 1;
+	}
+	return 0;
+}
+
+void
+find_expr_free(find_expr_t *expr)
+{
+	if(expr == NULL)
+	{
+		return;
+	}
+
+	regex_set_free(expr->regexes);
+	free_preds(expr->preds, expr->npreds);
+	free(expr);
+}
+
+/* Frees array of predicates along with their data. */
+static void
+free_preds(pred_t preds[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(preds[i].glob);
+	}
+	free(preds);
+}
+
+int
+find_expr_matches(find_expr_t *expr, const char path[], FswalkType type)
+{
+	int i;
+	struct stat st;
+	/* 0 - not queried yet, 1 - queried, -1 - failed to query. */
+	int st_state = 0;
+
+	regex_t *regexes = NULL;
+	if(regex_set_count(expr->regexes) != 0)
+	{
+		regexes = regex_set_get(expr->regexes);
+		if(regexes == NULL)
+		{
+			return 0;
+		}
+	}
+
+	/* File properties are requested lazily to avoid querying them when
+	 * predicates that are evaluated earlier already fail. */
+	for(i = 0; i < expr->npreds; ++i)
+	{
+		if(!pred_matches(&expr->preds[i], expr, regexes, path, type, &st,
+					&st_state))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Checks whether entry matches single predicate.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+pred_matches(const pred_t *pred, const find_expr_t *expr, regex_t *regexes,
+		const char path[], FswalkType type, struct stat *st, int *st_state)
+{
+	switch(pred->kind)
+	{
+		case PK_NAME:
+#ifndef _WIN32
+			return fnmatch(pred->glob, get_last_path_component(path),
+					pred->fnm_flags) == 0;
+#else
+			return regexec(&regexes[pred->re_index], get_last_path_component(path),
+					0, NULL, 0) == 0;
+#endif
+		case PK_PATH:
+			return regexec(&regexes[pred->re_index], path, 0, NULL, 0) == 0;
+		case PK_TYPE:
+			return type == pred->type;
+
+		case PK_SIZE:
+		case PK_MTIME:
+			break;
+	}
+
+	if(*st_state == 0)
+	{
+		*st_state = (os_lstat(path, st) == 0) ? 1 : -1;
+	}
+	if(*st_state < 0)
+	{
+		return 0;
+	}
+
+	if(pred->kind == PK_SIZE)
+	{
+		/* Size is rounded up to units. */
+		const unsigned long long size = st->st_size;
+		return compare((size + pred->unit - 1ULL)/pred->unit, pred->cmp,
+				pred->value);
+	}
+	else
+	{
+		const time_t age = expr->now - st->st_mtime;
+		return compare((age < 0) ? 0ULL : (unsigned long long)age/SECS_PER_DAY,
+				pred->cmp, pred->value);
+	}
+}
+
+/* Compares actual value against expected one according to cmp.  Returns
+ * non-zero if comparison holds, otherwise zero is returned. */
+static int
+compare(unsigned long long actual, int cmp, unsigned long long expected)
+{
+	if(cmp < 0)
+	{
+		return actual < expected;
+	}
+	if(cmp > 0)
+	{
+		return actual > expected;
+	}
+	return actual == expected;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,53 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FIND_EXPR_H__
+#define VIFM__UTILS__FIND_EXPR_H__
+
+#include "fswalk.h"
+
+/* Subset of expressions of find utility.  Supported predicates are -name,
+ * -iname (shell patterns matched against whole name as by fnmatch()), -regex,
+ * -iregex (extended regular expressions matched against whole path), -type (f,
+ * d or l), -size and -mtime, all of them are joined with implicit "and".  -a,
+ * -and and -print are accepted and ignored.  Files are queried for size and
+ * modification time only if expression needs them.  A single find_expr_t can
+ * be used from multiple threads at the same time. */
+
+/* Opaque parsed expression. */
+typedef struct find_expr_t find_expr_t;
+
+/* Parses command-line of find.  Leading arguments that don't start with a dash
+ * are returned as *roots (should be freed by the caller), arguments can be
+ * quoted or escaped as in shell.  *error is set to error message on failure, it
+ * should be freed by the caller.  Returns parsed expression or NULL on
+ * error. */
+find_expr_t * find_expr_parse(const char args[], char ***roots, int *nroots,
+		char **error);
+
+/* Frees the expression.  expr can be NULL. */
+void find_expr_free(find_expr_t *expr);
+
+/* Checks whether file system entry matches the expression.  Returns non-zero if
+ * so, otherwise zero is returned. */
+int find_expr_matches(find_expr_t *expr, const char path[], FswalkType type);
+
+#endif /* VIFM__UTILS__FIND_EXPR_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
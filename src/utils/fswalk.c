@@ -0,0 +1,576 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "fswalk.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <pthread.h> /* pthread_* */
+#include <regex.h> /* regex_t regcomp() regexec() regfree() */
+#include <sys/stat.h> /* S_ISDIR() stat */
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <dirent.h> /* DIR dirent */
+#include <unistd.h> /* sysconf() */
+
+#include <ctype.h> /* isspace() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strchr() strcmp() strdup() strlen() */
+#include <time.h> /* timespec */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "globs.h"
+#include "path.h"
+#include "str.h"
+#include "string_array.h"
+
+/* Maximum number of worker threads. */
+#define MAX_WORKERS 8
+
+/* How often thread that started traversal checks for cancellation (in
+ * milliseconds). */
+#define CANCEL_CHECK_PERIOD 100
+
+/* Single rule of .gitignore file. */
+typedef struct
+{
+	regex_t re;   /* Compiled glob. */
+	int dir_only; /* Whether the rule applies only to directories. */
+	int anchored; /* Whether the rule is matched against relative path rather
+	                 than just name. */
+}
+rule_t;
+
+/* Rules of a single .gitignore file, which also apply to subdirectories. */
+typedef struct ignore_t
+{
+	struct ignore_t *parent; /* Rules of parent directories or NULL. */
+	char *dir;               /* Directory in which the file resides. */
+	rule_t *rules;           /* List of rules. */
+	int nrules;              /* Number of rules. */
+	struct ignore_t *next;   /* Next element of list of all rules. */
+}
+ignore_t;
+
+/* Unit of work for worker threads. */
+typedef struct
+{
+	char *path;       /* Path to file or directory. */
+	FswalkType type;  /* Type of the entry. */
+	ignore_t *ignore; /* Rules that apply to items of the directory. */
+}
+item_t;
+
+struct fswalk_t
+{
+	pthread_mutex_t lock;       /* Protects all fields below. */
+	pthread_cond_t work_cond;   /* Signaled on new work or its completion. */
+	pthread_cond_t result_cond; /* Signaled on new results or worker exit. */
+
+	item_t *queue; /* Items that wait to be processed. */
+	int queue_len; /* Number of elements in the queue. */
+	int busy;      /* Number of workers that are processing an item. */
+	int running;   /* Number of workers that haven't finished yet. */
+	int stop;      /* Whether workers should quit as soon as possible. */
+
+	char **results; /* Results that weren't delivered yet. */
+	int nresults;   /* Number of undelivered results. */
+
+	ignore_t *ignores; /* List of all loaded ignore rules. */
+
+	int flags;               /* Traversal flags. */
+	fswalk_visit_func visit; /* Visitor. */
+	void *arg;               /* Argument of callbacks. */
+};
+
+static int get_nworkers(void);
+static void * worker_thread(void *arg);
+static void process_item(fswalk_t *walk, const item_t *item);
+static void list_dir(fswalk_t *walk, const item_t *item);
+static void push_items(fswalk_t *walk, item_t items[], int count);
+static ignore_t * load_ignore(fswalk_t *walk, const char dir[],
+		ignore_t *parent);
+static int parse_rule(char line[], rule_t *rule);
+static int is_ignored(const ignore_t *ignore, const char path[],
+		const char name[], int is_dir);
+static void wait_for_results(fswalk_t *walk);
+static void free_ignores(ignore_t *ignore);
+
+int
+fswalk_run(char *roots[], int nroots, int flags, fswalk_visit_func visit,
+		fswalk_result_func result, fswalk_cancel_func cancel, void *arg)
+{
+	fswalk_t walk = {
+		.flags = flags,
+		.visit = visit,
+		.arg = arg,
+	};
+	pthread_t workers[MAX_WORKERS];
+	int nworkers = get_nworkers();
+	int cancelled = 0;
+	int i;
+
+	for(i = 0; i < nroots; ++i)
+	{
+		struct stat st;
+		item_t item = { .path = strdup(roots[i]) };
+		if(item.path == NULL || os_stat(roots[i], &st) != 0)
+		{
+			free(item.path);
+			continue;
+		}
+		item.type = S_ISDIR(st.st_mode) ? FWT_DIR : FWT_FILE;
+		push_items(&walk, &item, 1);
+	}
+
+	pthread_mutex_init(&walk.lock, NULL);
+	pthread_cond_init(&walk.work_cond, NULL);
+	pthread_cond_init(&walk.result_cond, NULL);
+
+	walk.running = nworkers;
+	for(i = 0; i < nworkers; ++i)
+	{
+		if(pthread_create(&workers[i], NULL, &worker_thread, &walk) != 0)
+		{
+			pthread_mutex_lock(&walk.lock);
+			walk.running -= nworkers - i;
+			pthread_mutex_unlock(&walk.lock);
+			break;
+		}
+	}
+	nworkers = i;
+
+	while(nworkers != 0)
+	{
+		char **results;
+		int nresults;
+		int running;
+
+		pthread_mutex_lock(&walk.lock);
+		if(walk.nresults == 0 && walk.running != 0)
+		{
+			wait_for_results(&walk);
+		}
+		results = walk.results;
+		nresults = walk.nresults;
+		running = walk.running;
+		walk.results = NULL;
+		walk.nresults = 0;
+		pthread_mutex_unlock(&walk.lock);
+
+		for(i = 0; i < nresults; ++i)
+		{
+			result(results[i], arg);
+		}
+		free_string_array(results, nresults);
+
+		if(running == 0)
+		{
+			break;
+		}
+
+		if(!cancelled && cancel != NULL && cancel(arg))
+		{
+			cancelled = 1;
+			pthread_mutex_lock(&walk.lock);
+			walk.stop = 1;
+			pthread_cond_broadcast(&walk.work_cond);
+			pthread_mutex_unlock(&walk.lock);
+		}
+	}
+
+	for(i = 0; i < nworkers; ++i)
+	{
+		pthread_join(workers[i], NULL);
+	}
+
+	for(i = 0; i < walk.queue_len; ++i)
+	{
+		free(walk.queue[i].path);
+	}
+	free(walk.queue);
+	free_ignores(walk.ignores);
+
+	pthread_cond_destroy(&walk.result_cond);
+	pthread_cond_destroy(&walk.work_cond);
+	pthread_mutex_destroy(&walk.lock);
+
+	return cancelled || nworkers == 0;
+}
+
+/* Determines number of worker threads to use.  Returns the number. */
+static int
+get_nworkers(void)
+{
+#ifndef _WIN32
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	SYSTEM_INFO info;
+	long n;
+	GetSystemInfo(&info);
+	n = info.dwNumberOfProcessors;
+#endif
+	return (n < 1) ? 1 : (n > MAX_WORKERS) ? MAX_WORKERS : n;
+}
+
+/* Entry point of worker threads.  Processes items until there are no more of
+ * them or stop is requested.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	fswalk_t *const walk = arg;
+
+	pthread_mutex_lock(&walk->lock);
+	while(1)
+	{
+		item_t item;
+
+		while(walk->queue_len == 0 && walk->busy != 0 && !walk->stop)
+		{
+			pthread_cond_wait(&walk->work_cond, &walk->lock);
+		}
+		if(walk->stop || walk->queue_len == 0)
+		{
+			break;
+		}
+
+		item = walk->queue[--walk->queue_len];
+		++walk->busy;
+		pthread_mutex_unlock(&walk->lock);
+
+		process_item(walk, &item);
+		free(item.path);
+
+		pthread_mutex_lock(&walk->lock);
+		if(--walk->busy == 0 && walk->queue_len == 0)
+		{
+			pthread_cond_broadcast(&walk->work_cond);
+		}
+	}
+
+	--walk->running;
+	pthread_cond_signal(&walk->result_cond);
+	pthread_mutex_unlock(&walk->lock);
+
+	return NULL;
+}
+
+/* Visits the item and queues contents of directories. */
+static void
+process_item(fswalk_t *walk, const item_t *item)
+{
+	walk->visit(walk, item->path, item->type, walk->arg);
+	if(item->type == FWT_DIR)
+	{
+		list_dir(walk, item);
+	}
+}
+
+/* Queues files and directories of the directory, which aren't ignored. */
+static void
+list_dir(fswalk_t *walk, const item_t *item)
+{
+	const char *const sep = ends_with_slash(item->path) ? "" : "/";
+	item_t *items = NULL;
+	int nitems = 0;
+	ignore_t *ignore = item->ignore;
+	struct dirent *d;
+
+	DIR *const dir = os_opendir(item->path);
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	if(walk->flags & FSWALK_SKIP_IGNORED)
+	{
+		ignore = load_ignore(walk, item->path, ignore);
+	}
+
+	while((d = os_readdir(dir)) != NULL)
+	{
+		item_t *new_items;
+		char *full_path;
+		FswalkType type;
+
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		full_path = format_str("%s%s%s", item->path, sep, d->d_name);
+		if(full_path == NULL)
+		{
+			continue;
+		}
+
+		type = entry_is_link(full_path, d) ? FWT_LINK
+		     : entry_is_dir(full_path, d) ? FWT_DIR
+		     : FWT_FILE;
+		if((walk->flags & FSWALK_SKIP_IGNORED) &&
+				is_ignored(ignore, full_path, d->d_name, type == FWT_DIR))
+		{
+			free(full_path);
+			continue;
+		}
+
+		new_items = reallocarray(items, nitems + 1, sizeof(*items));
+		if(new_items == NULL)
+		{
+			free(full_path);
+			continue;
+		}
+		items = new_items;
+		items[nitems].path = full_path;
+		items[nitems].type = type;
+		items[nitems].ignore = ignore;
+		++nitems;
+	}
+	os_closedir(dir);
+
+	pthread_mutex_lock(&walk->lock);
+	push_items(walk, items, nitems);
+	pthread_cond_broadcast(&walk->work_cond);
+	pthread_mutex_unlock(&walk->lock);
+
+	free(items);
+}
+
+/* Appends items to the queue.  Must be called with the lock held (or before
+ * workers are started). */
+static void
+push_items(fswalk_t *walk, item_t items[], int count)
+{
+	int i;
+	item_t *const queue = reallocarray(walk->queue, walk->queue_len + count,
+			sizeof(*queue));
+	if(queue == NULL)
+	{
+		for(i = 0; i < count; ++i)
+		{
+			free(items[i].path);
+		}
+		return;
+	}
+
+	walk->queue = queue;
+	for(i = 0; i < count; ++i)
+	{
+		walk->queue[walk->queue_len++] = items[i];
+	}
+}
+
+/* Loads .gitignore file of the directory.  Returns rules to be used for items
+ * of the directory, which might be the parent. */
+static ignore_t *
+load_ignore(fswalk_t *walk, const char dir[], ignore_t *parent)
+{
+	int i;
+	int nlines;
+	char **lines;
+	ignore_t *ignore;
+	char *const path = format_str("%s/.gitignore", dir);
+
+	lines = (path == NULL) ? NULL : read_file_of_lines(path, &nlines);
+	free(path);
+	if(lines == NULL || nlines == 0)
+	{
+		free(lines);
+		return parent;
+	}
+
+	ignore = malloc(sizeof(*ignore));
+	if(ignore == NULL)
+	{
+		free_string_array(lines, nlines);
+		return parent;
+	}
+
+	ignore->parent = parent;
+	ignore->dir = strdup(dir);
+	ignore->rules = reallocarray(NULL, nlines, sizeof(*ignore->rules));
+	ignore->nrules = 0;
+
+	if(ignore->dir == NULL || ignore->rules == NULL)
+	{
+		free(ignore->dir);
+		free(ignore->rules);
+		free(ignore);
+		free_string_array(lines, nlines);
+		return parent;
+	}
+
+	for(i = 0; i < nlines; ++i)
+	{
+		if(parse_rule(lines[i], &ignore->rules[ignore->nrules]) == 0)
+		{
+			++ignore->nrules;
+		}
+	}
+	free_string_array(lines, nlines);
+
+	pthread_mutex_lock(&walk->lock);
+	ignore->next = walk->ignores;
+	walk->ignores = ignore;
+	pthread_mutex_unlock(&walk->lock);
+
+	return ignore;
+}
+
+/* Parses single line of .gitignore file.  The line is modified.  Returns zero
+ * if rule was extracted, otherwise non-zero is returned. */
+static int
+parse_rule(char line[], rule_t *rule)
+{
+	char *regex;
+	size_t len;
+	int cflags = REG_EXTENDED | REG_NOSUB;
+#ifdef _WIN32
+	cflags |= REG_ICASE;
+#endif
+
+	len = strlen(line);
+	while(len != 0U && isspace((unsigned char)line[len - 1U]))
+	{
+		line[--len] = '\0';
+	}
+
+	/* Comments, negated rules and empty lines. */
+	if(line[0] == '#' || line[0] == '!' || line[0] == '\0')
+	{
+		return 1;
+	}
+
+	rule->dir_only = ends_with_slash(line);
+	if(rule->dir_only)
+	{
+		chosp(line);
+	}
+
+	if(starts_with_lit(line, "**/"))
+	{
+		line += 3;
+	}
+	rule->anchored = (strchr(line, '/') != NULL);
+	if(line[0] == '/')
+	{
+		++line;
+	}
+
+	regex = globs_to_regex(line);
+	if(regex == NULL)
+	{
+		return 1;
+	}
+	len = regcomp(&rule->re, regex, cflags);
+	free(regex);
+	return (len != 0U);
+}
+
+/* Checks whether file or directory should be skipped.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_ignored(const ignore_t *ignore, const char path[], const char name[],
+		int is_dir)
+{
+	if(is_dir && (strcmp(name, ".git") == 0 || strcmp(name, ".hg") == 0 ||
+				strcmp(name, ".svn") == 0))
+	{
+		return 1;
+	}
+
+	for(; ignore != NULL; ignore = ignore->parent)
+	{
+		int i;
+		const size_t dir_len = strlen(ignore->dir);
+		const char *const rel_path = path + dir_len
+		                           + (ends_with_slash(ignore->dir) ? 0 : 1);
+
+		for(i = 0; i < ignore->nrules; ++i)
+		{
+			const rule_t *const rule = &ignore->rules[i];
+			if(rule->dir_only && !is_dir)
+			{
+				continue;
+			}
+			if(regexec(&rule->re, rule->anchored ? rel_path : name, 0, NULL, 0) == 0)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Waits for results or termination of workers for a limited amount of time.
+ * Must be called with the lock held. */
+static void
+wait_for_results(fswalk_t *walk)
+{
+	struct timeval tv;
+	struct timespec ts;
+
+	(void)gettimeofday(&tv, NULL);
+	ts.tv_sec = tv.tv_sec;
+	ts.tv_nsec = tv.tv_usec*1000L + CANCEL_CHECK_PERIOD*1000L*1000L;
+	if(ts.tv_nsec >= 1000L*1000L*1000L)
+	{
+		ts.tv_sec += ts.tv_nsec/(1000L*1000L*1000L);
+		ts.tv_nsec %= 1000L*1000L*1000L;
+	}
+
+	(void)pthread_cond_timedwait(&walk->result_cond, &walk->lock, &ts);
+}
+
+/* Frees list of ignore rules. */
+static void
+free_ignores(ignore_t *ignore)
+{
+	while(ignore != NULL)
+	{
+		int i;
+		ignore_t *const next = ignore->next;
+
+		for(i = 0; i < ignore->nrules; ++i)
+		{
+			regfree(&ignore->rules[i].re);
+		}
+		free(ignore->rules);
+		free(ignore->dir);
+		free(ignore);
+
+		ignore = next;
+	}
+}
+
+void
+fswalk_report(fswalk_t *walk, const char result[])
+{
+	pthread_mutex_lock(&walk->lock);
+	walk->nresults = add_to_string_array(&walk->results, walk->nresults, 1,
+			result);
+	pthread_cond_signal(&walk->result_cond);
+	pthread_mutex_unlock(&walk->lock);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,75 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FSWALK_H__
+#define VIFM__UTILS__FSWALK_H__
+
+/* Parallel traversal of file system trees.  Files and directories are visited
+ * on a pool of worker threads, while results they report are delivered on the
+ * thread that started the traversal.  Symbolic links are followed only when
+ * they are passed in as roots.  Order of visiting is unspecified.  Types of
+ * entries are taken from directory listings, so files aren't queried for
+ * their properties unless the listing lacks this information. */
+
+/* Flags that control traversal. */
+typedef enum
+{
+	/* Skip directories of version control systems and files ignored by
+	 * .gitignore files found along the way.  Negated patterns are not
+	 * supported. */
+	FSWALK_SKIP_IGNORED = 1 << 0,
+}
+FswalkFlags;
+
+/* Type of visited entry. */
+typedef enum
+{
+	FWT_FILE, /* Anything that's not a directory or a symbolic link. */
+	FWT_DIR,  /* Directory. */
+	FWT_LINK, /* Symbolic link, which is never followed. */
+}
+FswalkType;
+
+/* Opaque state of traversal. */
+typedef struct fswalk_t fswalk_t;
+
+/* Invoked on a worker thread for every root and every file or directory under
+ * them. */
+typedef void (*fswalk_visit_func)(fswalk_t *walk, const char path[],
+		FswalkType type, void *arg);
+
+/* Invoked on the thread that started traversal for every reported result. */
+typedef void (*fswalk_result_func)(const char result[], void *arg);
+
+/* Invoked periodically on the thread that started traversal.  Returns non-zero
+ * to stop traversal. */
+typedef int (*fswalk_cancel_func)(void *arg);
+
+/* Traverses file system trees starting at the roots.  cancel can be NULL.
+ * Returns zero on success and non-zero if traversal couldn't be started or was
+ * cancelled. */
+int fswalk_run(char *roots[], int nroots, int flags, fswalk_visit_func visit,
+		fswalk_result_func result, fswalk_cancel_func cancel, void *arg);
+
+/* Reports a result from visit callback.  The result is copied. */
+void fswalk_report(fswalk_t *walk, const char result[]);
+
+#endif /* VIFM__UTILS__FSWALK_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
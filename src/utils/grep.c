@@ -0,0 +1,441 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "grep.h"
+
+#include <regex.h> /* REG_ICASE regex_t regexec() */
+#include <sys/stat.h> /* S_ISREG() fstat() stat */
+#include <fcntl.h> /* O_NONBLOCK O_RDONLY open() */
+#include <unistd.h> /* close() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fdopen() fread() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() memmove() strchr() */
+
+#include "../compat/os.h"
+#include "macros.h"
+#include "regex_set.h"
+#include "str.h"
+
+/* Number of bytes at the beginning of a file that are checked for null
+ * characters to detect binary files. */
+#define BINARY_CHECK_LEN (32*1024)
+
+/* Initial size of buffer for contents of a file, it's enlarged to fit longer
+ * lines.  Must not be less than BINARY_CHECK_LEN. */
+#define CHUNK_SIZE (128*1024)
+
+struct grep_t
+{
+	regex_set_t *regex; /* The regular expression. */
+	int invert;         /* Whether non-matching lines are reported. */
+
+	char *literal;      /* String that's part of every matching line or NULL. */
+	size_t literal_len; /* Length of the literal. */
+	int literal_only;   /* Whether presence of the literal implies a match. */
+};
+
+static char * extract_literal(const char pattern[], int cflags,
+		int *literal_only);
+static FILE * open_file(const char path[]);
+static size_t fill_buf(FILE *fp, char buf[], size_t len, size_t size);
+static size_t find_last_line_end(const char text[], size_t len);
+static int search(grep_t *grep, const char path[], const char text[],
+		size_t size, int *line_num, grep_match_func match, void *arg);
+static const char * find_literal(const grep_t *grep, const char from[],
+		const char end[]);
+static int count_lines(const char from[], const char to[]);
+static int copy_line(const char start[], const char end[], char **buf,
+		size_t *buf_len);
+
+grep_t *
+grep_alloc(const char pattern[], int cflags, int invert, char **error)
+{
+	grep_t *grep;
+
+	*error = NULL;
+
+	grep = malloc(sizeof(*grep));
+	if(grep == NULL)
+	{
+		replace_string(error, "Not enough memory");
+		return NULL;
+	}
+
+	grep->regex = regex_set_alloc();
+	if(grep->regex == NULL)
+	{
+		free(grep);
+		replace_string(error, "Not enough memory");
+		return NULL;
+	}
+
+	if(regex_set_add(grep->regex, pattern, cflags, error) < 0)
+	{
+		regex_set_free(grep->regex);
+		free(grep);
+		return NULL;
+	}
+
+	grep->invert = invert;
+	grep->literal = extract_literal(pattern, cflags, &grep->literal_only);
+	grep->literal_len = (grep->literal == NULL) ? 0U : strlen(grep->literal);
+	return grep;
+}
+
+/* Extracts string that starts every match of the pattern.  *literal_only is
+ * set to non-zero when the pattern consists of nothing but the string.
+ * Returns newly allocated string or NULL if there is no such string. */
+static char *
+extract_literal(const char pattern[], int cflags, int *literal_only)
+{
+	size_t len;
+	const char *end;
+	char *literal;
+	int anchored = 0;
+
+	*literal_only = 0;
+
+	/* Case-insensitive search and alternatives aren't accelerated. */
+	if((cflags & REG_ICASE) || strchr(pattern, '|') != NULL)
+	{
+		return NULL;
+	}
+
+	if(pattern[0] == '^')
+	{
+		anchored = 1;
+		++pattern;
+	}
+
+	end = pattern;
+	while(*end != '\0' && strchr(".[]()*+?{}|^$\\", *end) == NULL)
+	{
+		++end;
+	}
+	len = end - pattern;
+
+	if(*end == '\0')
+	{
+		*literal_only = !anchored;
+	}
+	else if(strchr("*?{", *end) != NULL && len != 0U)
+	{
+		/* Last character is optional. */
+		--len;
+	}
+
+	if(len == 0U)
+	{
+		*literal_only = 0;
+		return NULL;
+	}
+
+	literal = malloc(len + 1U);
+	if(literal != NULL)
+	{
+		copy_str(literal, len + 1U, pattern);
+	}
+	return literal;
+}
+
+void
+grep_free(grep_t *grep)
+{
+	if(grep == NULL)
+	{
+		return;
+	}
+
+	regex_set_free(grep->regex);
+	free(grep->literal);
+	free(grep);
+}
+
+int
+grep_file(grep_t *grep, const char path[], grep_match_func match, void *arg)
+{
+	char *buf;
+	size_t size = CHUNK_SIZE;
+	size_t len;
+	int line_num = 1;
+	int result = 0;
+
+	/* Contents is read in chunks instead of being mapped into memory, because
+	 * accessing mapped file that was truncated in the meantime raises
+	 * SIGBUS. */
+	FILE *const fp = open_file(path);
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	buf = malloc(size);
+	if(buf == NULL)
+	{
+		fclose(fp);
+		return 1;
+	}
+
+	len = fill_buf(fp, buf, 0U, size);
+	if(memchr(buf, '\0', MIN(len, BINARY_CHECK_LEN)) != NULL)
+	{
+		result = 1;
+	}
+
+	while(result == 0 && len != 0U)
+	{
+		/* Short read means end of file, otherwise the last line can continue in
+		 * the next chunk. */
+		const int eof = (len < size);
+		const size_t complete = eof ? len : find_last_line_end(buf, len);
+
+		if(complete == 0U)
+		{
+			/* The buffer doesn't fit a single line. */
+			char *const new_buf = realloc(buf, size*2U);
+			if(new_buf == NULL)
+			{
+				result = 1;
+				break;
+			}
+			buf = new_buf;
+			size *= 2U;
+			len = fill_buf(fp, buf, len, size);
+			continue;
+		}
+
+		result = search(grep, path, buf, complete, &line_num, match, arg);
+		if(eof)
+		{
+			break;
+		}
+
+		memmove(buf, buf + complete, len - complete);
+		len = fill_buf(fp, buf, len - complete, size);
+	}
+
+	free(buf);
+	fclose(fp);
+	return result;
+}
+
+/* Opens regular file for reading.  Returns the stream or NULL on error. */
+static FILE *
+open_file(const char path[])
+{
+#ifndef _WIN32
+	struct stat st;
+	FILE *fp;
+
+	/* Non-blocking mode is for not getting stuck on named pipes. */
+	const int fd = open(path, O_RDONLY | O_NONBLOCK);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	fp = fdopen(fd, "rb");
+	if(fp == NULL)
+	{
+		close(fd);
+	}
+	return fp;
+#else
+	return os_fopen(path, "rb");
+#endif
+}
+
+/* Reads data into the buffer of the specified size that already contains len
+ * bytes until it's full or end of file is reached.  Returns new length of data
+ * in the buffer, which is less than size only at the end of file. */
+static size_t
+fill_buf(FILE *fp, char buf[], size_t len, size_t size)
+{
+	while(len < size)
+	{
+		const size_t n = fread(buf + len, 1U, size - len, fp);
+		if(n == 0U)
+		{
+			break;
+		}
+		len += n;
+	}
+	return len;
+}
+
+/* Finds end of the last complete line in the text.  Returns offset past the
+ * new line character or zero if there is no such character. */
+static size_t
+find_last_line_end(const char text[], size_t len)
+{
+	while(len != 0U && text[len - 1U] != '\n')
+	{
+		--len;
+	}
+	return len;
+}
+
+/* Looks for matching lines in the text.  *line_num is number of the first line
+ * of the text and is advanced past its end.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+search(grep_t *grep, const char path[], const char text[], size_t size,
+		int *line_num, grep_match_func match, void *arg)
+{
+	const int use_literal = (grep->literal != NULL && !grep->invert);
+	const char *const end = text + size;
+	const char *pos = text;
+	const char *counted = text;
+	char *line = NULL;
+	size_t line_len = 0U;
+
+	regex_t *re = NULL;
+	if(!use_literal || !grep->literal_only)
+	{
+		re = regex_set_get(grep->regex);
+		if(re == NULL)
+		{
+			return 1;
+		}
+	}
+
+	while(pos < end)
+	{
+		const char *line_start = pos;
+		const char *line_end;
+		int matched;
+
+		if(use_literal)
+		{
+			const char *const hit = find_literal(grep, pos, end);
+			if(hit == NULL)
+			{
+				break;
+			}
+			line_start = hit;
+			while(line_start != pos && line_start[-1] != '\n')
+			{
+				--line_start;
+			}
+		}
+
+		line_end = memchr(line_start, '\n', end - line_start);
+		if(line_end == NULL)
+		{
+			line_end = end;
+		}
+
+		*line_num += count_lines(counted, line_start);
+		counted = line_start;
+
+		if(copy_line(line_start, line_end, &line, &line_len) != 0)
+		{
+			break;
+		}
+
+		matched = (re == NULL) || regexec(re, line, 0, NULL, 0) == 0;
+		if(matched != grep->invert)
+		{
+			match(path, *line_num, line, arg);
+		}
+
+		pos = line_end + 1;
+	}
+
+	*line_num += count_lines(counted, end);
+
+	free(line);
+	return 0;
+}
+
+/* Finds first occurrence of the literal in the range.  Returns pointer to it
+ * or NULL. */
+static const char *
+find_literal(const grep_t *grep, const char from[], const char end[])
+{
+	const char first = grep->literal[0];
+	const size_t len = grep->literal_len;
+
+	while((size_t)(end - from) >= len)
+	{
+		from = memchr(from, first, end - from - (len - 1U));
+		if(from == NULL)
+		{
+			break;
+		}
+		if(memcmp(from, grep->literal, len) == 0)
+		{
+			return from;
+		}
+		++from;
+	}
+	return NULL;
+}
+
+/* Counts new line characters in the range.  Returns the number. */
+static int
+count_lines(const char from[], const char to[])
+{
+	int count = 0;
+	while((from = memchr(from, '\n', to - from)) != NULL)
+	{
+		++count;
+		++from;
+	}
+	return count;
+}
+
+/* Copies line without end-of-line characters into the buffer growing it if
+ * needed.  Returns zero on success, otherwise non-zero is returned. */
+static int
+copy_line(const char start[], const char end[], char **buf, size_t *buf_len)
+{
+	size_t len;
+
+	if(end != start && end[-1] == '\r')
+	{
+		--end;
+	}
+	len = end - start;
+
+	if(len + 1U > *buf_len)
+	{
+		char *const new_buf = realloc(*buf, len + 1U);
+		if(new_buf == NULL)
+		{
+			return 1;
+		}
+		*buf = new_buf;
+		*buf_len = len + 1U;
+	}
+
+	memcpy(*buf, start, len);
+	(*buf)[len] = '\0';
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
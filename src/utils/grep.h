@@ -0,0 +1,54 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__GREP_H__
+#define VIFM__UTILS__GREP_H__
+
+/* Search of lines matching regular expression in files.  Files are read in
+ * big chunks and, when the pattern starts with a literal string, candidate
+ * lines are located by looking for that string before trying the regular
+ * expression.  Binary files (ones with null characters close to their
+ * beginning) are skipped.  A single grep_t can be used from multiple threads
+ * at the same time. */
+
+/* Opaque compiled search pattern. */
+typedef struct grep_t grep_t;
+
+/* Invoked for every matching line.  The line lacks end-of-line characters. */
+typedef void (*grep_match_func)(const char path[], int line_num,
+		const char line[], void *arg);
+
+/* Compiles the pattern, which is an extended regular expression.  Non-zero
+ * invert makes lines that don't match to be reported.  *error is set to error
+ * message on failure, it should be freed by the caller.  Returns compiled
+ * pattern or NULL on error. */
+grep_t * grep_alloc(const char pattern[], int cflags, int invert,
+		char **error);
+
+/* Frees the pattern.  grep can be NULL. */
+void grep_free(grep_t *grep);
+
+/* Searches the file for matching lines.  Returns zero on success and non-zero
+ * if the file couldn't be read or is binary. */
+int grep_file(grep_t *grep, const char path[], grep_match_func match,
+		void *arg);
+
+#endif /* VIFM__UTILS__GREP_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,798 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "line_index.h"
+
+#include <pthread.h> /* pthread_* */
+#include <sys/stat.h> /* S_ISREG fstat() stat */
+#include <sys/types.h> /* dev_t ino_t off_t */
+#ifndef _WIN32
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* SEEK_SET close() dup() lseek() read() */
+#endif
+
+#include <errno.h> /* EINTR ETIMEDOUT errno */
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fflush() fileno() fread() fwrite() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() */
+#include <string.h> /* memcpy() memmove() memset() */
+#include <time.h> /* CLOCK_REALTIME clock_gettime() timespec */
+
+#include "../compat/os.h"
+#include "macros.h"
+#include "string_array.h"
+
+/* Number of lines in a single block of storage. */
+#define LINES_PER_BLOCK 65536
+
+/* Number of bytes read by indexing thread at once.  Progress is published after
+ * each chunk. */
+#define CHUNK_SIZE (64*1024)
+
+/* Texts that are not larger than this are indexed without starting a
+ * thread. */
+#define SYNC_SIZE (256*1024)
+
+/* Information about a single line. */
+typedef struct
+{
+	size_t start; /* Offset of the line in the text. */
+	size_t len;   /* Length of the line. */
+	int width;    /* Width computed by measure callback (clamped to INT_MAX). */
+}
+line_t;
+
+/* State of measuring of a line, which is done part by part. */
+typedef struct
+{
+	char *buf;       /* Unprocessed tail of previous part followed by new one. */
+	size_t tail_len; /* Length of the unprocessed tail. */
+	size_t width;    /* Width of processed part of the line. */
+}
+measure_t;
+
+/* Kind of line terminator which might continue in the next chunk of text. */
+typedef enum
+{
+	TERM_NONE, /* Not inside of a line terminator. */
+	TERM_CR,   /* After "\r", which might be followed by "\n". */
+	TERM_NUL,  /* Inside a sequence of null characters. */
+}
+term_t;
+
+/* Text with index of its lines. */
+struct line_index_t
+{
+#ifndef _WIN32
+	int fd;                  /* Descriptor of the file the text is read from. */
+	pthread_mutex_t io_lock; /* Serializes reads of the file. */
+#else
+	char *text;              /* Contents of the text (not null-terminated). */
+#endif
+
+	int followable; /* Whether text comes from a file that can be followed. */
+	dev_t dev;      /* Device of the file. */
+	ino_t ino;      /* Inode of the file. */
+	size_t pos;     /* Offset at which indexing starts. */
+
+	/* Storage of lines in blocks, the array is allocated for the largest
+	 * possible number of lines of the text, so it's never reallocated while
+	 * indexing thread is running. */
+	line_t **blocks;
+	size_t nblocks; /* Number of elements in the blocks array. */
+
+	line_index_measure_func measure; /* Computes widths of lines or NULL. */
+	void *arg;                       /* Argument of the measure callback. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	pthread_cond_t cond;  /* Signals about progress of indexing. */
+	size_t size;          /* Size of the text to be indexed. */
+	int count;            /* Number of indexed lines. */
+	int complete;         /* Whether whole text is processed. */
+	int cancel;           /* Asks indexing thread to stop. */
+
+	int has_thread;   /* Whether indexing thread was started. */
+	pthread_t thread; /* Indexing thread. */
+
+	char *line_buf;      /* Buffer for line_index_get(). */
+	size_t line_buf_len; /* Size of the line_buf buffer. */
+};
+
+static line_index_t * make_index(size_t size, line_index_measure_func measure,
+		void *arg);
+static int grow_blocks(line_index_t *li, size_t size);
+static void start_indexing(line_index_t *li);
+static void * index_thread(void *arg);
+static line_t * add_line(line_index_t *li, int n, size_t start);
+static void measure_part(line_index_t *li, measure_t *m, const char text[],
+		size_t len, int last);
+static void end_line(line_t *line, size_t end, const measure_t *m);
+static void stop_indexing(line_index_t *li);
+static int is_line_end(char c);
+static size_t read_at(line_index_t *li, size_t offset, char buf[],
+		size_t len);
+#ifndef _WIN32
+static line_index_t * index_fd(int fd, line_index_measure_func measure,
+		void *arg);
+#endif
+
+line_index_t *
+line_index_from_file(const char path[], line_index_measure_func measure,
+		void *arg)
+{
+#ifndef _WIN32
+	line_index_t *li;
+	const int fd = open(path, O_RDONLY);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	li = index_fd(fd, measure, arg);
+	if(li == NULL)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	li->followable = 1;
+	return li;
+#else
+	line_index_t *li;
+	size_t size;
+	char *text;
+	FILE *const fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return NULL;
+	}
+
+	text = read_nonseekable_stream(fp, &size);
+	fclose(fp);
+	if(text == NULL)
+	{
+		return NULL;
+	}
+
+	li = make_index(size, measure, arg);
+	if(li == NULL)
+	{
+		free(text);
+		return NULL;
+	}
+
+	li->text = text;
+	start_indexing(li);
+	return li;
+#endif
+}
+
+line_index_t *
+line_index_from_stream(FILE *fp, line_index_measure_func measure, void *arg)
+{
+#ifndef _WIN32
+	char buf[64*1024];
+	size_t len;
+	int fd;
+	line_index_t *li;
+	FILE *const tmp = tmpfile();
+	if(tmp == NULL)
+	{
+		return NULL;
+	}
+
+	while((len = fread(buf, 1U, sizeof(buf), fp)) != 0U)
+	{
+		if(fwrite(buf, 1U, len, tmp) != len)
+		{
+			fclose(tmp);
+			return NULL;
+		}
+	}
+
+	if(fflush(tmp) != 0)
+	{
+		fclose(tmp);
+		return NULL;
+	}
+
+	/* Temporary file stays alive until duplicated descriptor is closed. */
+	fd = dup(fileno(tmp));
+	fclose(tmp);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	li = index_fd(fd, measure, arg);
+	if(li == NULL)
+	{
+		close(fd);
+	}
+	return li;
+#else
+	line_index_t *li;
+	size_t size;
+	char *const text = read_nonseekable_stream(fp, &size);
+	if(text == NULL)
+	{
+		return NULL;
+	}
+
+	li = make_index(size, measure, arg);
+	if(li == NULL)
+	{
+		free(text);
+		return NULL;
+	}
+
+	li->text = text;
+	start_indexing(li);
+	return li;
+#endif
+}
+
+#ifndef _WIN32
+/* Starts indexing regular file referred to by the file descriptor, which is
+ * owned by the index on success.  Returns the index or NULL on error. */
+static line_index_t *
+index_fd(int fd, line_index_measure_func measure, void *arg)
+{
+	struct stat st;
+	line_index_t *li;
+
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		return NULL;
+	}
+
+	li = make_index(st.st_size, measure, arg);
+	if(li == NULL)
+	{
+		return NULL;
+	}
+
+	li->fd = fd;
+	li->dev = st.st_dev;
+	li->ino = st.st_ino;
+	pthread_mutex_init(&li->io_lock, NULL);
+
+	start_indexing(li);
+	return li;
+}
+#endif
+
+/* Creates index of the text of specified size, which is not started.  Returns
+ * the index or NULL on error. */
+static line_index_t *
+make_index(size_t size, line_index_measure_func measure, void *arg)
+{
+	line_index_t *const li = calloc(1U, sizeof(*li));
+	if(li == NULL)
+	{
+		return NULL;
+	}
+
+	/* Every line takes at least one byte of the text. */
+	li->nblocks = size/LINES_PER_BLOCK + 1U;
+	li->blocks = calloc(li->nblocks, sizeof(*li->blocks));
+	if(li->blocks == NULL)
+	{
+		free(li);
+		return NULL;
+	}
+
+	li->size = size;
+	li->measure = measure;
+	li->arg = arg;
+	pthread_mutex_init(&li->lock, NULL);
+	pthread_cond_init(&li->cond, NULL);
+	return li;
+}
+
+int
+line_index_follow(line_index_t *li, const char path[], int *first_changed)
+{
+#ifndef _WIN32
+	struct stat st;
+	int complete;
+
+	if(!li->followable)
+	{
+		return 1;
+	}
+
+	if(os_stat(path, &st) != 0 || st.st_dev != li->dev || st.st_ino != li->ino)
+	{
+		return 1;
+	}
+
+	pthread_mutex_lock(&li->lock);
+
+	if((size_t)st.st_size < li->size)
+	{
+		pthread_mutex_unlock(&li->lock);
+		return 1;
+	}
+
+	complete = li->complete;
+	*first_changed = li->count;
+	/* Indexing thread that is still running just goes further as long as
+	 * storage of lines needs no reallocation. */
+	if((size_t)st.st_size == li->size ||
+			(!complete && (size_t)st.st_size/LINES_PER_BLOCK < li->nblocks))
+	{
+		li->size = st.st_size;
+		pthread_mutex_unlock(&li->lock);
+		return 0;
+	}
+
+	pthread_mutex_unlock(&li->lock);
+
+	/* Thread must be finished before storage of lines can be reallocated and
+	 * joined before it can be restarted. */
+	(void)line_index_wait(li, -1);
+	stop_indexing(li);
+
+	if(grow_blocks(li, st.st_size) != 0)
+	{
+		return 1;
+	}
+
+	li->size = st.st_size;
+
+	/* The last line could have been incomplete, so it's indexed anew. */
+	if(li->count != 0)
+	{
+		--li->count;
+		li->pos = li->blocks[li->count/LINES_PER_BLOCK]
+		                    [li->count%LINES_PER_BLOCK].start;
+	}
+	li->complete = 0;
+	*first_changed = li->count;
+
+	start_indexing(li);
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* Enlarges storage of lines to be able to fit lines of text of the specified
+ * size.  Must not be called while indexing thread is running.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+grow_blocks(line_index_t *li, size_t size)
+{
+	const size_t nblocks = size/LINES_PER_BLOCK + 1U;
+	line_t **blocks;
+
+	if(nblocks <= li->nblocks)
+	{
+		return 0;
+	}
+
+	blocks = realloc(li->blocks, sizeof(*blocks)*nblocks);
+	if(blocks == NULL)
+	{
+		return 1;
+	}
+
+	memset(blocks + li->nblocks, 0, sizeof(*blocks)*(nblocks - li->nblocks));
+	li->blocks = blocks;
+	li->nblocks = nblocks;
+	return 0;
+}
+
+/* Indexes the text starting at li->pos either synchronously or on a
+ * background thread depending on size of unprocessed part. */
+static void
+start_indexing(line_index_t *li)
+{
+	if(li->size - li->pos <= SYNC_SIZE)
+	{
+		(void)index_thread(li);
+		return;
+	}
+
+	li->has_thread = (pthread_create(&li->thread, NULL, &index_thread, li) == 0);
+	if(!li->has_thread)
+	{
+		(void)index_thread(li);
+	}
+}
+
+/* Makes indexing thread quit if it's running and waits for it to finish. */
+static void
+stop_indexing(line_index_t *li)
+{
+	if(!li->has_thread)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&li->lock);
+	li->cancel = 1;
+	pthread_mutex_unlock(&li->lock);
+
+	pthread_join(li->thread, NULL);
+	li->has_thread = 0;
+	li->cancel = 0;
+}
+
+void
+line_index_remeasure(line_index_t *li, void *arg)
+{
+	stop_indexing(li);
+
+	li->arg = arg;
+	li->pos = 0U;
+	li->count = 0;
+	li->complete = 0;
+	start_indexing(li);
+}
+
+void
+line_index_free(line_index_t *li)
+{
+	size_t i;
+
+	if(li == NULL)
+	{
+		return;
+	}
+
+	stop_indexing(li);
+
+	for(i = 0U; i < li->nblocks; ++i)
+	{
+		free(li->blocks[i]);
+	}
+	free(li->blocks);
+
+#ifndef _WIN32
+	close(li->fd);
+	pthread_mutex_destroy(&li->io_lock);
+#else
+	free(li->text);
+#endif
+
+	pthread_mutex_destroy(&li->lock);
+	pthread_cond_destroy(&li->cond);
+	free(li->line_buf);
+	free(li);
+}
+
+/* Entry point of indexing thread, which is also called directly for small
+ * texts.  Text is read in chunks, so its size can grow while it's being
+ * indexed and a file that becomes shorter doesn't cause any harm.  Returns
+ * NULL. */
+static void *
+index_thread(void *arg)
+{
+	line_index_t *const li = arg;
+	char chunk[CHUNK_SIZE];
+	measure_t m = { .tail_len = 0U, .width = 0U };
+	size_t pos = li->pos;
+	int count = li->count;
+	line_t *line = NULL;
+	term_t term = TERM_NONE;
+
+	m.buf = (li->measure == NULL)
+	      ? NULL
+	      : malloc(LINE_INDEX_MAX_TAIL + sizeof(chunk) + 1U);
+
+	while(1)
+	{
+		size_t size, len, i;
+
+		pthread_mutex_lock(&li->lock);
+		li->count = count;
+		size = li->size;
+		if(pos >= size || li->cancel || count == INT_MAX)
+		{
+			/* Finishing under the lock guarantees that line_index_follow() either
+			 * extends the text for this thread or sees it complete. */
+			if(line != NULL)
+			{
+				measure_part(li, &m, "", 0U, 1);
+				end_line(line, pos, &m);
+				li->count = ++count;
+			}
+			li->pos = pos;
+			li->complete = 1;
+			pthread_cond_broadcast(&li->cond);
+			pthread_mutex_unlock(&li->lock);
+			break;
+		}
+		pthread_cond_broadcast(&li->cond);
+		pthread_mutex_unlock(&li->lock);
+
+		len = read_at(li, pos, chunk, MIN(size - pos, sizeof(chunk)));
+		if(len == 0U)
+		{
+			/* The file has become shorter, index what was read. */
+			pthread_mutex_lock(&li->lock);
+			li->size = pos;
+			pthread_mutex_unlock(&li->lock);
+			continue;
+		}
+
+		i = 0U;
+		while(i < len && count < INT_MAX)
+		{
+			size_t j;
+
+			if(term == TERM_CR)
+			{
+				term = TERM_NONE;
+				if(chunk[i] == '\n')
+				{
+					++i;
+					continue;
+				}
+			}
+			else if(term == TERM_NUL)
+			{
+				if(chunk[i] == '\0')
+				{
+					++i;
+					continue;
+				}
+				term = TERM_NONE;
+			}
+
+			if(line == NULL)
+			{
+				line = add_line(li, count, pos + i);
+				if(line == NULL)
+				{
+					pos = size;
+					break;
+				}
+				m.tail_len = 0U;
+				m.width = 0U;
+			}
+
+			j = i;
+			while(j < len && !is_line_end(chunk[j]))
+			{
+				++j;
+			}
+
+			if(j == len)
+			{
+				/* The line continues in the next chunk. */
+				measure_part(li, &m, chunk + i, j - i, 0);
+				i = j;
+				break;
+			}
+
+			measure_part(li, &m, chunk + i, j - i, 1);
+			end_line(line, pos + j, &m);
+			line = NULL;
+			++count;
+
+			term = (chunk[j] == '\r') ? TERM_CR
+			     : (chunk[j] == '\0') ? TERM_NUL
+			     : TERM_NONE;
+			i = j + 1U;
+		}
+		pos += i;
+	}
+
+	free(m.buf);
+	return NULL;
+}
+
+/* Records start of a line with the specified index allocating storage for it if
+ * necessary.  Returns the line or NULL on error. */
+static line_t *
+add_line(line_index_t *li, int n, size_t start)
+{
+	line_t *line;
+	line_t **const block = &li->blocks[n/LINES_PER_BLOCK];
+
+	if(*block == NULL)
+	{
+		*block = malloc(sizeof(**block)*LINES_PER_BLOCK);
+		if(*block == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	line = &(*block)[n%LINES_PER_BLOCK];
+	line->start = start;
+	line->len = 0U;
+	line->width = 0;
+	return line;
+}
+
+/* Passes part of a line, which is at most CHUNK_SIZE bytes long, to the measure
+ * callback along with what was left unprocessed of the previous part. */
+static void
+measure_part(line_index_t *li, measure_t *m, const char text[], size_t len,
+		int last)
+{
+	size_t total, processed;
+
+	if(m->buf == NULL)
+	{
+		return;
+	}
+
+	memcpy(m->buf + m->tail_len, text, len);
+	total = m->tail_len + len;
+	m->buf[total] = '\0';
+
+	processed = li->measure(m->buf, total, last, &m->width, li->arg);
+	m->tail_len = last ? 0U : MIN(total - MIN(processed, total),
+			(size_t)LINE_INDEX_MAX_TAIL);
+	memmove(m->buf, m->buf + total - m->tail_len, m->tail_len);
+}
+
+/* Records end of a line along with its width. */
+static void
+end_line(line_t *line, size_t end, const measure_t *m)
+{
+	line->len = end - line->start;
+	line->width = MIN(m->width, (size_t)INT_MAX);
+}
+
+/* Checks whether character terminates a line.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+is_line_end(char c)
+{
+	return c == '\n' || c == '\r' || c == '\0';
+}
+
+int
+line_index_count(line_index_t *li, int *complete)
+{
+	int count;
+
+	pthread_mutex_lock(&li->lock);
+	count = li->count;
+	*complete = li->complete;
+	pthread_mutex_unlock(&li->lock);
+
+	return count;
+}
+
+int
+line_index_wait(line_index_t *li, int nlines)
+{
+	int count;
+
+	pthread_mutex_lock(&li->lock);
+	while(!li->complete && (nlines < 0 || li->count < nlines))
+	{
+		pthread_cond_wait(&li->cond, &li->lock);
+	}
+	count = li->count;
+	pthread_mutex_unlock(&li->lock);
+
+	return count;
+}
+
+int
+line_index_wait_for(line_index_t *li, int nlines, int timeout)
+{
+	struct timespec deadline;
+	int count;
+
+	(void)clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout/1000;
+	deadline.tv_nsec += (timeout%1000)*1000000L;
+	if(deadline.tv_nsec >= 1000000000L)
+	{
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&li->lock);
+	while(!li->complete && (nlines < 0 || li->count < nlines))
+	{
+		if(pthread_cond_timedwait(&li->cond, &li->lock, &deadline) == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	count = li->count;
+	pthread_mutex_unlock(&li->lock);
+
+	return count;
+}
+
+int
+line_index_width(const line_index_t *li, int n)
+{
+	return li->blocks[n/LINES_PER_BLOCK][n%LINES_PER_BLOCK].width;
+}
+
+const char *
+line_index_get(line_index_t *li, int n, size_t max_len)
+{
+	const line_t *const line = &li->blocks[n/LINES_PER_BLOCK]
+	                                      [n%LINES_PER_BLOCK];
+	size_t len = MIN(line->len, max_len);
+
+	if(len >= li->line_buf_len)
+	{
+		char *const new_buf = realloc(li->line_buf, len + 1U);
+		if(new_buf == NULL)
+		{
+			return NULL;
+		}
+		li->line_buf = new_buf;
+		li->line_buf_len = len + 1U;
+	}
+
+	/* Part of the line might be gone if the file was truncated. */
+	len = read_at(li, line->start, li->line_buf, len);
+	li->line_buf[len] = '\0';
+	return li->line_buf;
+}
+
+/* Reads up to len bytes of the text starting at specified offset.  Returns
+ * number of bytes read, which is less than len if the text is shorter. */
+static size_t
+read_at(line_index_t *li, size_t offset, char buf[], size_t len)
+{
+#ifndef _WIN32
+	size_t total = 0U;
+
+	pthread_mutex_lock(&li->io_lock);
+	if(lseek(li->fd, (off_t)offset, SEEK_SET) == (off_t)-1)
+	{
+		pthread_mutex_unlock(&li->io_lock);
+		return 0U;
+	}
+	while(total < len)
+	{
+		const ssize_t n = read(li->fd, buf + total, len - total);
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n <= 0)
+		{
+			break;
+		}
+		total += n;
+	}
+	pthread_mutex_unlock(&li->io_lock);
+
+	return total;
+#else
+	/* Text can't change on Windows as it's kept in memory. */
+	if(offset >= li->size)
+	{
+		return 0U;
+	}
+	len = MIN(len, li->size - offset);
+	memcpy(buf, li->text + offset, len);
+	return len;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
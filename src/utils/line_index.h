@@ -0,0 +1,99 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__LINE_INDEX_H__
+#define VIFM__UTILS__LINE_INDEX_H__
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* FILE */
+
+/* Read-only text split into lines without loading all of them into memory.
+ * Text is read in chunks and lines are indexed on a background thread, so
+ * first lines are available long before the whole text is processed.  Lines
+ * are read from the file on request.  Lines end at
+ * "\n", "\r\n", "\r" or a sequence of null characters. */
+
+/* Maximum number of bytes that measure callback can leave unprocessed. */
+#define LINE_INDEX_MAX_TAIL 64
+
+/* Computes width of a part of a line, lines are measured in parts as they are
+ * read.  The len bytes of the text are followed by a null character.  *width
+ * holds width of preceding parts of the line and is to be increased.  Unless
+ * last is non-zero, at most LINE_INDEX_MAX_TAIL bytes at the end of the text
+ * (e.g., an incomplete character) can be left unprocessed, they are passed in
+ * again in front of the next part.  Invoked on a background thread.  Returns
+ * number of processed bytes. */
+typedef size_t (*line_index_measure_func)(const char text[], size_t len,
+		int last, size_t *width, void *arg);
+
+/* Opaque text with index of its lines. */
+typedef struct line_index_t line_index_t;
+
+/* Opens a regular file and starts indexing it.  measure
+ * can be NULL.  Returns the index or NULL on error. */
+line_index_t * line_index_from_file(const char path[],
+		line_index_measure_func measure, void *arg);
+
+/* Same as line_index_from_file(), but first spills contents of the stream into
+ * a temporary file.  Returns the index or NULL on error. */
+line_index_t * line_index_from_stream(FILE *fp,
+		line_index_measure_func measure, void *arg);
+
+/* Picks up data appended to the file since the index was created or last
+ * updated.  Only the appended part (and the last line, which might have been
+ * incomplete) is indexed.  *first_changed is set to the index of the first line
+ * that was replaced.  Returns zero on success and non-zero if the file can't be
+ * followed (it was replaced, became smaller or the index was created from a
+ * stream), in which case the index is left unchanged. */
+int line_index_follow(line_index_t *li, const char path[], int *first_changed);
+
+/* Indexes the text anew passing different argument to the measure callback,
+ * e.g. to update widths of lines after change of options. */
+void line_index_remeasure(line_index_t *li, void *arg);
+
+/* Stops indexing and frees all resources of the index.  li can be NULL. */
+void line_index_free(line_index_t *li);
+
+/* Retrieves number of lines indexed so far.  *complete is set to non-zero if
+ * the whole text was processed.  Returns the number. */
+int line_index_count(line_index_t *li, int *complete);
+
+/* Waits until at least nlines lines are indexed or the whole text is processed.
+ * Negative nlines means waiting for the whole text.  Returns number of indexed
+ * lines. */
+int line_index_wait(line_index_t *li, int nlines);
+
+/* Same as line_index_wait(), but gives up after timeout milliseconds.  Returns
+ * number of indexed lines. */
+int line_index_wait_for(line_index_t *li, int nlines, int timeout);
+
+/* Retrieves width of the line computed by measure callback (zero if there was
+ * none).  The n must be less than number of indexed lines.  Returns the
+ * width. */
+int line_index_width(const line_index_t *li, int n);
+
+/* Retrieves copy of at most max_len first bytes of the line, so that a huge
+ * line isn't read as a whole.  The n must be less than number of indexed
+ * lines.  Returns pointer to a buffer that is valid until the next call of
+ * this function for the same index or NULL on error. */
+const char * line_index_get(line_index_t *li, int n, size_t max_len);
+
+#endif /* VIFM__UTILS__LINE_INDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -269,6 +269,33 @@ matcher_get_expr(const matcher_t *matcher)
 	return matcher->expr;
 }
 
+char *
+matcher_get_globs(const matcher_t *matcher)
+{
+	char *globs;
+	size_t len;
+	const char *expr = matcher->expr;
+
+	if(!matcher->globs || matcher->full_path)
+	{
+		return NULL;
+	}
+
+	len = strlen(expr);
+	if(is_globs_expr(expr))
+	{
+		++expr;
+		len -= 2U;
+	}
+
+	globs = malloc(len + 1U);
+	if(globs != NULL)
+	{
+		copy_str(globs, len + 1U, expr);
+	}
+	return globs;
+}
+
 int
 matcher_includes(const matcher_t *like, const matcher_t *m)
 {
@@ -46,6 +46,11 @@ int matcher_matches(matcher_t *matcher, const char path[]);
 /* Gets original matcher expression.  Returns the expression.*/
 const char * matcher_get_expr(const matcher_t *matcher);
 
+/* Retrieves comma-separated list of globs of matcher that matches names of
+ * files by globs.  Returns newly allocated string or NULL if matcher isn't of
+ * this kind or on error. */
+char * matcher_get_globs(const matcher_t *matcher);
+
 /* Checks whether everything matched by the m is also matched by the like.
  * Returns non-zero if so, otherwise zero is returned. */
 int matcher_includes(const matcher_t *like, const matcher_t *m);
@@ -0,0 +1,382 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "matchers.h"
+
+#include <ctype.h> /* tolower() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strchr() strlen() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/reallocarray.h"
+#include "matcher.h"
+#include "path.h"
+#include "str.h"
+#include "trie.h"
+
+/* Matcher that can't be looked up in tables. */
+typedef struct
+{
+	matcher_t *matcher; /* The matcher. */
+	int index;          /* Position of the matcher in the list. */
+}
+other_t;
+
+/* Ascending list of indexes of matchers that contain the same key. */
+typedef struct
+{
+	int *indexes; /* Indexes of matchers. */
+	int count;    /* Number of elements in the indexes array. */
+}
+idx_list_t;
+
+/* List of matchers. */
+struct matchers_t
+{
+	matcher_t **all; /* All matchers in order of addition. */
+	int count;       /* Number of elements in the all array. */
+
+	trie_t names;    /* Lower case literal names to idx_list_t. */
+	trie_t suffixes; /* Lower case suffixes (".ext") to idx_list_t. */
+	idx_list_t **keys;    /* All elements of both tables. */
+	int nkeys;       /* Number of elements in the keys array. */
+
+	other_t *others; /* Matchers that have to be tried one by one. */
+	int nothers;     /* Number of elements in the others array. */
+};
+
+/* Kinds of globs. */
+typedef enum
+{
+	GK_NAME,   /* Literal name. */
+	GK_SUFFIX, /* "*.ext" form. */
+	GK_OTHER,  /* Anything else. */
+}
+GlobKind;
+
+static int add_globs(matchers_t *ms, char globs[], int index);
+static GlobKind classify_glob(const char glob[]);
+static int put_key(matchers_t *ms, trie_t trie, const char key[], int index);
+static void update_best(trie_t trie, const char key[], int from, int *best);
+static int lower_name(const char name[], char buf[], size_t buf_len);
+
+matchers_t *
+matchers_alloc(void)
+{
+	matchers_t *const ms = calloc(1U, sizeof(*ms));
+	if(ms == NULL)
+	{
+		return NULL;
+	}
+
+	ms->names = trie_create();
+	ms->suffixes = trie_create();
+	if(ms->names == NULL_TRIE || ms->suffixes == NULL_TRIE)
+	{
+		matchers_free(ms);
+		return NULL;
+	}
+
+	return ms;
+}
+
+void
+matchers_free(matchers_t *ms)
+{
+	if(ms != NULL)
+	{
+		int i;
+		for(i = 0; i < ms->nkeys; ++i)
+		{
+			free(ms->keys[i]->indexes);
+			free(ms->keys[i]);
+		}
+		free(ms->keys);
+
+		trie_free(ms->names);
+		trie_free(ms->suffixes);
+		free(ms->others);
+		free(ms->all);
+		free(ms);
+	}
+}
+
+int
+matchers_add(matchers_t *ms, matcher_t *m)
+{
+	char *globs;
+	void *p;
+
+	p = reallocarray(ms->all, ms->count + 1, sizeof(*ms->all));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	ms->all = p;
+
+	globs = matcher_get_globs(m);
+	if(globs == NULL || add_globs(ms, globs, ms->count) != 0)
+	{
+		p = reallocarray(ms->others, ms->nothers + 1, sizeof(*ms->others));
+		if(p == NULL)
+		{
+			free(globs);
+			return 1;
+		}
+		ms->others = p;
+		ms->others[ms->nothers].matcher = m;
+		ms->others[ms->nothers].index = ms->count;
+		++ms->nothers;
+	}
+	free(globs);
+
+	ms->all[ms->count++] = m;
+	return 0;
+}
+
+/* Puts globs into tables if all of them are simple enough.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+add_globs(matchers_t *ms, char globs[], int index)
+{
+	char *glob = globs, *state = NULL;
+	char *copy = strdup(globs);
+
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	while((glob = split_and_get(glob, ',', &state)) != NULL)
+	{
+		if(classify_glob(glob) == GK_OTHER)
+		{
+			free(copy);
+			return 1;
+		}
+	}
+
+	glob = copy;
+	state = NULL;
+	while((glob = split_and_get(glob, ',', &state)) != NULL)
+	{
+		int failed;
+		char key[NAME_MAX];
+		if(lower_name(glob, key, sizeof(key)) != 0)
+		{
+			/* Such long name can't match anything. */
+			continue;
+		}
+
+		if(classify_glob(glob) == GK_NAME)
+		{
+			failed = put_key(ms, ms->names, key, index);
+		}
+		else
+		{
+			failed = put_key(ms, ms->suffixes, key + 1, index);
+		}
+
+		if(failed)
+		{
+			/* The matcher will be tried one by one, entries that are already in
+			 * tables don't hurt. */
+			free(copy);
+			return 1;
+		}
+	}
+
+	free(copy);
+	return 0;
+}
+
+/* Determines kind of the glob.  Only globs of ASCII characters are considered
+ * to be simple as case of other characters isn't folded here.  Returns the
+ * kind. */
+static GlobKind
+classify_glob(const char glob[])
+{
+	const char *p;
+	const char *const star = strchr(glob, '*');
+
+	for(p = glob; *p != '\0'; ++p)
+	{
+		if((unsigned char)*p >= 0x80 || char_is_one_of("?[]\\", *p))
+		{
+			return GK_OTHER;
+		}
+	}
+
+	if(star == NULL)
+	{
+		return GK_NAME;
+	}
+
+	/* Leading star doesn't match leading dot, so "*.ext" matches names that end
+	 * with ".ext" and don't start with a dot. */
+	if(star == glob && glob[1] == '.' && strchr(glob + 1, '*') == NULL)
+	{
+		return GK_SUFFIX;
+	}
+
+	return GK_OTHER;
+}
+
+/* Associates key with the index.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+put_key(matchers_t *ms, trie_t trie, const char key[], int index)
+{
+	void *data;
+	idx_list_t *k;
+	void *p;
+
+	if(trie_get(trie, key, &data) == 0)
+	{
+		k = data;
+	}
+	else
+	{
+		p = reallocarray(ms->keys, ms->nkeys + 1, sizeof(*ms->keys));
+		if(p == NULL)
+		{
+			return 1;
+		}
+		ms->keys = p;
+
+		k = calloc(1U, sizeof(*k));
+		if(k == NULL)
+		{
+			return 1;
+		}
+		if(trie_set(trie, key, k) < 0)
+		{
+			free(k);
+			return 1;
+		}
+		ms->keys[ms->nkeys++] = k;
+	}
+
+	/* Same glob might be listed twice in a matcher. */
+	if(k->count != 0 && k->indexes[k->count - 1] == index)
+	{
+		return 0;
+	}
+
+	p = reallocarray(k->indexes, k->count + 1, sizeof(*k->indexes));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	k->indexes = p;
+	k->indexes[k->count++] = index;
+	return 0;
+}
+
+int
+matchers_find(const matchers_t *ms, const char path[], int from)
+{
+	char name[NAME_MAX];
+	int best = ms->count;
+	int i;
+
+	if(lower_name(get_last_path_component(path), name, sizeof(name)) != 0)
+	{
+		/* Can't use tables, try all matchers. */
+		for(i = from; i < ms->count; ++i)
+		{
+			if(matcher_matches(ms->all[i], path))
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	update_best(ms->names, name, from, &best);
+
+	if(name[0] != '.')
+	{
+		const char *suffix = name;
+		while((suffix = strchr(suffix + 1, '.')) != NULL)
+		{
+			update_best(ms->suffixes, suffix, from, &best);
+		}
+	}
+
+	for(i = 0; i < ms->nothers && ms->others[i].index < best; ++i)
+	{
+		if(ms->others[i].index < from)
+		{
+			continue;
+		}
+
+		if(matcher_matches(ms->others[i].matcher, path))
+		{
+			return ms->others[i].index;
+		}
+	}
+
+	return (best == ms->count) ? -1 : best;
+}
+
+/* Lowers *best if key is in the trie and is associated with smaller index
+ * that is not less than from. */
+static void
+update_best(trie_t trie, const char key[], int from, int *best)
+{
+	void *data;
+	if(trie_get(trie, key, &data) == 0)
+	{
+		const idx_list_t *const k = data;
+		int i;
+		for(i = 0; i < k->count && k->indexes[i] < *best; ++i)
+		{
+			if(k->indexes[i] >= from)
+			{
+				*best = k->indexes[i];
+				break;
+			}
+		}
+	}
+}
+
+/* Converts ASCII characters of the name to lower case.  Returns zero on
+ * success and non-zero if the buffer is too small. */
+static int
+lower_name(const char name[], char buf[], size_t buf_len)
+{
+	size_t i;
+	const size_t len = strlen(name);
+
+	if(len >= buf_len)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i <= len; ++i)
+	{
+		const unsigned char c = name[i];
+		buf[i] = (c < 0x80) ? tolower(c) : c;
+	}
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,50 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__MATCHERS_H__
+#define VIFM__UTILS__MATCHERS_H__
+
+/* Ordered list of matchers that finds the first one matching a path.  Globs
+ * that are literal names or of the form "*.ext" are looked up in hash tables
+ * instead of being matched one by one, so only other matchers are tried in
+ * order. */
+
+struct matcher_t;
+
+/* Opaque list of matchers. */
+typedef struct matchers_t matchers_t;
+
+/* Allocates empty list.  Returns the list or NULL on error. */
+matchers_t * matchers_alloc(void);
+
+/* Frees the list, but not matchers added to it.  ms can be NULL. */
+void matchers_free(matchers_t *ms);
+
+/* Appends matcher to the list.  The matcher must outlive the list.  Returns
+ * zero on success, otherwise non-zero is returned. */
+int matchers_add(matchers_t *ms, struct matcher_t *m);
+
+/* Finds the first matcher of the list starting with the one at index from that
+ * matches the path.  Returns its index (in order of addition) or -1 if there
+ * is no match. */
+int matchers_find(const matchers_t *ms, const char path[], int from);
+
+#endif /* VIFM__UTILS__MATCHERS_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -692,28 +692,7 @@ is_builtin_dir(const char name[])
 int
 find_cmd_in_path(const char cmd[], size_t path_len, char path[])
 {
-	size_t i;
-	size_t paths_count;
-	char **paths;
-
-	paths = get_paths(&paths_count);
-	for(i = 0; i < paths_count; i++)
-	{
-		char tmp_path[PATH_MAX];
-		snprintf(tmp_path, sizeof(tmp_path), "%s/%s", paths[i], cmd);
-
-		/* Need to check for executable, not just a file, as this additionally
-		 * checks for path with different executable extensions on Windows. */
-		if(executable_exists(tmp_path))
-		{
-			if(path != NULL)
-			{
-				copy_str(path, path_len, tmp_path);
-			}
-			return 0;
-		}
-	}
-	return 1;
+	return path_env_find_cmd(cmd, path_len, path);
 }
 
 void
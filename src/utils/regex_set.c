@@ -0,0 +1,194 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "regex_set.h"
+
+#include <pthread.h> /* pthread_* */
+#include <regex.h> /* regex_t regcomp() regfree() */
+
+#include <stdlib.h> /* free() malloc() */
+
+#include "../compat/reallocarray.h"
+#include "str.h"
+#include "string_array.h"
+#include "utils.h"
+
+struct regex_set_t
+{
+	char **patterns; /* Sources of regular expressions. */
+	int *cflags;     /* Flags for regcomp() per pattern. */
+	int npatterns;   /* Number of patterns. */
+
+	pthread_key_t key;    /* Per-thread array of compiled expressions. */
+	pthread_mutex_t lock; /* Protects the list below. */
+	regex_t **compiled;   /* All compiled arrays. */
+	int ncompiled;        /* Number of compiled arrays. */
+};
+
+static void free_compiled(const regex_set_t *set, regex_t *regexes);
+
+regex_set_t *
+regex_set_alloc(void)
+{
+	regex_set_t *const set = malloc(sizeof(*set));
+	if(set == NULL)
+	{
+		return NULL;
+	}
+
+	if(pthread_key_create(&set->key, NULL) != 0)
+	{
+		free(set);
+		return NULL;
+	}
+	pthread_mutex_init(&set->lock, NULL);
+
+	set->patterns = NULL;
+	set->cflags = NULL;
+	set->npatterns = 0;
+	set->compiled = NULL;
+	set->ncompiled = 0;
+	return set;
+}
+
+void
+regex_set_free(regex_set_t *set)
+{
+	int i;
+
+	if(set == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < set->ncompiled; ++i)
+	{
+		free_compiled(set, set->compiled[i]);
+	}
+	free(set->compiled);
+
+	pthread_key_delete(set->key);
+	pthread_mutex_destroy(&set->lock);
+	free_string_array(set->patterns, set->npatterns);
+	free(set->cflags);
+	free(set);
+}
+
+/* Frees array of compiled regular expressions. */
+static void
+free_compiled(const regex_set_t *set, regex_t *regexes)
+{
+	int i;
+	for(i = 0; i < set->npatterns; ++i)
+	{
+		regfree(&regexes[i]);
+	}
+	free(regexes);
+}
+
+int
+regex_set_add(regex_set_t *set, const char pattern[], int cflags,
+		char **error)
+{
+	void *p;
+	regex_t re;
+	const int err = regcomp(&re, pattern, cflags);
+	if(err != 0)
+	{
+		replace_string(error, get_regexp_error(err, &re));
+		regfree(&re);
+		return -1;
+	}
+	regfree(&re);
+
+	p = reallocarray(set->cflags, set->npatterns + 1, sizeof(*set->cflags));
+	if(p == NULL)
+	{
+		replace_string(error, "Not enough memory");
+		return -1;
+	}
+	set->cflags = p;
+	set->cflags[set->npatterns] = cflags;
+
+	if(add_to_string_array(&set->patterns, set->npatterns, 1, pattern) ==
+			set->npatterns)
+	{
+		replace_string(error, "Not enough memory");
+		return -1;
+	}
+	return set->npatterns++;
+}
+
+int
+regex_set_count(const regex_set_t *set)
+{
+	return set->npatterns;
+}
+
+regex_t *
+regex_set_get(regex_set_t *set)
+{
+	int i;
+	regex_t **compiled;
+	regex_t *regexes = pthread_getspecific(set->key);
+	if(regexes != NULL)
+	{
+		return regexes;
+	}
+
+	regexes = reallocarray(NULL, set->npatterns, sizeof(*regexes));
+	if(regexes == NULL)
+	{
+		return NULL;
+	}
+	for(i = 0; i < set->npatterns; ++i)
+	{
+		if(regcomp(&regexes[i], set->patterns[i], set->cflags[i]) != 0)
+		{
+			regfree(&regexes[i]);
+			while(i-- > 0)
+			{
+				regfree(&regexes[i]);
+			}
+			free(regexes);
+			return NULL;
+		}
+	}
+
+	pthread_mutex_lock(&set->lock);
+	compiled = reallocarray(set->compiled, set->ncompiled + 1,
+			sizeof(*compiled));
+	if(compiled != NULL)
+	{
+		set->compiled = compiled;
+		set->compiled[set->ncompiled++] = regexes;
+	}
+	pthread_mutex_unlock(&set->lock);
+
+	if(compiled == NULL)
+	{
+		free_compiled(set, regexes);
+		return NULL;
+	}
+
+	pthread_setspecific(set->key, regexes);
+	return regexes;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,55 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__REGEX_SET_H__
+#define VIFM__UTILS__REGEX_SET_H__
+
+#include <regex.h> /* regex_t */
+
+/* Set of regular expressions that can be used from multiple threads at the
+ * same time.  Some implementations serialize regexec() calls on the same
+ * regex_t, so every thread gets its own copy of compiled expressions, which is
+ * made on first request from the thread. */
+
+/* Opaque set of regular expressions. */
+typedef struct regex_set_t regex_set_t;
+
+/* Creates an empty set.  Returns the set or NULL on error. */
+regex_set_t * regex_set_alloc(void);
+
+/* Frees the set along with all compiled expressions.  set can be NULL. */
+void regex_set_free(regex_set_t *set);
+
+/* Checks that the pattern is valid and appends it to the set.  Must not be
+ * called after regex_set_get().  *error is set to error message on failure, it
+ * should be freed by the caller.  Returns index of the pattern in the set or
+ * -1 on error. */
+int regex_set_add(regex_set_t *set, const char pattern[], int cflags,
+		char **error);
+
+/* Retrieves number of patterns in the set.  Returns the number. */
+int regex_set_count(const regex_set_t *set);
+
+/* Retrieves compiled expressions for current thread compiling them if needed.
+ * Returns array of expressions in order of their addition or NULL on error. */
+regex_t * regex_set_get(regex_set_t *set);
+
+#endif /* VIFM__UTILS__REGEX_SET_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -754,6 +754,16 @@ has_uppercase_letters(const char str[])
 	return has_uppercase;
 }
 
+int
+is_ascii(const char str[])
+{
+	while(*str != '\0' && (unsigned char)*str < 0x80)
+	{
+		++str;
+	}
+	return *str == '\0';
+}
+
 size_t
 copy_str(char dst[], size_t dst_len, const char src[])
 {
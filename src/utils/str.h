@@ -226,6 +226,10 @@ char * extend_string(char str[], const char with[], size_t *len);
  * letter.  Returns non-zero for that case, otherwise zero is returned. */
 int has_uppercase_letters(const char str[]);
 
+/* Checks whether string consists of ASCII characters only.  Returns non-zero if
+ * so, otherwise zero is returned. */
+int is_ascii(const char str[]);
+
 /* Copies characters from the string pointed to by str to piece of memory of
  * size dst_len pointed to by dst.  Ensures that copied string ends with null
  * character.  Does nothing for zero dst_len.  Returns number of characters
@@ -0,0 +1,141 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "str_pool.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() strlen() */
+
+#include "macros.h"
+
+/* Minimal size of data part of a chunk. */
+#define CHUNK_SIZE (64*1024)
+
+/* Block of memory strings are allocated from.  Each string is prepended with a
+ * pointer to its chunk. */
+typedef struct chunk_t
+{
+	size_t size; /* Size of the data. */
+	size_t used; /* Number of used bytes of the data. */
+	size_t refs; /* Number of strings in use plus one if pool uses the chunk. */
+	char data[]; /* Storage for strings. */
+}
+chunk_t;
+
+/* Pool of strings. */
+struct str_pool_t
+{
+	chunk_t *chunk; /* Current chunk or NULL. */
+};
+
+static chunk_t * alloc_chunk(size_t size);
+static void drop_chunk(chunk_t *chunk);
+
+str_pool_t *
+str_pool_create(void)
+{
+	str_pool_t *const pool = malloc(sizeof(*pool));
+	if(pool != NULL)
+	{
+		pool->chunk = NULL;
+	}
+	return pool;
+}
+
+void
+str_pool_free(str_pool_t *pool)
+{
+	if(pool != NULL)
+	{
+		drop_chunk(pool->chunk);
+		free(pool);
+	}
+}
+
+char *
+str_pool_dup(str_pool_t *pool, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+	const size_t needed = sizeof(chunk_t *) + len;
+	chunk_t *chunk = pool->chunk;
+	char *record;
+
+	if(chunk == NULL || chunk->size - chunk->used < needed)
+	{
+		chunk = alloc_chunk(MAX(CHUNK_SIZE, needed));
+		if(chunk == NULL)
+		{
+			return NULL;
+		}
+
+		drop_chunk(pool->chunk);
+		pool->chunk = chunk;
+	}
+
+	record = &chunk->data[chunk->used];
+	chunk->used += needed;
+	++chunk->refs;
+
+	memcpy(record, &chunk, sizeof(chunk));
+	memcpy(record + sizeof(chunk), str, len);
+	return record + sizeof(chunk);
+}
+
+void
+str_pool_release(char str[])
+{
+	chunk_t *chunk;
+
+	if(str == NULL)
+	{
+		return;
+	}
+
+	memcpy(&chunk, str - sizeof(chunk), sizeof(chunk));
+	drop_chunk(chunk);
+}
+
+/* Allocates chunk with data of specified size.  Returns the chunk, which is
+ * referenced once, or NULL on error. */
+static chunk_t *
+alloc_chunk(size_t size)
+{
+	chunk_t *const chunk = malloc(sizeof(*chunk) + size);
+	if(chunk != NULL)
+	{
+		chunk->size = size;
+		chunk->used = 0U;
+		chunk->refs = 1U;
+	}
+	return chunk;
+}
+
+/* Decrements reference counter of the chunk and frees it when it reaches zero.
+ * NULL chunk is ignored. */
+static void
+drop_chunk(chunk_t *chunk)
+{
+	if(chunk != NULL && --chunk->refs == 0U)
+	{
+		free(chunk);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
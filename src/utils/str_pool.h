@@ -0,0 +1,47 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STR_POOL_H__
+#define VIFM__UTILS__STR_POOL_H__
+
+/* Pool of strings, which are bump-allocated in big chunks.  Each chunk counts
+ * strings that are still in use and is freed as a whole once all of them are
+ * released and the pool stopped using the chunk.  Strings can outlive the pool
+ * they were allocated from. */
+
+/* Declaration of opaque string pool type. */
+typedef struct str_pool_t str_pool_t;
+
+/* Creates new empty pool.  Returns NULL on error. */
+str_pool_t * str_pool_create(void);
+
+/* Frees the pool.  Memory of strings that are still in use is freed on their
+ * release.  Freeing of NULL pool is OK. */
+void str_pool_free(str_pool_t *pool);
+
+/* Copies the str into the pool.  Returns pointer to the copy, which must be
+ * released with str_pool_release(), or NULL on error. */
+char * str_pool_dup(str_pool_t *pool, const char str[]);
+
+/* Releases string allocated by str_pool_dup().  Releasing NULL is OK. */
+void str_pool_release(char str[]);
+
+#endif /* VIFM__UTILS__STR_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
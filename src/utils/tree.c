@@ -18,75 +18,137 @@
 
 #include "tree.h"
 
-#include <stdlib.h> /* free() malloc() */
-#include <string.h>
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uintptr_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() strlen() strncmp() */
 
 #ifdef _WIN32
+#include <ctype.h> /* tolower() */
+
 #include "fs.h"
 #endif
 #include "../compat/fs_limits.h"
 #include "str.h"
+#include "str_pool.h"
+
+/* Number of nodes allocated at once. */
+#define NODES_PER_BLOCK 256
+
+/* Initial size of hash tables, must be a power of two. */
+#define INITIAL_TABLE_SIZE 64
 
+/* Single element of a path.  Children of all nodes are indexed by a single hash
+ * table of the tree keyed by parent node and name. */
 typedef struct node_t
 {
-	char *name;
-	size_t name_len;
-	tree_val_t data;
-	int valid;
-	struct node_t *next;
-	struct node_t *child;
-}node_t;
+	struct node_t *parent; /* Parent node, NULL for the root. */
+	const char *name;      /* Interned name of path component. */
+	size_t name_len;       /* Length of the name. */
+	size_t hash;           /* Hash of parent and name. */
+	tree_val_t data;       /* Data associated with the node. */
+	int valid;             /* Whether data field is set. */
+}
+node_t;
+
+/* Piece of memory nodes are allocated from. */
+typedef struct block_t
+{
+	struct block_t *next;           /* Previously allocated block. */
+	size_t used;                    /* Number of used elements of nodes. */
+	node_t nodes[NODES_PER_BLOCK];  /* Storage of nodes. */
+}
+block_t;
 
 typedef struct root_t
 {
-	node_t node;
-	int longest;
-	int mem;
-}root_t;
+	node_t node;        /* Root node, which isn't in the index. */
+	int longest;        /* Whether searches return data of the closest parent. */
+	int mem;            /* Whether data values are pointers to be freed. */
+
+	node_t **index;     /* Open-addressing hash table of non-root nodes. */
+	size_t index_size;  /* Capacity of the index, power of two. */
+	size_t nnodes;      /* Number of non-root nodes. */
+
+	char **names;       /* Open-addressing hash table of interned names. */
+	size_t names_size;  /* Capacity of the names table, power of two. */
+	size_t nnames;      /* Number of interned names. */
 
-static void nodes_free(node_t *node);
-static node_t * find_node(node_t *root, const char *name, int create,
+	str_pool_t *pool;   /* Storage of interned names. */
+	block_t *blocks;    /* Storage of nodes. */
+}
+root_t;
+
+static node_t * find_node(root_t *tree, const char path[], int create,
 		node_t **last);
+static node_t * find_child(const root_t *tree, const node_t *parent,
+		const char name[], size_t name_len, size_t hash);
+static node_t * add_child(root_t *tree, node_t *parent, const char name[],
+		size_t name_len, size_t hash);
+static int grow_index(root_t *tree);
+static const char * intern_name(root_t *tree, const char name[],
+		size_t name_len);
+static int grow_names(root_t *tree);
+static size_t hash_child(const node_t *parent, const char name[],
+		size_t name_len);
+static size_t hash_name(const char name[], size_t name_len);
+static void free_data(const root_t *tree, node_t *node);
 
 tree_t
 tree_create(int longest, int mem)
 {
-	root_t *tree;
-
-	if((tree = malloc(sizeof(*tree))) == NULL)
+	root_t *const tree = calloc(1, sizeof(*tree));
+	if(tree == NULL)
 	{
 		return NULL_TREE;
 	}
 
-	tree->node.child = NULL;
-	tree->node.next = NULL;
-	tree->node.name = NULL;
-	tree->node.valid = 0;
 	tree->longest = longest;
 	tree->mem = mem;
+
+	tree->index_size = INITIAL_TABLE_SIZE;
+	tree->index = calloc(tree->index_size, sizeof(*tree->index));
+	tree->names_size = INITIAL_TABLE_SIZE;
+	tree->names = calloc(tree->names_size, sizeof(*tree->names));
+	tree->pool = str_pool_create();
+	if(tree->index == NULL || tree->names == NULL || tree->pool == NULL)
+	{
+		tree_free(tree);
+		return NULL_TREE;
+	}
+
 	return tree;
 }
 
 void
 tree_free(tree_t tree)
 {
-	if(tree != NULL_TREE)
+	size_t i;
+
+	if(tree == NULL_TREE)
 	{
-		nodes_free(&tree->node);
+		return;
 	}
-}
 
-static void
-nodes_free(node_t *node)
-{
-	if(node->child != NULL)
-		nodes_free(node->child);
+	while(tree->blocks != NULL)
+	{
+		block_t *const block = tree->blocks;
+		tree->blocks = block->next;
+		free(block);
+	}
 
-	if(node->next != NULL)
-		nodes_free(node->next);
+	if(tree->names != NULL)
+	{
+		for(i = 0U; i < tree->names_size; ++i)
+		{
+			str_pool_release(tree->names[i]);
+		}
+	}
+	str_pool_free(tree->pool);
 
-	free(node->name);
-	free(node);
+	free(tree->names);
+	free(tree->index);
+	free(tree);
 }
 
 int
@@ -98,19 +160,11 @@ tree_set_data(tree_t tree, const char *path, tree_val_t data)
 	if(realpath(path, real_path) != real_path)
 		return -1;
 
-	node = find_node(&tree->node, real_path, 1, NULL);
-	if(node->valid && tree->mem)
-	{
-		union
-		{
-			tree_val_t l;
-			void *p;
-		}u = {
-			.l = node->data,
-		};
+	node = find_node(tree, real_path, 1, NULL);
+	if(node == NULL)
+		return -1;
 
-		free(u.p);
-	}
+	free_data(tree, node);
 	node->data = data;
 	node->valid = 1;
 	return 0;
@@ -123,13 +177,13 @@ tree_get_data(tree_t tree, const char *path, tree_val_t *data)
 	node_t *node;
 	char real_path[PATH_MAX];
 
-	if(tree->node.child == NULL)
+	if(tree->nnodes == 0U)
 		return -1;
 
 	if(realpath(path, real_path) != real_path)
 		return -1;
 
-	node = find_node(&tree->node, real_path, 0, tree->longest ? &last : NULL);
+	node = find_node(tree, real_path, 0, tree->longest ? &last : NULL);
 	if((node == NULL || !node->valid) && last == NULL)
 		return -1;
 
@@ -140,64 +194,283 @@ tree_get_data(tree_t tree, const char *path, tree_val_t *data)
 	return 0;
 }
 
+/* Looks up node that corresponds to the path, optionally creating missing
+ * nodes.  *last is set to the deepest valid non-root node on the path.  Returns
+ * the node or NULL if it's missing or on error. */
 static node_t *
-find_node(node_t *root, const char *name, int create, node_t **last)
+find_node(root_t *tree, const char path[], int create, node_t **last)
 {
-	const char *end;
-	size_t name_len;
-	node_t *prev = NULL, *curr;
-	node_t *new_node;
+	node_t *node = &tree->node;
+
+	while(1)
+	{
+		const char *end;
+		size_t name_len;
+		size_t hash;
+		node_t *child;
+
+		path = skip_char(path, '/');
+		if(*path == '\0')
+		{
+			return node;
+		}
+
+		end = until_first(path, '/');
+		name_len = end - path;
+		hash = hash_child(node, path, name_len);
 
-	name = skip_char(name, '/');
-	if(*name == '\0')
-		return root;
+		child = find_child(tree, node, path, name_len, hash);
+		if(child == NULL)
+		{
+			if(!create)
+			{
+				return NULL;
+			}
+
+			child = add_child(tree, node, path, name_len, hash);
+			if(child == NULL)
+			{
+				return NULL;
+			}
+		}
+		else if(child->valid && last != NULL)
+		{
+			*last = child;
+		}
 
-	end = until_first(name, '/');
+		node = child;
+		path = end;
+	}
+}
+
+/* Looks up child of the parent in the index.  Returns the child or NULL. */
+static node_t *
+find_child(const root_t *tree, const node_t *parent, const char name[],
+		size_t name_len, size_t hash)
+{
+	const size_t mask = tree->index_size - 1U;
+	size_t i = hash & mask;
 
-	name_len = end - name;
-	curr = root->child;
-	while(curr != NULL)
+	while(tree->index[i] != NULL)
 	{
-		int comp = strnoscmp(name, curr->name, name_len);
-		if(comp == 0 && curr->name_len == name_len)
+		const node_t *const node = tree->index[i];
+		if(node->hash == hash && node->parent == parent &&
+				node->name_len == name_len && strnoscmp(node->name, name, name_len) == 0)
 		{
-			if(curr->valid && last != NULL)
-				*last = curr;
-			return find_node(curr, end, create, last);
+			return tree->index[i];
 		}
-		else if(comp < 0)
+		i = (i + 1U) & mask;
+	}
+
+	return NULL;
+}
+
+/* Allocates new child of the parent and adds it to the index.  Returns the
+ * child or NULL on error. */
+static node_t *
+add_child(root_t *tree, node_t *parent, const char name[], size_t name_len,
+		size_t hash)
+{
+	size_t i;
+	node_t *node;
+	block_t *block = tree->blocks;
+
+	if((tree->nnodes + 1U)*4U > tree->index_size*3U && grow_index(tree) != 0)
+	{
+		return NULL;
+	}
+
+	if(block == NULL || block->used == NODES_PER_BLOCK)
+	{
+		block = malloc(sizeof(*block));
+		if(block == NULL)
 		{
-			break;
+			return NULL;
 		}
-		prev = curr;
-		curr = curr->next;
+		block->next = tree->blocks;
+		block->used = 0U;
+		tree->blocks = block;
 	}
 
-	if(!create)
+	node = &block->nodes[block->used];
+	node->name = intern_name(tree, name, name_len);
+	if(node->name == NULL)
+	{
 		return NULL;
+	}
+	++block->used;
 
-	new_node = malloc(sizeof(*new_node));
-	if(new_node == NULL)
+	node->parent = parent;
+	node->name_len = name_len;
+	node->hash = hash;
+	node->valid = 0;
+
+	i = hash & (tree->index_size - 1U);
+	while(tree->index[i] != NULL)
+	{
+		i = (i + 1U) & (tree->index_size - 1U);
+	}
+	tree->index[i] = node;
+	++tree->nnodes;
+
+	return node;
+}
+
+/* Doubles size of the index.  Returns non-zero on error. */
+static int
+grow_index(root_t *tree)
+{
+	size_t i;
+	const size_t new_size = tree->index_size*2U;
+	node_t **const new_index = calloc(new_size, sizeof(*new_index));
+	if(new_index == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < tree->index_size; ++i)
+	{
+		node_t *const node = tree->index[i];
+		if(node != NULL)
+		{
+			size_t j = node->hash & (new_size - 1U);
+			while(new_index[j] != NULL)
+			{
+				j = (j + 1U) & (new_size - 1U);
+			}
+			new_index[j] = node;
+		}
+	}
+
+	free(tree->index);
+	tree->index = new_index;
+	tree->index_size = new_size;
+	return 0;
+}
+
+/* Finds or stores a copy of the name in the tree.  Returns the copy or NULL on
+ * error. */
+static const char *
+intern_name(root_t *tree, const char name[], size_t name_len)
+{
+	char buf[PATH_MAX];
+	size_t i;
+
+	if((tree->nnames + 1U)*4U > tree->names_size*3U && grow_names(tree) != 0)
+	{
 		return NULL;
+	}
 
-	if((new_node->name = malloc(name_len + 1)) == NULL)
+	i = hash_name(name, name_len) & (tree->names_size - 1U);
+	while(tree->names[i] != NULL)
+	{
+		const char *const interned = tree->names[i];
+		if(strncmp(interned, name, name_len) == 0 && interned[name_len] == '\0')
+		{
+			return interned;
+		}
+		i = (i + 1U) & (tree->names_size - 1U);
+	}
+
+	if(name_len >= sizeof(buf))
 	{
-		free(new_node);
 		return NULL;
 	}
-	strncpy(new_node->name, name, name_len);
-	new_node->name[name_len] = '\0';
-	new_node->name_len = name_len;
-	new_node->valid = 0;
-	new_node->child = NULL;
-	new_node->next = curr;
+	memcpy(buf, name, name_len);
+	buf[name_len] = '\0';
 
-	if(root->child == curr)
-		root->child = new_node;
-	else
-		prev->next = new_node;
+	tree->names[i] = str_pool_dup(tree->pool, buf);
+	if(tree->names[i] == NULL)
+	{
+		return NULL;
+	}
+	++tree->nnames;
+
+	return tree->names[i];
+}
+
+/* Doubles size of the table of interned names.  Returns non-zero on error. */
+static int
+grow_names(root_t *tree)
+{
+	size_t i;
+	const size_t new_size = tree->names_size*2U;
+	char **const new_names = calloc(new_size, sizeof(*new_names));
+	if(new_names == NULL)
+	{
+		return 1;
+	}
 
-	return find_node(new_node, end, create, last);
+	for(i = 0U; i < tree->names_size; ++i)
+	{
+		char *const name = tree->names[i];
+		if(name != NULL)
+		{
+			size_t j = hash_name(name, strlen(name)) & (new_size - 1U);
+			while(new_names[j] != NULL)
+			{
+				j = (j + 1U) & (new_size - 1U);
+			}
+			new_names[j] = name;
+		}
+	}
+
+	free(tree->names);
+	tree->names = new_names;
+	tree->names_size = new_size;
+	return 0;
+}
+
+/* Computes hash of a child node, which accounts for case-insensitivity of
+ * paths on some systems.  Returns the hash. */
+static size_t
+hash_child(const node_t *parent, const char name[], size_t name_len)
+{
+	size_t i;
+	size_t hash = (size_t)((uintptr_t)parent/sizeof(*parent))*2654435761U;
+
+	for(i = 0U; i < name_len; ++i)
+	{
+#ifndef _WIN32
+		hash = (hash ^ (unsigned char)name[i])*16777619U;
+#else
+		hash = (hash ^ tolower((unsigned char)name[i]))*16777619U;
+#endif
+	}
+	return hash ^ (hash >> 15);
+}
+
+/* Computes case-sensitive hash of a name.  Returns the hash. */
+static size_t
+hash_name(const char name[], size_t name_len)
+{
+	size_t i;
+	size_t hash = 2166136261U;
+
+	for(i = 0U; i < name_len; ++i)
+	{
+		hash = (hash ^ (unsigned char)name[i])*16777619U;
+	}
+	return hash ^ (hash >> 15);
+}
+
+/* Frees data of the node if it's valid and the tree stores pointers. */
+static void
+free_data(const root_t *tree, node_t *node)
+{
+	if(node->valid && tree->mem)
+	{
+		union
+		{
+			tree_val_t l;
+			void *p;
+		}u = {
+			.l = node->data,
+		};
+
+		free(u.p);
+		node->valid = 0;
+	}
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
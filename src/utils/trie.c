@@ -18,26 +18,57 @@
 
 #include "trie.h"
 
-#include <stdlib.h> /* calloc() free() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* strcmp() */
 
-/* Trie node. */
+#include "str_pool.h"
+
+/* Initial capacity of the table, must be a power of two. */
+#define INITIAL_SIZE 64
+
+/* Element of the table. */
+typedef struct
+{
+	char *key;   /* Pooled copy of the string or NULL for free slots. */
+	size_t hash; /* Hash of the key. */
+	void *data;  /* Data associated with the key. */
+}
+entry_t;
+
+/* Set of strings implemented as open-addressing hash table.  Strings are
+ * stored in a pool to avoid allocating each of them separately. */
 struct trie_t
 {
-	trie_t left;     /* Nodes with values less than value. */
-	trie_t right;    /* Nodes with values greater than value. */
-	trie_t children; /* Child nodes. */
-	void *data;      /* Data associated with the key. */
-	char value;      /* Value of the node. */
-	char exists;     /* Whether this node exists or it's an intermediate node. */
+	entry_t *entries; /* Table of entries. */
+	size_t size;      /* Capacity of the table, power of two. */
+	size_t count;     /* Number of used slots. */
+	str_pool_t *pool; /* Storage of keys. */
 };
 
-static trie_t get_or_create(trie_t trie, const char str[], void *data,
-		int *result);
+static entry_t * find(trie_t trie, const char str[], size_t hash);
+static int grow(trie_t trie);
+static size_t hash_str(const char str[]);
 
 trie_t
 trie_create(void)
 {
-	return calloc(1U, sizeof(struct trie_t));
+	trie_t trie = calloc(1U, sizeof(*trie));
+	if(trie == NULL_TRIE)
+	{
+		return NULL_TRIE;
+	}
+
+	trie->size = INITIAL_SIZE;
+	trie->entries = calloc(trie->size, sizeof(*trie->entries));
+	trie->pool = str_pool_create();
+	if(trie->entries == NULL || trie->pool == NULL)
+	{
+		trie_free(trie);
+		return NULL_TRIE;
+	}
+
+	return trie;
 }
 
 void
@@ -45,9 +76,13 @@ trie_free(trie_t trie)
 {
 	if(trie != NULL_TRIE)
 	{
-		trie_free(trie->left);
-		trie_free(trie->right);
-		trie_free(trie->children);
+		size_t i;
+		for(i = 0U; i < trie->size && trie->entries != NULL; ++i)
+		{
+			str_pool_release(trie->entries[i].key);
+		}
+		free(trie->entries);
+		str_pool_free(trie->pool);
 		free(trie);
 	}
 }
@@ -61,86 +96,125 @@ trie_put(trie_t trie, const char str[])
 int
 trie_set(trie_t trie, const char str[], const void *data)
 {
-	int result;
+	size_t hash;
+	entry_t *entry;
 
 	if(trie == NULL_TRIE)
 	{
 		return -1;
 	}
 
-	(void)get_or_create(trie, str, (void *)data, &result);
-	return result;
-}
-
-/* Gets node which might involve its creation.  Sets *return to negative value
- * on error, to zero on successful insertion and to positive number if element
- * was already in the trie. */
-static trie_t
-get_or_create(trie_t trie, const char str[], void *data, int *result)
-{
-	/* Create inexistent node. */
-	if(trie == NULL_TRIE)
+	hash = hash_str(str);
+	entry = find(trie, str, hash);
+	if(entry->key != NULL)
 	{
-		trie = trie_create();
-		if(trie == NULL_TRIE)
-		{
-			*result = -1;
-			return trie;
-		}
-		trie->value = *str;
+		entry->data = (void *)data;
+		return 1;
 	}
 
-	if(trie->value == *str)
+	if((trie->count + 1U)*4U > trie->size*3U)
 	{
-		if(*str == '\0')
-		{
-			/* Found full match. */
-			*result = (trie->exists != 0);
-			trie->exists = 1;
-			trie->data = data;
-		}
-		else
+		if(grow(trie) != 0)
 		{
-			trie->children = get_or_create(trie->children, str + 1, data, result);
+			return -1;
 		}
+		entry = find(trie, str, hash);
 	}
-	else if(*str < trie->value)
-	{
-		trie->left = get_or_create(trie->left, str, data, result);
-	}
-	else
+
+	entry->key = str_pool_dup(trie->pool, str);
+	if(entry->key == NULL)
 	{
-		trie->right = get_or_create(trie->right, str, data, result);
+		return -1;
 	}
-
-	return trie;
+	entry->hash = hash;
+	entry->data = (void *)data;
+	++trie->count;
+	return 0;
 }
 
 int
 trie_get(trie_t trie, const char str[], void **data)
 {
+	const entry_t *entry;
+
 	if(trie == NULL_TRIE)
 	{
 		return 1;
 	}
 
-	if(trie->value != *str)
+	entry = find(trie, str, hash_str(str));
+	if(entry->key == NULL)
+	{
+		return 1;
+	}
+
+	*data = entry->data;
+	return 0;
+}
+
+/* Looks up slot of the string.  Returns either slot that contains the string
+ * or free slot where it should be inserted. */
+static entry_t *
+find(trie_t trie, const char str[], size_t hash)
+{
+	const size_t mask = trie->size - 1U;
+	size_t i = hash & mask;
+
+	while(trie->entries[i].key != NULL)
+	{
+		const entry_t *const entry = &trie->entries[i];
+		if(entry->hash == hash && strcmp(entry->key, str) == 0)
+		{
+			break;
+		}
+		i = (i + 1U) & mask;
+	}
+
+	return &trie->entries[i];
+}
+
+/* Doubles capacity of the table.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+grow(trie_t trie)
+{
+	size_t i;
+	const size_t new_size = trie->size*2U;
+	entry_t *const entries = calloc(new_size, sizeof(*entries));
+	if(entries == NULL)
 	{
-		return trie_get((*str < trie->value) ? trie->left : trie->right, str, data);
+		return 1;
 	}
 
-	if(*str == '\0')
+	for(i = 0U; i < trie->size; ++i)
 	{
-		/* Found full match. */
-		if(!trie->exists)
+		if(trie->entries[i].key != NULL)
 		{
-			return 1;
+			size_t j = trie->entries[i].hash & (new_size - 1U);
+			while(entries[j].key != NULL)
+			{
+				j = (j + 1U) & (new_size - 1U);
+			}
+			entries[j] = trie->entries[i];
 		}
-		*data = trie->data;
-		return 0;
 	}
 
-	return trie_get(trie->children, str + 1, data);
+	free(trie->entries);
+	trie->entries = entries;
+	trie->size = new_size;
+	return 0;
+}
+
+/* Computes hash of a string.  Returns the hash. */
+static size_t
+hash_str(const char str[])
+{
+	size_t hash = 2166136261U;
+	while(*str != '\0')
+	{
+		hash = (hash ^ (unsigned char)*str++)*16777619U;
+	}
+	return hash ^ (hash >> 15);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -24,7 +24,8 @@
 /* NULL equivalent for variables of type trie_t. */
 #define NULL_TRIE NULL
 
-/* Declaration of opaque trie type. */
+/* Declaration of opaque trie type.  Despite the name, it's a hash table of
+ * strings. */
 typedef struct trie_t *trie_t;
 
 /* Creates new empty trie.  Returns NULL_TRIE on error. */
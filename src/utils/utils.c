@@ -36,7 +36,7 @@
 #include <stddef.h> /* size_t */
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strdup() strchr() strlen() strpbrk() */
+#include <string.h> /* strdup() strchr() strcspn() strlen() strpbrk() */
 #include <wchar.h> /* wcwidth() */
 
 #include "../modes/dialogs/msg_dialog.h"
@@ -260,6 +260,26 @@ regexp_should_ignore_case(const char pattern[])
 	return ignore_case;
 }
 
+int
+regexp_is_literal(const char pattern[])
+{
+	return pattern[strcspn(pattern, ".[]()*+?{}|^$\\")] == '\0';
+}
+
+int
+regexp_narrows(const char prev[], int prev_cflags, const char next[],
+		int next_cflags)
+{
+	if(!starts_with(next, prev) || !regexp_is_literal(prev) ||
+			!regexp_is_literal(next))
+	{
+		return 0;
+	}
+
+	/* Case-sensitive matches can't be narrowed to case-insensitive ones. */
+	return (prev_cflags & REG_ICASE) || !(next_cflags & REG_ICASE);
+}
+
 const char *
 get_regexp_error(int err, regex_t *re)
 {
@@ -22,7 +22,7 @@
 
 #include <regex.h>
 
-#include <sys/types.h> /* gid_t mode_t uid_t */
+#include <sys/types.h> /* gid_t mode_t pid_t uid_t */
 
 #include <stddef.h> /* size_t wchar_t */
 #include <stdint.h> /* uint64_t */
@@ -53,6 +53,17 @@ int get_regexp_cflags(const char pattern[]);
  * ignored, otherwise zero is returned. */
 int regexp_should_ignore_case(const char pattern[]);
 
+/* Checks whether pattern has no special characters of extended regular
+ * expressions and thus matches only itself.  Returns non-zero if so, otherwise
+ * zero is returned. */
+int regexp_is_literal(const char pattern[]);
+
+/* Checks whether everything matched by the next pattern is also matched by the
+ * prev one, which is the case when both are literals and the next one extends
+ * the prev one.  Returns non-zero if so, otherwise zero is returned. */
+int regexp_narrows(const char prev[], int prev_cflags, const char next[],
+		int next_cflags);
+
 const char * get_regexp_error(int err, regex_t *re);
 
 /* *case_sensitive should be initialized with default value outside the call.
@@ -252,6 +263,19 @@ int reopen_term_stdin(void);
  * NULL on error, otherwise stream valid for reading is returned. */
 FILE * read_cmd_output(const char cmd[]);
 
+/* Same as read_cmd_output(), but makes the command a leader of a new process
+ * group and stores id of the group in *pgid, so that the command can be
+ * terminated along with its children.  *pgid is set to (pid_t)-1 if that's not
+ * supported.  Returns NULL on error. */
+FILE * read_cmd_output_in_group(const char cmd[], pid_t *pgid);
+
+/* Terminates all processes of the group started by read_cmd_output_in_group().
+ * Does nothing for (pid_t)-1. */
+void kill_process_group(pid_t pgid);
+
+/* Asks process to stop as if Ctrl-C was pressed. */
+void interrupt_process(pid_t pid);
+
 /* Gets path to directory where files bundled with Vifm are stored.  Returns
  * pointer to a statically allocated buffer. */
 const char * get_installed_data_dir(void);
@@ -34,7 +34,7 @@
 #include <fcntl.h> /* open() close() */
 #include <grp.h> /* getgrnam() getgrgid_r() */
 #include <pwd.h> /* getpwnam() getpwuid_r() */
-#include <unistd.h> /* X_OK dup() dup2() getpid() pause() */
+#include <unistd.h> /* X_OK dup() dup2() getpid() pause() setpgid() */
 
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
@@ -90,6 +90,8 @@ static int clone_mnt_entry(struct mntent *lhs, const struct mntent *rhs);
 static void free_mnt_entry(struct mntent *entry);
 static int starts_with_list_item(const char str[], const char list[]);
 static int find_path_prefix_index(const char path[], const char list[]);
+static FILE * read_cmd_output_internal(const char cmd[], int new_group,
+		pid_t *pgid);
 
 void
 pause_shell(void)
@@ -720,7 +722,7 @@ display_help(const char cmd[])
 int
 update_dir_mtime(FileView *view)
 {
-	return filemon_from_file(view->curr_dir, &view->mon);
+	return filemon_watch_dir(view->curr_dir, &view->mon);
 }
 
 void
@@ -888,6 +890,21 @@ reopen_term_stdin(void)
 
 FILE *
 read_cmd_output(const char cmd[])
+{
+	return read_cmd_output_internal(cmd, 0, NULL);
+}
+
+FILE *
+read_cmd_output_in_group(const char cmd[], pid_t *pgid)
+{
+	return read_cmd_output_internal(cmd, 1, pgid);
+}
+
+/* Implementation of read_cmd_output() and read_cmd_output_in_group().  pgid
+ * is set only when new_group is non-zero.  Returns NULL on error, otherwise
+ * stream valid for reading is returned. */
+static FILE *
+read_cmd_output_internal(const char cmd[], int new_group, pid_t *pgid)
 {
 	FILE *fp;
 	pid_t pid;
@@ -901,15 +918,28 @@ read_cmd_output(const char cmd[])
 	pid = fork();
 	if(pid == (pid_t)-1)
 	{
+		close(out_pipe[0]);
+		close(out_pipe[1]);
 		return NULL;
 	}
 
 	if(pid == 0)
 	{
+		if(new_group)
+		{
+			(void)setpgid(0, 0);
+		}
 		run_from_fork(out_pipe, 0, (char *)cmd);
 		return NULL;
 	}
 
+	if(new_group)
+	{
+		/* Also set group in parent to avoid race with kill_process_group(). */
+		(void)setpgid(pid, pid);
+		*pgid = pid;
+	}
+
 	/* Close write end of pipe. */
 	close(out_pipe[1]);
 
@@ -921,6 +951,21 @@ read_cmd_output(const char cmd[])
 	return fp;
 }
 
+void
+kill_process_group(pid_t pgid)
+{
+	if(pgid != (pid_t)-1)
+	{
+		(void)kill(-pgid, SIGTERM);
+	}
+}
+
+void
+interrupt_process(pid_t pid)
+{
+	(void)kill(pid, SIGINT);
+}
+
 const char *
 get_installed_data_dir(void)
 {
@@ -833,6 +833,25 @@ read_cmd_output(const char cmd[])
 	return result;
 }
 
+FILE *
+read_cmd_output_in_group(const char cmd[], pid_t *pgid)
+{
+	*pgid = (pid_t)-1;
+	return read_cmd_output(cmd);
+}
+
+void
+kill_process_group(pid_t pgid)
+{
+	/* Not supported. */
+}
+
+void
+interrupt_process(pid_t pid)
+{
+	/* Not supported. */
+}
+
 const char *
 get_installed_data_dir(void)
 {
@@ -0,0 +1,277 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+#include <unistd.h> /* rmdir() unlink() */
+#include <utime.h> /* utimbuf utime() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() fread() fwrite() remove() */
+#include <string.h> /* memchr() strcpy() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/utils/tree.h"
+#include "../../src/dircache.h"
+#include "../../src/fileops.h"
+#include "../../src/status.h"
+
+#define DIR_PATH SANDBOX_PATH "/dir"
+#define SUBDIR_PATH DIR_PATH "/sub"
+#define FILE_PATH SUBDIR_PATH "/file"
+
+static void create_file(const char path[], const char contents[]);
+static void drop_first_line(const char path[]);
+static void forget_sizes(void);
+static void forget_sizes_in_memory(void);
+
+SETUP()
+{
+	strcpy(cfg.config_dir, SANDBOX_PATH);
+	assert_success(dcache_clear());
+
+	assert_success(os_mkdir(DIR_PATH, 0700));
+	assert_success(os_mkdir(SUBDIR_PATH, 0700));
+	create_file(FILE_PATH, "12345");
+}
+
+TEARDOWN()
+{
+	forget_sizes();
+	tree_free(curr_stats.dirsize_cache);
+	curr_stats.dirsize_cache = NULL_TREE;
+	cfg.dir_size_allocated = 0;
+
+	(void)remove(SANDBOX_PATH "/dirsizes");
+	assert_success(unlink(FILE_PATH));
+	assert_success(rmdir(SUBDIR_PATH));
+	assert_success(rmdir(DIR_PATH));
+}
+
+TEST(sizes_are_restored_from_file)
+{
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	dcache_save();
+	forget_sizes();
+
+	assert_success(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+}
+
+TEST(outdated_sizes_are_discarded)
+{
+	struct stat st;
+	struct utimbuf t;
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	dcache_save();
+	forget_sizes();
+
+	assert_success(os_stat(DIR_PATH, &st));
+	t.actime = st.st_atime;
+	t.modtime = st.st_mtime + 10;
+	assert_success(utime(DIR_PATH, &t));
+
+	assert_failure(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(0U, size);
+}
+
+TEST(stored_sizes_are_not_used_for_calculation)
+{
+	assert_ulong_equal(5U, calculate_dir_size(SUBDIR_PATH, 1));
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 0));
+	dcache_save();
+	forget_sizes();
+
+	/* Changing contents of a file doesn't update modification time of its
+	 * directory. */
+	create_file(FILE_PATH, "1234567890");
+
+	assert_ulong_equal(10U, calculate_dir_size(DIR_PATH, 0));
+}
+
+TEST(sizes_calculated_in_this_session_are_used_unless_forced)
+{
+	assert_ulong_equal(5U, calculate_dir_size(SUBDIR_PATH, 1));
+	create_file(FILE_PATH, "1234567890");
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 0));
+	assert_ulong_equal(10U, calculate_dir_size(DIR_PATH, 1));
+}
+
+TEST(sizes_of_subdirectories_are_stored)
+{
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	dcache_save();
+	forget_sizes();
+
+	assert_success(dcache_get_size(SUBDIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+	size = 0U;
+	assert_success(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+}
+
+TEST(changed_subdirectory_discards_size_of_parent)
+{
+	struct stat st;
+	struct utimbuf t;
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	dcache_save();
+	forget_sizes();
+
+	assert_success(os_stat(SUBDIR_PATH, &st));
+	t.actime = st.st_atime;
+	t.modtime = st.st_mtime + 10;
+	assert_success(utime(SUBDIR_PATH, &t));
+
+	assert_failure(dcache_get_size(DIR_PATH, 0, &size));
+	assert_failure(dcache_get_size(SUBDIR_PATH, 0, &size));
+	assert_ulong_equal(0U, size);
+}
+
+TEST(missing_subdirectory_discards_size_of_parent)
+{
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	dcache_save();
+	forget_sizes();
+
+	/* Subdirectory is stored first as it's calculated first. */
+	drop_first_line(SANDBOX_PATH "/dirsizes");
+
+	assert_failure(dcache_get_size(DIR_PATH, 0, &size));
+}
+
+TEST(recalculation_of_subdirectory_discards_size_of_parent)
+{
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	forget_sizes_in_memory();
+
+	create_file(FILE_PATH, "1234567890");
+	assert_ulong_equal(10U, calculate_dir_size(SUBDIR_PATH, 1));
+	forget_sizes_in_memory();
+
+	assert_failure(dcache_get_size(DIR_PATH, 0, &size));
+	assert_success(dcache_get_size(SUBDIR_PATH, 0, &size));
+	assert_ulong_equal(10U, size);
+}
+
+TEST(forced_update_ignores_known_sizes)
+{
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+
+	create_file(FILE_PATH, "1234567890");
+
+	assert_ulong_equal(10U, calculate_dir_size(DIR_PATH, 1));
+}
+
+TEST(sizes_depend_on_dirsizemode)
+{
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	assert_failure(dcache_get_size(DIR_PATH, 1, &size));
+	assert_success(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+
+	dcache_save();
+	forget_sizes();
+
+	assert_failure(dcache_get_size(DIR_PATH, 1, &size));
+	assert_success(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+}
+
+TEST(persistent_sizes_are_checked_once)
+{
+	struct stat st;
+	struct utimbuf t;
+	uint64_t size = 0U;
+
+	assert_ulong_equal(5U, calculate_dir_size(DIR_PATH, 1));
+	dcache_save();
+	forget_sizes();
+
+	assert_success(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+
+	assert_success(os_stat(DIR_PATH, &st));
+	t.actime = st.st_atime;
+	t.modtime = st.st_mtime + 10;
+	assert_success(utime(DIR_PATH, &t));
+
+	size = 0U;
+	assert_success(dcache_get_size(DIR_PATH, 0, &size));
+	assert_ulong_equal(5U, size);
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+/* Removes first line of a file. */
+static void
+drop_first_line(const char path[])
+{
+	char buf[PATH_MAX*2];
+	size_t len;
+	FILE *f = fopen(path, "r");
+	assert_non_null(f);
+	if(f == NULL)
+	{
+		return;
+	}
+
+	len = fread(buf, 1U, sizeof(buf), f);
+	fclose(f);
+
+	f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		const char *const nl = memchr(buf, '\n', len);
+		assert_non_null(nl);
+		if(nl != NULL)
+		{
+			fwrite(nl + 1, 1U, len - (nl + 1 - buf), f);
+		}
+		fclose(f);
+	}
+}
+
+/* Drops both in-memory and loaded persistent sizes. */
+static void
+forget_sizes(void)
+{
+	dcache_reset();
+	forget_sizes_in_memory();
+}
+
+/* Drops in-memory sizes. */
+static void
+forget_sizes_in_memory(void)
+{
+	assert_success(dcache_clear());
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
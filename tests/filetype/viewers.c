@@ -108,5 +108,30 @@ TEST(several_patterns)
 	assert_true(ft_get_viewer("file.version.tar.bz2") != NULL);
 }
 
+TEST(order_of_patterns_of_different_kinds_is_preserved)
+{
+	const char *viewer;
+
+	set_viewers("*.bz2", "prog2");
+	set_viewers("file.*", "prog1");
+	set_viewers("*.tar.bz2", "prog2");
+
+	ft_init(&prog1_available);
+	viewer = ft_get_viewer("file.tar.bz2");
+	assert_non_null(viewer);
+	if(viewer != NULL)
+	{
+		assert_string_equal("prog1", viewer);
+	}
+
+	ft_init(&prog2_available);
+	viewer = ft_get_viewer("file.tar.bz2");
+	assert_non_null(viewer);
+	if(viewer != NULL)
+	{
+		assert_string_equal("prog2", viewer);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
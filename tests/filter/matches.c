@@ -45,5 +45,30 @@ TEST(returns_negative_number_for_invalid_regexp)
 	filter_dispose(&filter);
 }
 
+TEST(literal_matches_substring)
+{
+	filter_t filter;
+	assert_int_equal(0, filter_init(&filter, 1));
+
+	assert_int_equal(0, filter_set(&filter, "bc"));
+	assert_true(filter_matches(&filter, "abcd") > 0);
+	assert_true(filter_matches(&filter, "aBcd") == 0);
+
+	filter_dispose(&filter);
+}
+
+TEST(case_insensitive_literal_matches_substring)
+{
+	filter_t filter;
+	assert_int_equal(0, filter_init(&filter, 0));
+
+	assert_int_equal(0, filter_set(&filter, "bc"));
+	assert_true(filter_matches(&filter, "aBcd") > 0);
+	assert_true(filter_matches(&filter, "aBcd\xd1\x84") > 0);
+	assert_true(filter_matches(&filter, "acbd") == 0);
+
+	filter_dispose(&filter);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
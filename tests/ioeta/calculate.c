@@ -95,5 +95,34 @@ TEST(symlink_calculated_as_zero_bytes)
 
 #endif
 
+TEST(background_calculation_yields_same_results)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/various-sizes", 0);
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/existing-files", 0);
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/various-sizes", 1);
+	ioeta_wait(estim);
+
+	assert_false(estim->counting);
+	assert_int_equal(7 + 3 + 1, estim->total_items);
+	assert_int_equal(0, estim->current_item);
+	assert_int_equal(73728, estim->total_bytes);
+	assert_int_equal(0, estim->current_byte);
+
+	ioeta_free(estim);
+}
+
+TEST(background_calculation_can_be_abandoned)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	ioeta_calculate_bg(estim, TEST_DATA_PATH, 0);
+	ioeta_update(estim, "path", "path", 1, 0);
+	assert_true(estim->total_items >= 1);
+
+	ioeta_free(estim);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -8,6 +8,8 @@
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/private/ioeta.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/utils.h"
@@ -172,6 +174,34 @@ file_is_copied(const char original[])
 	delete_test_file(SANDBOX_PATH "/copy");
 }
 
+TEST(copied_bytes_are_reported)
+{
+	const char *const original = TEST_DATA_PATH
+		"/various-sizes/double-block-size-plus-one-file";
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	{
+		io_args_t args = {
+			.arg1.src = original,
+			.arg2.dst = SANDBOX_PATH "/copy",
+
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(iop_cp(&args));
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_int_equal(get_file_size(original), estim->current_byte);
+	assert_int_equal(1, estim->current_item);
+	assert_true(files_are_identical(SANDBOX_PATH "/copy", original));
+
+	ioeta_free(estim);
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
 TEST(appending_works_for_files)
 {
 	uint64_t size;
@@ -4,6 +4,9 @@
 #include <sys/types.h> /* stat */
 #include <unistd.h> /* F_OK access() lstat() */
 
+#include <stdio.h> /* snprintf() */
+
+#include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/io/iop.h"
 #include "../../src/io/ior.h"
@@ -497,6 +500,54 @@ TEST(permissions_are_set_in_correct_order)
 	}
 }
 
+TEST(tree_is_copied_by_several_threads)
+{
+	int i;
+	struct stat src;
+	struct stat dst;
+
+	create_empty_nested_dir(SANDBOX_PATH "/dir", "nested-dir");
+	for(i = 0; i < 100; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%s/file%d", SANDBOX_PATH "/dir",
+				(i%2 == 0) ? "nested-dir" : ".", i);
+		clone_file(TEST_DATA_PATH "/read/binary-data", path);
+	}
+	assert_success(chmod(SANDBOX_PATH "/dir/nested-dir", 0500));
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/dir",
+			.arg2.dst = SANDBOX_PATH "/dir-copy",
+			.max_threads = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	for(i = 0; i < 100; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%s/file%d", SANDBOX_PATH "/dir-copy",
+				(i%2 == 0) ? "nested-dir" : ".", i);
+		assert_int_equal(get_file_size(TEST_DATA_PATH "/read/binary-data"),
+				get_file_size(path));
+	}
+
+	assert_success(os_stat(SANDBOX_PATH "/dir/nested-dir", &src));
+	assert_success(os_stat(SANDBOX_PATH "/dir-copy/nested-dir", &dst));
+	assert_int_equal(src.st_mode & 0777, dst.st_mode & 0777);
+
+	assert_success(chmod(SANDBOX_PATH "/dir/nested-dir", 0700));
+	assert_success(chmod(SANDBOX_PATH "/dir-copy/nested-dir", 0700));
+
+	delete_tree(SANDBOX_PATH "/dir");
+	delete_tree(SANDBOX_PATH "/dir-copy");
+}
+
 /* Creating symbolic links on Windows requires administrator rights. */
 TEST(symlink_to_file_is_symlink_after_copy, IF(not_windows))
 {
@@ -5,6 +5,7 @@
 
 #include "../../src/cfg/config.h"
 #include "../../src/ui/ui.h"
+#include "../../src/filelist.h"
 #include "../../src/filtering.h"
 
 #define assert_hidden(view, name, dir) \
@@ -13,6 +14,8 @@
 #define assert_visible(view, name, dir) \
 	assert_true(file_is_visible(&view, name, dir))
 
+static void set_local_filter(const char value[]);
+
 SETUP()
 {
 	cfg.slow_fs_list = strdup("");
@@ -95,7 +98,7 @@ cleanup_view(FileView *view)
 	int i;
 
 	for(i = 0; i < view->list_rows; i++)
-		free(view->dir_entry[i].name);
+		free_dir_entry(view, &view->dir_entry[i]);
 	free(view->dir_entry);
 	filter_dispose(&view->manual_filter);
 	filter_dispose(&view->auto_filter);
@@ -200,5 +203,87 @@ TEST(filtering_files_and_dirs)
 	assert_int_equal(8, rwin.list_rows);
 }
 
+TEST(local_filter_is_narrowed_and_widened_back)
+{
+	int i;
+
+	assert_success(filter_init(&lwin.local_filter.filter, 1));
+
+	set_local_filter("with");
+	assert_int_equal(7, lwin.list_rows);
+
+	set_local_filter("withn");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("withnonodots", lwin.dir_entry[0].name);
+
+	set_local_filter("with");
+	assert_int_equal(7, lwin.list_rows);
+
+	set_local_filter("with.*dots");
+	assert_int_equal(2, lwin.list_rows);
+
+	set_local_filter("with\\.");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("with....dots", lwin.dir_entry[0].name);
+
+	local_filter_cancel(&lwin);
+	assert_int_equal(7, lwin.list_rows);
+
+	for(i = 0; i < lwin.custom.entry_count; ++i)
+	{
+		free_dir_entry(&lwin, &lwin.custom.entries[i]);
+	}
+	free(lwin.custom.entries);
+	lwin.custom.entries = NULL;
+	lwin.custom.entry_count = 0;
+
+	filter_dispose(&lwin.local_filter.filter);
+}
+
+TEST(case_sensitive_local_filter_is_not_widened_to_case_insensitive_one)
+{
+	int i;
+
+	cfg.ignore_case = 1;
+	cfg.smart_case = 1;
+	assert_success(filter_init(&lwin.local_filter.filter, 1));
+
+	set_local_filter("withs");
+	assert_int_equal(1, lwin.list_rows);
+
+	set_local_filter("withsP");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("..", lwin.dir_entry[0].name);
+
+	set_local_filter("withSP");
+	assert_int_equal(1, lwin.list_rows);
+
+	set_local_filter("withsp");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("withSPECS+*^$?|\\", lwin.dir_entry[0].name);
+
+	local_filter_cancel(&lwin);
+	assert_int_equal(7, lwin.list_rows);
+
+	for(i = 0; i < lwin.custom.entry_count; ++i)
+	{
+		free_dir_entry(&lwin, &lwin.custom.entries[i]);
+	}
+	free(lwin.custom.entries);
+	lwin.custom.entries = NULL;
+	lwin.custom.entry_count = 0;
+
+	filter_dispose(&lwin.local_filter.filter);
+	cfg.ignore_case = 0;
+	cfg.smart_case = 0;
+}
+
+static void
+set_local_filter(const char value[])
+{
+	local_filter_set(&lwin, value);
+	local_filter_update_view(&lwin, 0);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
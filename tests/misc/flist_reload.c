@@ -1,13 +1,22 @@
 #include <stic.h>
 
+#include <unistd.h> /* link() rmdir() unlink() */
+
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
 #include <string.h> /* memset() */
 
+#include "../../src/cfg/config.h"
 #include "../../src/compat/os.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/tree.h"
+#include "../../src/dircache.h"
 #include "../../src/filelist.h"
+#include "../../src/status.h"
+
+static void create_file(const char path[], const char contents[]);
 
 static FileView *const view = &lwin;
 
@@ -20,6 +29,7 @@ SETUP()
 	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
 
 	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+	assert_success(dcache_clear());
 
 	assert_success(os_mkdir("0", 0000));
 	assert_success(os_mkdir("1", 0000));
@@ -41,13 +51,16 @@ TEARDOWN()
 	int i;
 
 	for(i = 0; i < view->list_rows; i++)
-		free(view->dir_entry[i].name);
+		free_dir_entry(view, &view->dir_entry[i]);
 	free(view->dir_entry);
 
 	filter_dispose(&view->auto_filter);
 	filter_dispose(&view->manual_filter);
 	filter_dispose(&view->local_filter.filter);
 
+	tree_free(curr_stats.dirsize_cache);
+	curr_stats.dirsize_cache = NULL_TREE;
+
 	(void)rmdir("0");
 	(void)rmdir("1");
 	(void)rmdir("2");
@@ -101,5 +114,96 @@ TEST(selection_is_preserved)
 	assert_int_equal(2, view->selected_files);
 }
 
+TEST(new_file_is_inserted_in_sorted_position)
+{
+	view->list_pos = 2;
+	assert_success(os_mkdir("15", 0000));
+
+	populate_dir_list(view, 1);
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("1", view->dir_entry[1].name);
+	assert_string_equal("15", view->dir_entry[2].name);
+	assert_string_equal("2", view->dir_entry[3].name);
+	assert_string_equal("3", view->dir_entry[4].name);
+	assert_string_equal("2", view->dir_entry[view->list_pos].name);
+
+	(void)rmdir("15");
+}
+
+TEST(replaced_file_is_reloaded)
+{
+	FILE *f;
+
+	assert_success(rmdir("1"));
+	f = fopen("1", "w");
+	assert_non_null(f);
+	fputs("content", f);
+	fclose(f);
+
+	populate_dir_list(view, 1);
+	assert_int_equal(4, view->list_rows);
+	assert_string_equal("1", view->dir_entry[3].name);
+	assert_int_equal(FT_REG, view->dir_entry[3].type);
+	assert_int_equal(7, view->dir_entry[3].size);
+
+	(void)unlink("1");
+}
+
+TEST(files_changed_behind_monitors_back_are_updated)
+{
+	create_file("4", "1");
+	populate_dir_list(view, 1);
+	assert_int_equal(5, view->list_rows);
+
+	/* Modification through a hard link doesn't produce notification for the
+	 * original name. */
+	assert_success(link("4", "5"));
+	create_file("5", "12345");
+
+	populate_dir_list(view, 1);
+	assert_int_equal(6, view->list_rows);
+	assert_string_equal("4", view->dir_entry[4].name);
+	assert_int_equal(5, view->dir_entry[4].size);
+
+	(void)unlink("4");
+	(void)unlink("5");
+}
+
+TEST(files_are_updated_by_several_threads)
+{
+	cfg.dir_load_threads = 4;
+
+	create_file("4", "1");
+	populate_dir_list(view, 1);
+	assert_int_equal(5, view->list_rows);
+
+	assert_success(link("4", "5"));
+	create_file("5", "12345");
+	assert_success(rmdir("2"));
+
+	populate_dir_list(view, 1);
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("4", view->dir_entry[3].name);
+	assert_int_equal(5, view->dir_entry[3].size);
+
+	cfg.dir_load_threads = 1;
+
+	(void)unlink("4");
+	(void)unlink("5");
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,74 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/menus/menus.h"
+#include "../../src/utils/str_pool.h"
+
+static str_pool_t *pool;
+static char *buf;
+static size_t buf_size;
+
+SETUP()
+{
+	cfg.tab_stop = 4;
+	pool = str_pool_create();
+	buf = NULL;
+	buf_size = 0U;
+}
+
+TEARDOWN()
+{
+	str_pool_free(pool);
+	free(buf);
+}
+
+TEST(plain_line_is_copied_as_is)
+{
+	char *const item = make_menu_item(pool, "line", &buf, &buf_size);
+	assert_string_equal("line", item);
+	assert_true(buf == NULL);
+	str_pool_release(item);
+}
+
+TEST(tabulation_is_expanded)
+{
+	char *const item = make_menu_item(pool, "a\tb", &buf, &buf_size);
+	assert_string_equal("a   b", item);
+	str_pool_release(item);
+}
+
+TEST(line_is_cut_at_end_of_line)
+{
+	char *item;
+
+	item = make_menu_item(pool, "first\nsecond", &buf, &buf_size);
+	assert_string_equal("first", item);
+	str_pool_release(item);
+
+	item = make_menu_item(pool, "a\tb\rc\td", &buf, &buf_size);
+	assert_string_equal("a   b", item);
+	str_pool_release(item);
+}
+
+TEST(buffer_fits_text_after_end_of_line)
+{
+	char line[1024];
+	char *item;
+
+	memset(line, 'x', sizeof(line) - 1U);
+	line[sizeof(line) - 1U] = '\0';
+	line[0] = '\t';
+	line[1] = '\r';
+
+	item = make_menu_item(pool, line, &buf, &buf_size);
+	assert_string_equal("    ", item);
+	assert_true(buf_size >= sizeof(line));
+	str_pool_release(item);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
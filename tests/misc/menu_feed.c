@@ -0,0 +1,45 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/menus/menus.h"
+#include "../../src/ui/ui.h"
+#include "../../src/status.h"
+
+static menu_info m;
+
+SETUP()
+{
+	cfg.shell = strdup("sh");
+	curr_stats.load_stage = 0;
+	init_menu_info(&m, strdup("title"), strdup("empty"));
+}
+
+TEARDOWN()
+{
+	free(cfg.shell);
+	cfg.shell = NULL;
+}
+
+TEST(menu_is_not_loading_by_default)
+{
+	assert_false(menu_is_loading(&m));
+	reset_popup_menu(&m);
+}
+
+TEST(empty_output_frees_menu)
+{
+	assert_true(capture_output_to_menu(&lwin, "true", 0, &m));
+	assert_false(menu_is_loading(&m));
+}
+
+TEST(output_is_waited_for_if_menu_cant_be_displayed)
+{
+	assert_true(capture_output_to_menu(&lwin, "sleep 0.1", 0, &m));
+	assert_false(menu_is_loading(&m));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
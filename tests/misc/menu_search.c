@@ -0,0 +1,96 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/menus/menus.h"
+#include "../../src/modes/menu.h"
+#include "../../src/utils/string_array.h"
+
+static void search(const char regexp[]);
+
+static menu_info m;
+
+SETUP()
+{
+	cfg.ignore_case = 0;
+	cfg.smart_case = 0;
+
+	m.len = 0;
+	m.items = NULL;
+	m.len = add_to_string_array(&m.items, m.len, 1, "abc");
+	m.len = add_to_string_array(&m.items, m.len, 1, "xABCx");
+	m.len = add_to_string_array(&m.items, m.len, 1, "abd");
+	m.len = add_to_string_array(&m.items, m.len, 1, "ÄABC");
+	m.matches = NULL;
+	m.matching_entries = 0;
+	m.regexp = NULL;
+}
+
+TEARDOWN()
+{
+	free_string_array(m.items, m.len);
+	free(m.matches);
+	free(m.regexp);
+}
+
+TEST(literal_pattern_is_matched_as_substring)
+{
+	search("ab");
+	assert_int_equal(2, m.matching_entries);
+	assert_true(m.matches[0]);
+	assert_true(m.matches[2]);
+}
+
+TEST(literal_pattern_ignores_case_of_ascii_and_non_ascii_items)
+{
+	cfg.ignore_case = 1;
+
+	search("abc");
+	assert_int_equal(3, m.matching_entries);
+	assert_true(m.matches[0]);
+	assert_true(m.matches[1]);
+	assert_true(m.matches[3]);
+}
+
+TEST(extended_literal_pattern_checks_only_previous_matches)
+{
+	search("ab");
+	assert_int_equal(2, m.matching_entries);
+
+	/* Item that didn't match the first pattern isn't checked again. */
+	free(m.items[1]);
+	m.items[1] = strdup("abc");
+
+	search("abc");
+	assert_int_equal(1, m.matching_entries);
+	assert_true(m.matches[0]);
+	assert_false(m.matches[1]);
+	assert_false(m.matches[2]);
+}
+
+TEST(regexp_pattern_checks_all_items)
+{
+	search("ab");
+	assert_int_equal(2, m.matching_entries);
+
+	free(m.items[1]);
+	m.items[1] = strdup("abc");
+
+	search("ab.");
+	assert_int_equal(3, m.matching_entries);
+	assert_true(m.matches[1]);
+}
+
+static void
+search(const char regexp[])
+{
+	char *const prev = m.regexp;
+	m.regexp = strdup(regexp);
+	assert_success(search_menu(&m, 0, prev));
+	free(prev);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -125,5 +125,15 @@ TEST(set_sets_local_and_global_values)
 	assert_int_equal(2, lwin.num_width);
 }
 
+TEST(dirloadthreads_is_limited_from_above)
+{
+	assert_success(exec_commands("set dirloadthreads=8", &lwin, CIT_COMMAND));
+	assert_int_equal(8, cfg.dir_load_threads);
+
+	(void)exec_commands("set dirloadthreads=1000", &lwin, CIT_COMMAND);
+	assert_int_equal(64, cfg.dir_load_threads);
+	assert_string_equal("64", get_option_value("dirloadthreads", OPT_GLOBAL));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,158 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() rmdir() symlink() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+/* Number of files to create, should be enough to give work to several
+ * threads. */
+#define NFILES 1000
+
+static void create_file(const char name[], const char contents[]);
+static void cleanup_view(FileView *view);
+
+static FileView *const view = &lwin;
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	cfg.slow_fs_list = strdup("");
+	cfg.dir_load_threads = 4;
+}
+
+TEARDOWN()
+{
+	cfg.dir_load_threads = 1;
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+
+	cleanup_view(view);
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+}
+
+TEST(all_files_are_loaded_by_several_threads)
+{
+	int i;
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d", i);
+		create_file(name, (i%2 == 0) ? "" : "x");
+	}
+
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES, view->list_rows);
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d", i);
+
+		assert_string_equal(name, view->dir_entry[i].name);
+		assert_int_equal(FT_REG, view->dir_entry[i].type);
+		assert_true(view->dir_entry[i].size == (uintmax_t)(i%2));
+
+		assert_success(unlink(name));
+	}
+}
+
+TEST(symbolic_links_get_mode_of_target)
+{
+	assert_success(os_mkdir("dir", 0700));
+	assert_success(symlink("dir", "link"));
+
+	populate_dir_list(view, 0);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_string_equal("link", view->dir_entry[1].name);
+	assert_int_equal(FT_LINK, view->dir_entry[1].type);
+	assert_true(S_ISDIR(view->dir_entry[1].mode));
+
+	assert_success(unlink("link"));
+	assert_success(rmdir("dir"));
+}
+
+TEST(unfilled_entries_are_filled_on_request)
+{
+	dir_entry_t *entry;
+
+	create_file("file", "contents");
+	populate_dir_list(view, 0);
+	assert_int_equal(1, view->list_rows);
+
+	/* This is what remains of an entry after cancellation. */
+	entry = &view->dir_entry[0];
+	entry->size = 0U;
+	entry->mode = 0;
+	entry->unfilled = 1;
+
+	flist_fill_entry(entry);
+	assert_false(entry->unfilled);
+	assert_int_equal(FT_REG, entry->type);
+	assert_true(entry->size == 8U);
+	assert_true(S_ISREG(entry->mode));
+
+	/* Filled entries aren't queried again. */
+	entry->size = 0U;
+	flist_fill_entry(entry);
+	assert_true(entry->size == 0U);
+
+	assert_success(unlink("file"));
+}
+
+static void
+create_file(const char name[], const char contents[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+static void
+cleanup_view(FileView *view)
+{
+	int i;
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free_dir_entry(view, &view->dir_entry[i]);
+	}
+	free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,166 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fgetc() fopen() remove() */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memcmp() strcpy() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/quickview.h"
+
+/* Matches number of outputs kept by quickview.c. */
+#define CACHE_SIZE 16
+
+/* Viewer that records each of its runs in a file. */
+#define COUNTING_VIEWER "echo >> " SANDBOX_PATH "/runs; echo"
+/* Viewer that takes its time and records that it has finished. */
+#define SLOW_VIEWER "sleep 0.5; echo >> " SANDBOX_PATH "/runs; echo"
+
+static int get_output(const char path[], const char viewer[],
+		const char **output, size_t *len);
+static int count_runs(void);
+
+SETUP()
+{
+	cfg.shell = strdup("sh");
+
+	curr_view = &lwin;
+	other_view = &rwin;
+	other_view->window_width = 80;
+
+	strcpy(lwin.curr_dir, "/lwin");
+	lwin.list_rows = 1;
+	lwin.list_pos = 0;
+	lwin.dir_entry = calloc(lwin.list_rows, sizeof(*lwin.dir_entry));
+	lwin.dir_entry[0].name = strdup("file");
+	lwin.dir_entry[0].origin = &lwin.curr_dir[0];
+}
+
+TEARDOWN()
+{
+	drop_previews();
+
+	free(lwin.dir_entry[0].name);
+	free(lwin.dir_entry);
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+
+	free(cfg.shell);
+	cfg.shell = NULL;
+
+	(void)remove(SANDBOX_PATH "/runs");
+}
+
+TEST(output_of_viewer_is_cached)
+{
+	const char *output;
+	size_t len;
+
+	assert_success(get_output("a", COUNTING_VIEWER, &output, &len));
+	assert_int_equal(5, len);
+	assert_success(memcmp(output, "file\n", len));
+	assert_int_equal(1, count_runs());
+
+	assert_success(get_output("a", COUNTING_VIEWER, &output, &len));
+	assert_int_equal(5, len);
+	assert_success(memcmp(output, "file\n", len));
+	assert_int_equal(1, count_runs());
+}
+
+TEST(least_recently_used_output_is_evicted)
+{
+	const char *output;
+	size_t len;
+	char path[16];
+	int i;
+
+	for(i = 0; i < CACHE_SIZE; ++i)
+	{
+		snprintf(path, sizeof(path), "%d", i);
+		assert_success(get_output(path, COUNTING_VIEWER, &output, &len));
+	}
+	assert_int_equal(CACHE_SIZE, count_runs());
+
+	/* Makes the first output the most recently used one. */
+	assert_success(get_output("0", COUNTING_VIEWER, &output, &len));
+	assert_int_equal(CACHE_SIZE, count_runs());
+
+	assert_success(get_output("new", COUNTING_VIEWER, &output, &len));
+	assert_int_equal(CACHE_SIZE + 1, count_runs());
+
+	assert_success(get_output("0", COUNTING_VIEWER, &output, &len));
+	assert_int_equal(CACHE_SIZE + 1, count_runs());
+
+	assert_success(get_output("1", COUNTING_VIEWER, &output, &len));
+	assert_int_equal(CACHE_SIZE + 2, count_runs());
+}
+
+TEST(running_viewer_is_superseded_by_another_one)
+{
+	const char *output;
+	size_t len;
+	int pending;
+
+	assert_failure(get_viewer_output("slow", SLOW_VIEWER, &output, &len,
+				&pending));
+	assert_true(pending);
+
+	assert_success(get_output("fast", "echo", &output, &len));
+	assert_int_equal(5, len);
+	assert_success(memcmp(output, "file\n", len));
+
+	/* Superseded viewer is killed before it's done. */
+	usleep(700000);
+	assert_false(path_exists(SANDBOX_PATH "/runs", DEREF));
+
+	/* And its output isn't cached. */
+	assert_failure(get_viewer_output("slow", SLOW_VIEWER, &output, &len,
+				&pending));
+	assert_true(pending);
+}
+
+/* Retrieves output of the viewer waiting for it to finish.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+get_output(const char path[], const char viewer[], const char **output,
+		size_t *len)
+{
+	int pending;
+	while(get_viewer_output(path, viewer, output, len, &pending) != 0)
+	{
+		if(!pending)
+		{
+			return 1;
+		}
+		usleep(10000);
+	}
+	return 0;
+}
+
+/* Counts how many times viewers were run.  Returns the number. */
+static int
+count_runs(void)
+{
+	int c;
+	int count = 0;
+	FILE *const fp = fopen(SANDBOX_PATH "/runs", "r");
+	if(fp == NULL)
+	{
+		return 0;
+	}
+
+	while((c = fgetc(fp)) != EOF)
+	{
+		count += (c == '\n');
+	}
+	fclose(fp);
+	return count;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -316,5 +316,76 @@ TEST(extensions_of_dot_files_are_sorted_correctly)
 	assert_string_equal(".tmux.conf", lwin.dir_entry[2].name);
 }
 
+TEST(secondary_keys_are_respected)
+{
+	free_view(&lwin);
+
+	lwin.list_rows = 4;
+	lwin.dir_entry = calloc(lwin.list_rows, sizeof(*lwin.dir_entry));
+	lwin.dir_entry[0].name = strdup("b");
+	lwin.dir_entry[0].type = FT_REG;
+	lwin.dir_entry[0].size = 1;
+	lwin.dir_entry[1].name = strdup("a");
+	lwin.dir_entry[1].type = FT_REG;
+	lwin.dir_entry[1].size = 2;
+	lwin.dir_entry[2].name = strdup("c");
+	lwin.dir_entry[2].type = FT_REG;
+	lwin.dir_entry[2].size = 1;
+	lwin.dir_entry[3].name = strdup("d");
+	lwin.dir_entry[3].type = FT_REG;
+	lwin.dir_entry[3].size = 2;
+
+	lwin.sort[0] = SK_BY_SIZE;
+	lwin.sort[1] = -SK_BY_NAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view(&lwin);
+
+	assert_string_equal("c", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+	assert_string_equal("d", lwin.dir_entry[2].name);
+	assert_string_equal("a", lwin.dir_entry[3].name);
+}
+
+TEST(sorting_without_prepared_data_gives_same_result)
+{
+	int i;
+	const char *const names[] = { "B", "a", "c", "A", "b", "C" };
+	const int sizes[] = { 1, 2, 1, 2, 2, 1 };
+
+	free_view(&lwin);
+
+	lwin.list_rows = 6;
+	lwin.dir_entry = calloc(lwin.list_rows, sizeof(*lwin.dir_entry));
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		lwin.dir_entry[i].name = strdup(names[i]);
+		lwin.dir_entry[i].type = FT_REG;
+		lwin.dir_entry[i].size = sizes[i];
+	}
+
+	lwin.sort[0] = -SK_BY_SIZE;
+	lwin.sort[1] = SK_BY_INAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view_entries(&lwin, 0);
+
+	assert_string_equal("A", lwin.dir_entry[0].name);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+	assert_string_equal("b", lwin.dir_entry[2].name);
+	assert_string_equal("B", lwin.dir_entry[3].name);
+	assert_string_equal("C", lwin.dir_entry[4].name);
+	assert_string_equal("c", lwin.dir_entry[5].name);
+
+	sort_view_entries(&lwin, 1);
+
+	assert_string_equal("A", lwin.dir_entry[0].name);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+	assert_string_equal("b", lwin.dir_entry[2].name);
+	assert_string_equal("B", lwin.dir_entry[3].name);
+	assert_string_equal("C", lwin.dir_entry[4].name);
+	assert_string_equal("c", lwin.dir_entry[5].name);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
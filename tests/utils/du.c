@@ -0,0 +1,159 @@
+#include <stic.h>
+
+#include <unistd.h> /* link() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <string.h> /* strcat() strcmp() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/du.h"
+
+#include "utils.h"
+
+#define NDIRS 50
+
+static void make_file_path(char buf[], size_t len, int i);
+static void create_file(const char path[], const char contents[]);
+static int lookup(const char path[], uint64_t *size, void *arg);
+static void publish(const du_dir_t dirs[], size_t count, void *arg);
+
+static int npublished;
+static uint64_t published_size;
+static size_t published_nsubdirs;
+
+SETUP()
+{
+	int i;
+
+	npublished = 0;
+	published_size = 0U;
+	published_nsubdirs = 0U;
+
+	create_test_dirs(NDIRS);
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		make_file_path(path, sizeof(path), i);
+		create_file(path, "0123456789");
+	}
+}
+
+TEARDOWN()
+{
+	int i;
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		make_file_path(path, sizeof(path), i);
+		assert_success(unlink(path));
+	}
+	remove_test_dirs(NDIRS);
+}
+
+TEST(sizes_of_files_are_summed_up)
+{
+	const du_params_t params = { .nthreads = 1 };
+	assert_ulong_equal(NDIRS*10U, du_calculate(SANDBOX_PATH, &params));
+}
+
+TEST(several_threads_yield_same_result)
+{
+	const du_params_t params = { .nthreads = 4 };
+	assert_ulong_equal(NDIRS*10U, du_calculate(SANDBOX_PATH "/", &params));
+}
+
+TEST(default_number_of_threads_yields_same_result)
+{
+	const du_params_t params = { .nthreads = 0 };
+	assert_ulong_equal(NDIRS*10U, du_calculate(SANDBOX_PATH, &params));
+}
+
+TEST(every_directory_is_published)
+{
+	const du_params_t params = { .nthreads = 3, .publish = &publish };
+	assert_ulong_equal(NDIRS*10U, du_calculate(SANDBOX_PATH, &params));
+	assert_int_equal(NDIRS + 1, npublished);
+	assert_ulong_equal(NDIRS*10U, published_size);
+	assert_int_equal(NDIRS/10, published_nsubdirs);
+}
+
+TEST(known_sizes_are_not_recalculated)
+{
+	const du_params_t params = { .nthreads = 2, .lookup = &lookup };
+	assert_ulong_equal(100U + (NDIRS - 10)*10U,
+			du_calculate(SANDBOX_PATH, &params));
+}
+
+TEST(hard_links_are_counted_once)
+{
+	const du_params_t params = { .nthreads = 2 };
+	char src[PATH_MAX], dst[PATH_MAX];
+
+	make_file_path(src, sizeof(src), 0);
+	make_test_dir_path(dst, sizeof(dst), 15);
+	strcat(dst, "/link");
+	assert_success(link(src, dst));
+
+	assert_ulong_equal(NDIRS*10U, du_calculate(SANDBOX_PATH, &params));
+
+	assert_success(unlink(dst));
+}
+
+TEST(allocated_size_is_at_least_apparent_one)
+{
+	const du_params_t params = { .nthreads = 2, .allocated = 1 };
+	assert_true(du_calculate(SANDBOX_PATH, &params) >= NDIRS*10U);
+}
+
+/* Makes path to a file inside i-th directory. */
+static void
+make_file_path(char buf[], size_t len, int i)
+{
+	char dir[PATH_MAX];
+	make_test_dir_path(dir, sizeof(dir), i);
+	snprintf(buf, len, "%s/file", dir);
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+/* Pretends that size of the first top-level directory is known. */
+static int
+lookup(const char path[], uint64_t *size, void *arg)
+{
+	if(strcmp(path, SANDBOX_PATH "/0") == 0)
+	{
+		*size = 100U;
+		return 1;
+	}
+	return 0;
+}
+
+static void
+publish(const du_dir_t dirs[], size_t count, void *arg)
+{
+	size_t i;
+	for(i = 0U; i < count; ++i)
+	{
+		++npublished;
+		if(strcmp(dirs[i].path, SANDBOX_PATH) == 0)
+		{
+			published_size = dirs[i].size;
+			published_nsubdirs = dirs[i].nsubdirs;
+		}
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,136 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
+#include <string.h> /* strcpy() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/filemon.h"
+
+#define DIR_PATH SANDBOX_PATH "/dir"
+#define FILE_PATH DIR_PATH "/file"
+
+static void file_changed(const char name[], void *arg);
+static void write_file(const char path[], const char contents[]);
+
+static filemon_t mon;
+static int nchanged;
+static char last_changed[64];
+
+SETUP()
+{
+	assert_success(os_mkdir(DIR_PATH, 0700));
+	write_file(FILE_PATH, "");
+	assert_success(filemon_watch_dir(DIR_PATH, &mon));
+	nchanged = 0;
+}
+
+TEARDOWN()
+{
+	filemon_reset(&mon);
+	(void)unlink(FILE_PATH);
+	(void)unlink(DIR_PATH "/new");
+	assert_success(rmdir(DIR_PATH));
+}
+
+TEST(no_changes_are_reported_for_untouched_dir)
+{
+	assert_int_equal(0, filemon_check(&mon, DIR_PATH, &file_changed, NULL));
+	assert_int_equal(0, nchanged);
+}
+
+TEST(new_file_changes_list)
+{
+	write_file(DIR_PATH "/new", "");
+	assert_true(filemon_check(&mon, DIR_PATH, &file_changed, NULL) > 0);
+}
+
+TEST(removed_file_changes_list)
+{
+	assert_success(unlink(FILE_PATH));
+	assert_true(filemon_check(&mon, DIR_PATH, &file_changed, NULL) > 0);
+}
+
+TEST(removal_of_dir_is_detected)
+{
+	assert_success(unlink(FILE_PATH));
+	assert_success(rmdir(DIR_PATH));
+	assert_true(filemon_check(&mon, DIR_PATH, &file_changed, NULL) != 0);
+	assert_success(os_mkdir(DIR_PATH, 0700));
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+TEST(modified_file_is_reported_once)
+{
+	write_file(FILE_PATH, "a");
+	write_file(FILE_PATH, "ab");
+
+	assert_int_equal(0, filemon_check(&mon, DIR_PATH, &file_changed, NULL));
+	assert_int_equal(1, nchanged);
+	assert_string_equal("file", last_changed);
+
+	assert_int_equal(0, filemon_check(&mon, DIR_PATH, &file_changed, NULL));
+	assert_int_equal(1, nchanged);
+}
+
+TEST(watching_same_dir_keeps_notifications)
+{
+	assert_true(filemon_tracks_files(&mon, DIR_PATH));
+
+	write_file(FILE_PATH, "a");
+	assert_success(filemon_watch_dir(DIR_PATH, &mon));
+
+	assert_true(filemon_tracks_files(&mon, DIR_PATH));
+	assert_int_equal(0, filemon_check(&mon, DIR_PATH, &file_changed, NULL));
+	assert_int_equal(1, nchanged);
+}
+
+TEST(watched_file_reports_its_modifications)
+{
+	filemon_t file_mon = { .type = FMT_UNINITIALIZED };
+
+	assert_success(filemon_watch_file(FILE_PATH, &file_mon));
+	assert_false(filemon_file_changed(&file_mon));
+
+	write_file(FILE_PATH, "a");
+	assert_true(filemon_file_changed(&file_mon));
+	assert_false(filemon_file_changed(&file_mon));
+
+	filemon_reset(&file_mon);
+}
+
+TEST(removed_dir_is_not_tracked)
+{
+	assert_success(unlink(FILE_PATH));
+	assert_success(rmdir(DIR_PATH));
+	assert_success(os_mkdir(DIR_PATH, 0700));
+
+	(void)filemon_check(&mon, DIR_PATH, &file_changed, NULL);
+	assert_false(filemon_tracks_files(&mon, DIR_PATH));
+}
+
+#endif
+
+static void
+file_changed(const char name[], void *arg)
+{
+	++nchanged;
+	strcpy(last_changed, name);
+}
+
+static void
+write_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
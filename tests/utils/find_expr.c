@@ -0,0 +1,177 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/find_expr.h"
+#include "../../src/utils/string_array.h"
+
+#define FILE_PATH SANDBOX_PATH "/file.txt"
+
+static find_expr_t * parse(const char args[]);
+static void write_file(const char path[], const char contents[]);
+
+static char **roots;
+static int nroots;
+
+TEARDOWN()
+{
+	free_string_array(roots, nroots);
+	roots = NULL;
+	nroots = 0;
+	(void)unlink(FILE_PATH);
+}
+
+TEST(leading_arguments_are_roots)
+{
+	find_expr_t *const expr = parse("dir1 'dir 2' dir\\ 3 -name x");
+	assert_int_equal(3, nroots);
+	assert_string_equal("dir1", roots[0]);
+	assert_string_equal("dir 2", roots[1]);
+	assert_string_equal("dir 3", roots[2]);
+	find_expr_free(expr);
+}
+
+TEST(unsupported_arguments_are_reported)
+{
+	char *error;
+	assert_null(find_expr_parse("-exec rm {} ;", &roots, &nroots, &error));
+	assert_string_equal("Unsupported find argument: -exec", error);
+	free(error);
+
+	assert_null(find_expr_parse("-type", &roots, &nroots, &error));
+	assert_string_equal("Missing argument of -type", error);
+	free(error);
+
+	assert_null(find_expr_parse("-size 1x", &roots, &nroots, &error));
+	assert_string_equal("Wrong argument of -size: 1x", error);
+	free(error);
+
+	assert_null(find_expr_parse("-name 'x", &roots, &nroots, &error));
+	assert_string_equal("Unmatched quote", error);
+	free(error);
+}
+
+TEST(name_is_matched_against_last_component)
+{
+	find_expr_t *const expr = parse("-name '*.c'");
+	assert_true(find_expr_matches(expr, "dir.c/file.c", FWT_FILE));
+	assert_false(find_expr_matches(expr, "dir.c/file.h", FWT_FILE));
+	assert_false(find_expr_matches(expr, "dir/FILE.C", FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(iname_ignores_case)
+{
+	find_expr_t *const expr = parse("-iname '*.c'");
+	assert_true(find_expr_matches(expr, "dir/FILE.C", FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(name_wildcards_match_leading_dot)
+{
+	find_expr_t *const expr = parse("-name '*rc'");
+	assert_true(find_expr_matches(expr, "dir/.vimrc", FWT_FILE));
+	assert_true(find_expr_matches(expr, "dir/vifmrc", FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(comma_in_name_is_not_special)
+{
+	find_expr_t *const expr = parse("-name 'a,b'");
+	assert_true(find_expr_matches(expr, "dir/a,b", FWT_FILE));
+	assert_false(find_expr_matches(expr, "dir/a", FWT_FILE));
+	assert_false(find_expr_matches(expr, "dir/b", FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(regex_is_matched_against_whole_path)
+{
+	find_expr_t *const expr = parse("-regex '.*/sub/[a-z]+'");
+	assert_true(find_expr_matches(expr, "./sub/file", FWT_FILE));
+	assert_false(find_expr_matches(expr, "./sub/file1", FWT_FILE));
+	assert_false(find_expr_matches(expr, "sub/file", FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(predicates_are_joined_with_and)
+{
+	find_expr_t *const expr = parse("-name 'a*' -a -type d -print");
+	assert_true(find_expr_matches(expr, "./ab", FWT_DIR));
+	assert_false(find_expr_matches(expr, "./ab", FWT_FILE));
+	assert_false(find_expr_matches(expr, "./b", FWT_DIR));
+	assert_false(find_expr_matches(expr, "./ab", FWT_LINK));
+	find_expr_free(expr);
+}
+
+TEST(size_is_rounded_up_to_units)
+{
+	find_expr_t *expr;
+
+	write_file(FILE_PATH, "0123456789");
+
+	expr = parse("-size 10c");
+	assert_true(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+
+	expr = parse("-size 1k");
+	assert_true(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+
+	expr = parse("-size -1k");
+	assert_false(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+
+	expr = parse("-size +9c");
+	assert_true(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(mtime_is_compared_in_days)
+{
+	find_expr_t *expr;
+
+	write_file(FILE_PATH, "");
+
+	expr = parse("-mtime 0");
+	assert_true(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+
+	expr = parse("-mtime +0");
+	assert_false(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+}
+
+TEST(missing_files_do_not_match_size_and_mtime)
+{
+	find_expr_t *const expr = parse("-size -100");
+	assert_false(find_expr_matches(expr, FILE_PATH, FWT_FILE));
+	find_expr_free(expr);
+}
+
+static find_expr_t *
+parse(const char args[])
+{
+	char *error;
+	find_expr_t *const expr = find_expr_parse(args, &roots, &nroots, &error);
+	assert_non_null(expr);
+	assert_null(error);
+	return expr;
+}
+
+static void
+write_file(const char path[], const char contents[])
+{
+	FILE *const fp = fopen(path, "w");
+	assert_non_null(fp);
+	if(fp != NULL)
+	{
+		fputs(contents, fp);
+		fclose(fp);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,180 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() unlink() usleep() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <stdlib.h> /* qsort() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/fswalk.h"
+#include "../../src/utils/string_array.h"
+
+#define ROOT SANDBOX_PATH "/root"
+
+static void visit(fswalk_t *walk, const char path[], FswalkType type,
+		void *arg);
+static void slow_visit(fswalk_t *walk, const char path[], FswalkType type,
+		void *arg);
+static void result(const char result[], void *arg);
+static int cancel(void *arg);
+static void walk(int flags);
+static int sorter(const void *first, const void *second);
+static void write_file(const char path[], const char contents[]);
+
+static char **results;
+static int nresults;
+
+SETUP()
+{
+	assert_success(os_mkdir(ROOT, 0700));
+	assert_success(os_mkdir(ROOT "/dir", 0700));
+	assert_success(os_mkdir(ROOT "/dir/build", 0700));
+	assert_success(os_mkdir(ROOT "/.git", 0700));
+	write_file(ROOT "/a", "");
+	write_file(ROOT "/a.o", "");
+	write_file(ROOT "/dir/b", "");
+	write_file(ROOT "/dir/build/c", "");
+	write_file(ROOT "/.git/config", "");
+}
+
+TEARDOWN()
+{
+	free_string_array(results, nresults);
+	results = NULL;
+	nresults = 0;
+
+	(void)unlink(ROOT "/.gitignore");
+	(void)unlink(ROOT "/dir/.gitignore");
+	assert_success(unlink(ROOT "/.git/config"));
+	assert_success(unlink(ROOT "/dir/build/c"));
+	assert_success(unlink(ROOT "/dir/b"));
+	assert_success(unlink(ROOT "/a.o"));
+	assert_success(unlink(ROOT "/a"));
+	assert_success(rmdir(ROOT "/.git"));
+	assert_success(rmdir(ROOT "/dir/build"));
+	assert_success(rmdir(ROOT "/dir"));
+	assert_success(rmdir(ROOT));
+}
+
+TEST(all_files_and_directories_are_visited)
+{
+	walk(0);
+
+	assert_int_equal(9, nresults);
+	assert_string_equal(ROOT "/", results[0]);
+	assert_string_equal(ROOT "/.git/", results[1]);
+	assert_string_equal(ROOT "/.git/config", results[2]);
+	assert_string_equal(ROOT "/a", results[3]);
+	assert_string_equal(ROOT "/a.o", results[4]);
+	assert_string_equal(ROOT "/dir/", results[5]);
+	assert_string_equal(ROOT "/dir/b", results[6]);
+	assert_string_equal(ROOT "/dir/build/", results[7]);
+	assert_string_equal(ROOT "/dir/build/c", results[8]);
+}
+
+TEST(vcs_directories_and_ignored_files_are_skipped)
+{
+	write_file(ROOT "/.gitignore", "# comment\n*.o\n/build/\n");
+	write_file(ROOT "/dir/.gitignore", "build/\n");
+
+	walk(FSWALK_SKIP_IGNORED);
+
+	assert_int_equal(6, nresults);
+	assert_string_equal(ROOT "/", results[0]);
+	assert_string_equal(ROOT "/.gitignore", results[1]);
+	assert_string_equal(ROOT "/a", results[2]);
+	assert_string_equal(ROOT "/dir/", results[3]);
+	assert_string_equal(ROOT "/dir/.gitignore", results[4]);
+	assert_string_equal(ROOT "/dir/b", results[5]);
+}
+
+TEST(anchored_rule_applies_only_relative_to_its_directory)
+{
+	write_file(ROOT "/.gitignore", "/build/\n");
+
+	walk(FSWALK_SKIP_IGNORED);
+
+	assert_int_equal(8, nresults);
+	assert_string_equal(ROOT "/dir/build/", results[6]);
+	assert_string_equal(ROOT "/dir/build/c", results[7]);
+}
+
+TEST(traversal_can_be_cancelled)
+{
+	char *roots[] = { ROOT };
+	int ncancels = 0;
+
+	assert_failure(fswalk_run(roots, 1, 0, &slow_visit, &result, &cancel,
+				&ncancels));
+	assert_int_equal(1, ncancels);
+	assert_true(nresults < 9);
+}
+
+TEST(missing_roots_are_skipped)
+{
+	char *roots[] = { SANDBOX_PATH "/no-such-file", ROOT "/a" };
+
+	assert_success(fswalk_run(roots, 2, 0, &visit, &result, NULL, NULL));
+	assert_int_equal(1, nresults);
+	assert_string_equal(ROOT "/a", results[0]);
+}
+
+static void
+walk(int flags)
+{
+	char *roots[] = { ROOT };
+	assert_success(fswalk_run(roots, 1, flags, &visit, &result, NULL, NULL));
+	qsort(results, nresults, sizeof(*results), &sorter);
+}
+
+static void
+visit(fswalk_t *walk, const char path[], FswalkType type, void *arg)
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%s%s", path,
+			(type == FWT_DIR) ? "/" : (type == FWT_LINK) ? "@" : "");
+	fswalk_report(walk, buf);
+}
+
+static void
+slow_visit(fswalk_t *walk, const char path[], FswalkType type, void *arg)
+{
+	usleep(200000);
+	visit(walk, path, type, arg);
+}
+
+static void
+result(const char result[], void *arg)
+{
+	nresults = add_to_string_array(&results, nresults, 1, result);
+}
+
+static int
+cancel(void *arg)
+{
+	int *const ncancels = arg;
+	++*ncancels;
+	return 1;
+}
+
+static int
+sorter(const void *first, const void *second)
+{
+	return strcmp(*(char *const *)first, *(char *const *)second);
+}
+
+static void
+write_file(const char path[], const char contents[])
+{
+	FILE *const fp = fopen(path, "w");
+	assert_non_null(fp);
+	if(fp != NULL)
+	{
+		fputs(contents, fp);
+		fclose(fp);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,184 @@
+#include <stic.h>
+
+#include <regex.h> /* REG_EXTENDED */
+#include <unistd.h> /* unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() fwrite() snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() memset() */
+
+#include "../../src/utils/grep.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+
+#define FILE_PATH SANDBOX_PATH "/file"
+
+static int search(const char pattern[], int invert, const char contents[]);
+static void match(const char path[], int line_num, const char line[],
+		void *arg);
+static void write_file(const char path[], const char contents[]);
+
+static char **matches;
+static int nmatches;
+
+TEARDOWN()
+{
+	free_string_array(matches, nmatches);
+	matches = NULL;
+	nmatches = 0;
+	(void)unlink(FILE_PATH);
+}
+
+TEST(wrong_pattern_is_reported)
+{
+	char *error;
+	assert_null(grep_alloc("(", REG_EXTENDED, 0, &error));
+	assert_non_null(error);
+	free(error);
+}
+
+TEST(literal_is_found)
+{
+	assert_success(search("needle", 0, "hay\nneedle in\nhay\nno\nneedle\n"));
+	assert_int_equal(2, nmatches);
+	assert_string_equal("2:needle in", matches[0]);
+	assert_string_equal("5:needle", matches[1]);
+}
+
+TEST(regular_expression_with_literal_prefix_is_matched)
+{
+	assert_success(search("ab+c$", 0, "abc\nabbbc\nab\nabcd\nxabbc"));
+	assert_int_equal(3, nmatches);
+	assert_string_equal("1:abc", matches[0]);
+	assert_string_equal("2:abbbc", matches[1]);
+	assert_string_equal("5:xabbc", matches[2]);
+}
+
+TEST(optional_character_is_not_part_of_literal)
+{
+	assert_success(search("^abc?", 0, "ab\nxabc\nabc\n"));
+	assert_int_equal(2, nmatches);
+	assert_string_equal("1:ab", matches[0]);
+	assert_string_equal("3:abc", matches[1]);
+}
+
+TEST(regular_expression_without_literal_is_matched)
+{
+	assert_success(search("[0-9]+", 0, "a1\nb\n22\n"));
+	assert_int_equal(2, nmatches);
+	assert_string_equal("1:a1", matches[0]);
+	assert_string_equal("3:22", matches[1]);
+}
+
+TEST(inverted_search_reports_lines_that_do_not_match)
+{
+	assert_success(search("x", 1, "x\ny\nzx\nz"));
+	assert_int_equal(2, nmatches);
+	assert_string_equal("2:y", matches[0]);
+	assert_string_equal("4:z", matches[1]);
+}
+
+TEST(dos_line_endings_are_not_reported)
+{
+	assert_success(search("b$", 0, "a\r\nb\r\n"));
+	assert_int_equal(1, nmatches);
+	assert_string_equal("2:b", matches[0]);
+}
+
+TEST(binary_files_are_skipped)
+{
+	grep_t *grep;
+	char *error;
+
+	FILE *const fp = fopen(FILE_PATH, "wb");
+	assert_non_null(fp);
+	fwrite("text\0text\n", 1, 10, fp);
+	fclose(fp);
+
+	grep = grep_alloc("text", REG_EXTENDED, 0, &error);
+	assert_non_null(grep);
+	assert_failure(grep_file(grep, FILE_PATH, &match, NULL));
+	assert_int_equal(0, nmatches);
+	grep_free(grep);
+}
+
+TEST(empty_file_has_no_matches)
+{
+	assert_success(search("", 0, ""));
+	assert_int_equal(0, nmatches);
+}
+
+TEST(lines_are_numbered_across_chunks)
+{
+	int i;
+	char *contents = NULL;
+	size_t len = 0U;
+
+	/* Every 10000-th line matches. */
+	for(i = 1; i <= 50000; ++i)
+	{
+		(void)strappend(&contents, &len, (i%10000 == 0) ? "needle\n" : "hay\n");
+	}
+
+	assert_success(search("needle", 0, contents));
+	assert_int_equal(5, nmatches);
+	assert_string_equal("10000:needle", matches[0]);
+	assert_string_equal("50000:needle", matches[4]);
+
+	free(contents);
+}
+
+TEST(lines_longer_than_chunk_are_matched)
+{
+	char *contents = malloc(512*1024);
+	memset(contents, 'a', 512*1024 - 1);
+	contents[512*1024 - 1] = '\0';
+	memcpy(contents, "x\ny\n", 4);
+	memcpy(contents + 512*1024 - 7, "needle", 6);
+
+	assert_success(search("needle", 0, contents));
+	assert_int_equal(1, nmatches);
+	assert_true(starts_with_lit(matches[0], "3:aaa"));
+
+	free(contents);
+}
+
+static int
+search(const char pattern[], int invert, const char contents[])
+{
+	int result;
+	char *error;
+	grep_t *grep;
+
+	write_file(FILE_PATH, contents);
+
+	grep = grep_alloc(pattern, REG_EXTENDED, invert, &error);
+	assert_non_null(grep);
+	result = grep_file(grep, FILE_PATH, &match, NULL);
+	grep_free(grep);
+	return result;
+}
+
+static void
+match(const char path[], int line_num, const char line[], void *arg)
+{
+	char buf[128];
+	assert_string_equal(FILE_PATH, path);
+	snprintf(buf, sizeof(buf), "%d:%s", line_num, line);
+	nmatches = add_to_string_array(&matches, nmatches, 1, buf);
+}
+
+static void
+write_file(const char path[], const char contents[])
+{
+	FILE *const fp = fopen(path, "wb");
+	assert_non_null(fp);
+	if(fp != NULL)
+	{
+		fputs(contents, fp);
+		fclose(fp);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,288 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* SIZE_MAX */
+#include <stdio.h> /* FILE fclose() fopen() fprintf() fputc() fputs() */
+#include <string.h> /* strlen() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/line_index.h"
+#include "../../src/utils/macros.h"
+#include "../../src/utils/string_array.h"
+
+#define BIG_FILE SANDBOX_PATH "/big"
+#define LOG_FILE SANDBOX_PATH "/log"
+
+/* Number of lines in the big file, it must be large enough for indexing to be
+ * performed in background. */
+#define BIG_NLINES 100000
+
+static void compare_with_read_file_lines(const char path[]);
+static void write_file(const char path[], const char mode[],
+		const char contents[]);
+static size_t measure(const char text[], size_t len, int last, size_t *width,
+		void *arg);
+
+TEST(lines_are_the_same_as_read_by_read_file_lines)
+{
+	static const char *files[] = {
+		"binary-data", "dos-eof", "dos-line-endings", "two-lines",
+		"very-long-line",
+	};
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(files); ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/read/%s", TEST_DATA_PATH, files[i]);
+		compare_with_read_file_lines(path);
+	}
+}
+
+TEST(empty_file_has_no_lines)
+{
+	int complete;
+	line_index_t *li;
+
+	FILE *const fp = fopen(SANDBOX_PATH "/empty", "w");
+	assert_non_null(fp);
+	fclose(fp);
+
+	li = line_index_from_file(SANDBOX_PATH "/empty", NULL, NULL);
+	assert_non_null(li);
+	assert_int_equal(0, line_index_wait(li, -1));
+	assert_int_equal(0, line_index_count(li, &complete));
+	assert_true(complete);
+	line_index_free(li);
+
+	assert_success(unlink(SANDBOX_PATH "/empty"));
+}
+
+TEST(big_file_is_indexed_in_background)
+{
+	int i;
+	line_index_t *li;
+
+	FILE *const fp = fopen(BIG_FILE, "w");
+	assert_non_null(fp);
+	for(i = 0; i < BIG_NLINES; ++i)
+	{
+		fprintf(fp, "line number %d\n", i);
+	}
+	fclose(fp);
+
+	li = line_index_from_file(BIG_FILE, &measure, NULL);
+	assert_non_null(li);
+
+	assert_true(line_index_wait(li, 10) >= 10);
+	assert_string_equal("line number 9", line_index_get(li, 9, SIZE_MAX));
+
+	assert_int_equal(BIG_NLINES, line_index_wait(li, -1));
+	assert_string_equal("line number 99999",
+			line_index_get(li, BIG_NLINES - 1, SIZE_MAX));
+	assert_int_equal(strlen("line number 99999"),
+			line_index_width(li, BIG_NLINES - 1));
+
+	line_index_free(li);
+	assert_success(unlink(BIG_FILE));
+}
+
+TEST(long_line_is_measured_in_parts)
+{
+	int i;
+	line_index_t *li;
+	int factor = 2;
+
+	FILE *const fp = fopen(BIG_FILE, "w");
+	assert_non_null(fp);
+	for(i = 0; i < 3*BIG_NLINES; ++i)
+	{
+		fputc('x', fp);
+	}
+	fputs("\nshort\n", fp);
+	fclose(fp);
+
+	li = line_index_from_file(BIG_FILE, &measure, NULL);
+	assert_non_null(li);
+
+	assert_int_equal(2, line_index_wait(li, -1));
+	assert_int_equal(3*BIG_NLINES, line_index_width(li, 0));
+	assert_int_equal(5, line_index_width(li, 1));
+
+	line_index_remeasure(li, &factor);
+	assert_int_equal(2, line_index_wait(li, -1));
+	assert_int_equal(2*3*BIG_NLINES, line_index_width(li, 0));
+	assert_int_equal(10, line_index_width(li, 1));
+
+	line_index_free(li);
+	assert_success(unlink(BIG_FILE));
+}
+
+TEST(only_prefix_of_line_is_retrieved)
+{
+	line_index_t *li;
+
+	write_file(LOG_FILE, "w", "0123456789abcdef\n");
+	li = line_index_from_file(LOG_FILE, NULL, NULL);
+	assert_non_null(li);
+
+	assert_int_equal(1, line_index_wait(li, -1));
+	assert_string_equal("0123456789", line_index_get(li, 0, 10U));
+	assert_string_equal("0123456789abcdef", line_index_get(li, 0, SIZE_MAX));
+
+	line_index_free(li);
+	assert_success(unlink(LOG_FILE));
+}
+
+TEST(timed_wait_returns_number_of_lines)
+{
+	int complete;
+	line_index_t *li;
+
+	write_file(LOG_FILE, "w", "a\nb\n");
+	li = line_index_from_file(LOG_FILE, NULL, NULL);
+	assert_non_null(li);
+
+	assert_int_equal(2, line_index_wait_for(li, 10, 10));
+	assert_int_equal(2, line_index_count(li, &complete));
+	assert_true(complete);
+
+	line_index_free(li);
+	assert_success(unlink(LOG_FILE));
+}
+
+TEST(freeing_index_stops_indexing)
+{
+	int i;
+	line_index_t *li;
+
+	FILE *const fp = fopen(BIG_FILE, "w");
+	assert_non_null(fp);
+	for(i = 0; i < BIG_NLINES; ++i)
+	{
+		fputs("line\n", fp);
+	}
+	fclose(fp);
+
+	li = line_index_from_file(BIG_FILE, NULL, NULL);
+	assert_non_null(li);
+	line_index_free(li);
+
+	assert_success(unlink(BIG_FILE));
+}
+
+TEST(stream_is_indexed)
+{
+	line_index_t *li;
+
+	FILE *const fp = fopen(TEST_DATA_PATH "/read/dos-line-endings", "rb");
+	assert_non_null(fp);
+	li = line_index_from_stream(fp, NULL, NULL);
+	fclose(fp);
+
+	assert_non_null(li);
+	assert_int_equal(3, line_index_wait(li, -1));
+	assert_string_equal("first line", line_index_get(li, 0, SIZE_MAX));
+	assert_string_equal("third line", line_index_get(li, 2, SIZE_MAX));
+	line_index_free(li);
+}
+
+TEST(appended_lines_are_picked_up)
+{
+	int first_changed = -1;
+	line_index_t *li;
+
+	write_file(LOG_FILE, "w", "a\nb");
+	li = line_index_from_file(LOG_FILE, NULL, NULL);
+	assert_non_null(li);
+	assert_int_equal(2, line_index_wait(li, -1));
+
+	write_file(LOG_FILE, "a", "c\nd\n");
+	assert_success(line_index_follow(li, LOG_FILE, &first_changed));
+	assert_int_equal(1, first_changed);
+	assert_int_equal(3, line_index_wait(li, -1));
+	assert_string_equal("a", line_index_get(li, 0, SIZE_MAX));
+	assert_string_equal("bc", line_index_get(li, 1, SIZE_MAX));
+	assert_string_equal("d", line_index_get(li, 2, SIZE_MAX));
+
+	assert_success(line_index_follow(li, LOG_FILE, &first_changed));
+	assert_int_equal(3, first_changed);
+
+	line_index_free(li);
+	assert_success(unlink(LOG_FILE));
+}
+
+TEST(truncated_or_replaced_file_is_not_followed)
+{
+	int first_changed;
+	line_index_t *li;
+
+	write_file(LOG_FILE, "w", "a\nb\n");
+	li = line_index_from_file(LOG_FILE, NULL, NULL);
+	assert_non_null(li);
+
+	write_file(LOG_FILE, "w", "a\n");
+	assert_failure(line_index_follow(li, LOG_FILE, &first_changed));
+
+	assert_success(unlink(LOG_FILE));
+	write_file(LOG_FILE, "w", "a\nb\nc\n");
+	assert_failure(line_index_follow(li, LOG_FILE, &first_changed));
+
+	assert_int_equal(2, line_index_wait(li, -1));
+
+	line_index_free(li);
+	assert_success(unlink(LOG_FILE));
+}
+
+static void
+compare_with_read_file_lines(const char path[])
+{
+	int i, nlines;
+	char **lines;
+	line_index_t *li;
+
+	FILE *const fp = os_fopen(path, "rb");
+	assert_non_null(fp);
+	lines = read_file_lines(fp, &nlines);
+	fclose(fp);
+
+	li = line_index_from_file(path, NULL, NULL);
+	assert_non_null(li);
+
+	assert_int_equal(nlines, line_index_wait(li, -1));
+	for(i = 0; i < nlines; ++i)
+	{
+		assert_string_equal(lines[i], line_index_get(li, i, SIZE_MAX));
+	}
+
+	line_index_free(li);
+	free_string_array(lines, nlines);
+}
+
+static void
+write_file(const char path[], const char mode[], const char contents[])
+{
+	FILE *const fp = fopen(path, mode);
+	assert_non_null(fp);
+	if(fp != NULL)
+	{
+		fputs(contents, fp);
+		fclose(fp);
+	}
+}
+
+/* Counts bytes multiplying them by an optional factor and leaves some of them
+ * to be processed along with the next part of a line. */
+static size_t
+measure(const char text[], size_t len, int last, size_t *width, void *arg)
+{
+	const size_t factor = (arg == NULL) ? 1U : *(const int *)arg;
+	const size_t processed = last ? len : len - MIN(len, 3U);
+	*width += processed*factor;
+	return processed;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
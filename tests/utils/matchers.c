@@ -0,0 +1,121 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/macros.h"
+#include "../../src/utils/matcher.h"
+#include "../../src/utils/matchers.h"
+
+static int find_linearly(const char path[]);
+
+static const char *exprs[] = {
+	"{*.tar.gz,Makefile}",
+	"/^\\.git/",
+	"{*.c,*.h}",
+	"{README*}",
+	"{*.gz}",
+	"{*.C,.bashrc}",
+	"{*.[ch]pp}",
+	"{{/tmp/*}}",
+	"{*.}",
+};
+
+static matcher_t *matchers[ARRAY_LEN(exprs)];
+static matchers_t *ms;
+
+SETUP()
+{
+	size_t i;
+
+	ms = matchers_alloc();
+	assert_non_null(ms);
+
+	for(i = 0U; i < ARRAY_LEN(exprs); ++i)
+	{
+		char *error;
+		matchers[i] = matcher_alloc(exprs[i], 0, 1, &error);
+		assert_non_null(matchers[i]);
+		free(error);
+		assert_success(matchers_add(ms, matchers[i]));
+	}
+}
+
+TEARDOWN()
+{
+	size_t i;
+
+	matchers_free(ms);
+	for(i = 0U; i < ARRAY_LEN(exprs); ++i)
+	{
+		matcher_free(matchers[i]);
+	}
+}
+
+TEST(empty_list_matches_nothing)
+{
+	matchers_t *const empty = matchers_alloc();
+	assert_int_equal(-1, matchers_find(empty, "file.c", 0));
+	matchers_free(empty);
+}
+
+TEST(first_matching_matcher_is_found)
+{
+	assert_int_equal(0, matchers_find(ms, "a.tar.gz", 0));
+	assert_int_equal(4, matchers_find(ms, "a.gz", 0));
+	assert_int_equal(2, matchers_find(ms, "/path/file.c", 0));
+	assert_int_equal(0, matchers_find(ms, "makefile", 0));
+	assert_int_equal(1, matchers_find(ms, ".gitignore", 0));
+	assert_int_equal(5, matchers_find(ms, ".bashrc", 0));
+	assert_int_equal(6, matchers_find(ms, "x.cpp", 0));
+	assert_int_equal(8, matchers_find(ms, "name.", 0));
+	assert_int_equal(-1, matchers_find(ms, "name", 0));
+}
+
+TEST(search_can_start_from_any_matcher)
+{
+	assert_int_equal(4, matchers_find(ms, "a.tar.gz", 1));
+	assert_int_equal(-1, matchers_find(ms, "a.tar.gz", 5));
+	assert_int_equal(3, matchers_find(ms, "README.c", 3));
+	assert_int_equal(5, matchers_find(ms, "README.c", 4));
+	assert_int_equal(7, matchers_find(ms, "/tmp/file.c", 6));
+}
+
+TEST(extensions_do_not_match_dot_files)
+{
+	assert_int_equal(-1, matchers_find(ms, ".c", 0));
+	assert_int_equal(-1, matchers_find(ms, ".x.c", 0));
+	assert_int_equal(-1, matchers_find(ms, ".tar.gz", 0));
+}
+
+TEST(results_are_the_same_as_of_matchers_in_order)
+{
+	static const char *paths[] = {
+		"a.tar.gz", "A.TAR.GZ", "a.gz", "file.c", "FILE.H", "file.hpp",
+		"Makefile", "makefile.c", "README", "README.c", "readme.md", ".git",
+		".gitignore", ".bashrc", ".BASHRC", "x.C", ".c", "..c", "c", "name.",
+		"/tmp/file.c", "/tmp/x", "/dir/tmp/x", "a.b.c.d", "",
+	};
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(paths); ++i)
+	{
+		assert_int_equal(find_linearly(paths[i]), matchers_find(ms, paths[i], 0));
+	}
+}
+
+static int
+find_linearly(const char path[])
+{
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(exprs); ++i)
+	{
+		if(matcher_matches(matchers[i], path))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,83 @@
+#include <stic.h>
+
+#include <pthread.h> /* pthread_create() pthread_join() pthread_t */
+#include <regex.h> /* REG_EXTENDED REG_ICASE regex_t regexec() */
+
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/regex_set.h"
+
+static void * get_in_thread(void *arg);
+
+static regex_set_t *set;
+
+SETUP()
+{
+	set = regex_set_alloc();
+	assert_non_null(set);
+}
+
+TEARDOWN()
+{
+	regex_set_free(set);
+}
+
+TEST(patterns_are_indexed_in_order_of_addition)
+{
+	char *error = NULL;
+	regex_t *regexes;
+
+	assert_int_equal(0, regex_set_count(set));
+	assert_int_equal(0, regex_set_add(set, "^a", REG_EXTENDED, &error));
+	assert_int_equal(1, regex_set_add(set, "b$", REG_EXTENDED | REG_ICASE,
+				&error));
+	assert_int_equal(2, regex_set_count(set));
+	assert_null(error);
+
+	regexes = regex_set_get(set);
+	assert_non_null(regexes);
+	assert_success(regexec(&regexes[0], "ab", 0, NULL, 0));
+	assert_failure(regexec(&regexes[0], "ba", 0, NULL, 0));
+	assert_success(regexec(&regexes[1], "aB", 0, NULL, 0));
+	assert_failure(regexec(&regexes[1], "ba", 0, NULL, 0));
+}
+
+TEST(invalid_pattern_is_rejected)
+{
+	char *error = NULL;
+
+	assert_int_equal(-1, regex_set_add(set, "(", REG_EXTENDED, &error));
+	assert_non_null(error);
+	assert_int_equal(0, regex_set_count(set));
+
+	free(error);
+}
+
+TEST(every_thread_gets_its_own_copy)
+{
+	char *error = NULL;
+	pthread_t thread;
+	void *other;
+	regex_t *regexes;
+
+	assert_int_equal(0, regex_set_add(set, "a", REG_EXTENDED, &error));
+
+	regexes = regex_set_get(set);
+	assert_non_null(regexes);
+	assert_true(regex_set_get(set) == regexes);
+
+	assert_success(pthread_create(&thread, NULL, &get_in_thread, NULL));
+	assert_success(pthread_join(thread, &other));
+	assert_non_null(other);
+	assert_false(other == regexes);
+}
+
+/* Retrieves compiled expressions in a separate thread.  Returns them. */
+static void *
+get_in_thread(void *arg)
+{
+	return regex_set_get(set);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
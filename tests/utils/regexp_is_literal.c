@@ -0,0 +1,33 @@
+#include <stic.h>
+
+#include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
+
+TEST(plain_strings_are_literals)
+{
+	assert_true(regexp_is_literal(""));
+	assert_true(regexp_is_literal("abc"));
+	assert_true(regexp_is_literal("a b-c_d/e"));
+}
+
+TEST(special_characters_are_detected)
+{
+	assert_false(regexp_is_literal("a.c"));
+	assert_false(regexp_is_literal("a*"));
+	assert_false(regexp_is_literal("[ab]"));
+	assert_false(regexp_is_literal("^a"));
+	assert_false(regexp_is_literal("a$"));
+	assert_false(regexp_is_literal("a|b"));
+	assert_false(regexp_is_literal("a\\b"));
+}
+
+TEST(ascii_strings_are_recognized)
+{
+	assert_true(is_ascii(""));
+	assert_true(is_ascii("abc ABC 123"));
+	assert_false(is_ascii("абв"));
+	assert_false(is_ascii("abcä"));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
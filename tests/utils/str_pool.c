@@ -0,0 +1,81 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() strcmp() */
+
+#include "../../src/utils/str_pool.h"
+
+TEST(strings_are_copied)
+{
+	str_pool_t *const pool = str_pool_create();
+	char *const a = str_pool_dup(pool, "first");
+	char *const b = str_pool_dup(pool, "");
+
+	assert_string_equal("first", a);
+	assert_string_equal("", b);
+
+	str_pool_release(a);
+	str_pool_release(b);
+	str_pool_free(pool);
+}
+
+TEST(strings_outlive_pool)
+{
+	str_pool_t *const pool = str_pool_create();
+	char *const str = str_pool_dup(pool, "string");
+
+	str_pool_free(pool);
+	assert_string_equal("string", str);
+
+	str_pool_release(str);
+}
+
+TEST(long_strings_are_stored)
+{
+	static char buf[128*1024];
+	str_pool_t *const pool = str_pool_create();
+	char *str;
+
+	memset(buf, 'x', sizeof(buf) - 1U);
+	buf[sizeof(buf) - 1U] = '\0';
+
+	str = str_pool_dup(pool, buf);
+	assert_int_equal(0, strcmp(buf, str));
+
+	str_pool_release(str);
+	str_pool_free(pool);
+}
+
+TEST(many_strings_span_several_chunks)
+{
+	static char *strs[20000];
+	str_pool_t *const pool = str_pool_create();
+	int i;
+
+	for(i = 0; i < (int)(sizeof(strs)/sizeof(strs[0])); ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "name%d", i);
+		strs[i] = str_pool_dup(pool, name);
+	}
+
+	for(i = 0; i < (int)(sizeof(strs)/sizeof(strs[0])); ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "name%d", i);
+		assert_string_equal(name, strs[i]);
+		str_pool_release(strs[i]);
+	}
+
+	str_pool_free(pool);
+}
+
+TEST(null_is_ignored)
+{
+	str_pool_release(NULL);
+	str_pool_free(NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
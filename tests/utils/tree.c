@@ -0,0 +1,89 @@
+#include <stic.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/tree.h"
+
+#include "utils.h"
+
+#define NDIRS 300
+
+static tree_t tree;
+
+SETUP()
+{
+	create_test_dirs(NDIRS);
+}
+
+TEARDOWN()
+{
+	tree_free(tree);
+	tree = NULL_TREE;
+
+	remove_test_dirs(NDIRS);
+}
+
+TEST(empty_tree_has_no_data)
+{
+	tree_val_t data = 10;
+
+	tree = tree_create(0, 0);
+	assert_failure(tree_get_data(tree, SANDBOX_PATH, &data));
+	assert_int_equal(10, data);
+}
+
+TEST(data_is_stored_per_path)
+{
+	tree_val_t data;
+
+	tree = tree_create(0, 0);
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/0", 1));
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/10", 2));
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/10", 3));
+
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/0", &data));
+	assert_int_equal(1, data);
+	assert_success(tree_get_data(tree, SANDBOX_PATH "//10/", &data));
+	assert_int_equal(3, data);
+	assert_failure(tree_get_data(tree, SANDBOX_PATH "/20", &data));
+	assert_failure(tree_get_data(tree, SANDBOX_PATH, &data));
+}
+
+TEST(longest_tree_returns_data_of_closest_parent)
+{
+	tree_val_t data;
+
+	tree = tree_create(1, 0);
+	assert_success(tree_set_data(tree, SANDBOX_PATH, 1));
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/0", 2));
+
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/0/1", &data));
+	assert_int_equal(2, data);
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/10/11", &data));
+	assert_int_equal(1, data);
+}
+
+TEST(many_paths_are_stored)
+{
+	int i;
+
+	tree = tree_create(0, 0);
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		make_test_dir_path(path, sizeof(path), i);
+		assert_success(tree_set_data(tree, path, i));
+	}
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		tree_val_t data;
+		make_test_dir_path(path, sizeof(path), i);
+		assert_success(tree_get_data(tree, path, &data));
+		assert_int_equal(i, data);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
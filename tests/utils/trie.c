@@ -1,6 +1,7 @@
 #include <stic.h>
 
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
 
 #include "../../src/utils/trie.h"
 
@@ -127,5 +128,31 @@ TEST(set_overwrites_previous_data)
 	trie_free(trie);
 }
 
+TEST(many_strings_are_stored)
+{
+	enum { NSTRINGS = 10000 };
+	const trie_t trie = trie_create();
+	char str[64];
+	void *data;
+	int i;
+
+	for(i = 0; i < NSTRINGS; ++i)
+	{
+		snprintf(str, sizeof(str), "/some/path/dir%d/file%d", i%100, i);
+		assert_int_equal(0, trie_set(trie, str, &str[i%sizeof(str)]));
+	}
+
+	for(i = 0; i < NSTRINGS; ++i)
+	{
+		snprintf(str, sizeof(str), "/some/path/dir%d/file%d", i%100, i);
+		assert_success(trie_get(trie, str, &data));
+		assert_true(data == &str[i%sizeof(str)]);
+	}
+
+	assert_failure(trie_get(trie, "/some/path/dir0/file1", &data));
+
+	trie_free(trie);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
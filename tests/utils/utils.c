@@ -0,0 +1,50 @@
+#include "utils.h"
+
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() */
+
+#include <stdio.h> /* snprintf() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+
+void
+make_test_dir_path(char buf[], size_t len, int i)
+{
+	if(i%10 == 0)
+	{
+		snprintf(buf, len, "%s/%d", SANDBOX_PATH, i);
+	}
+	else
+	{
+		snprintf(buf, len, "%s/%d/%d", SANDBOX_PATH, i - i%10, i);
+	}
+}
+
+void
+create_test_dirs(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char path[PATH_MAX];
+		make_test_dir_path(path, sizeof(path), i);
+		assert_success(os_mkdir(path, 0700));
+	}
+}
+
+void
+remove_test_dirs(int count)
+{
+	int i;
+	for(i = count - 1; i >= 0; --i)
+	{
+		char path[PATH_MAX];
+		make_test_dir_path(path, sizeof(path), i);
+		assert_success(rmdir(path));
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
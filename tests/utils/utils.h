@@ -0,0 +1,20 @@
+#ifndef VIFM_TESTS__UTILS__UTILS_H__
+#define VIFM_TESTS__UTILS__UTILS_H__
+
+#include <stddef.h> /* size_t */
+
+/* Makes path to i-th directory of test tree in sandbox.  Directories are
+ * grouped by ten under top-level ones, so that there are subtrees and
+ * directories whose sizes depend on their children. */
+void make_test_dir_path(char buf[], size_t len, int i);
+
+/* Creates first count directories of test tree. */
+void create_test_dirs(int count);
+
+/* Removes first count directories of test tree, which must be empty. */
+void remove_test_dirs(int count);
+
+#endif /* VIFM_TESTS__UTILS__UTILS_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */